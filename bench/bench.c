@@ -0,0 +1,721 @@
+#ifdef _WIN32
+#include <io.h>
+#include <intrin.h>
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "main.h"
+#include "rge_fio.h"
+#include "compress.h"
+#include "batch.h"
+#include "thread.h"
+#include "cpu.h"
+
+#define USAGE \
+"usage: rge_fio_bench [options] <file or dir> [file or dir ...]\n" \
+"       rge_fio_bench [options] --windows <file> [window size ...]\n\n" \
+"the first runs every deflate setting and inflate on the files (every file directly in a dir) in memory and reports\n" \
+"MB/s of uncompressed data, ratio, cycles per byte and peak RSS of each, the median of all iterations after the warm-up ones,\n" \
+"the second deflates <file> into a temporary file and inflates it again through rge_fio at every window size (default 4 KiB to 16 MiB)\n\n" \
+"options:\n" \
+"  --iterations=<n>       timed runs per setting (default 5)\n" \
+"  --warmup=<n>           untimed runs before those (default 1)\n" \
+"  --game=<n>:<s>:<p>     game deflate setting to run instead of the default ones, max compares, all/dynamic/static and greedy/lazy,\n" \
+"                         can be given more than once\n" \
+"  --best                 run the optimal parse deflate as well, it's slow\n" \
+"  --window=<n>           window the deflate algos write into (default 65536)\n" \
+"  --cpu=<level>          newest instructions the deflate kernels use, generic, sse2, avx2 or avx512 (default the best the cpu has)\n" \
+"  --json                 print the results as json instead of a table\n" \
+"  --tmp=<file>           temporary compressed file of --windows (default rge_fio_bench.tmp)\n\n"
+
+#define MAX_CASES 32
+#define MAX_WINDOWS 16
+
+#define BENCH_DEFLATE 0
+#define BENCH_INFLATE 1
+
+typedef struct bench_case bench_case;
+
+struct bench_case
+{
+	char name[64];
+	int32 kind;
+	int32 backend;
+	deflate_params params;
+};
+
+typedef struct bench_file bench_file;
+
+struct bench_file
+{
+	char *filename;
+	byte *data;
+	size_t size;
+	byte *compressed; // game deflate with the default settings, what the inflate cases decode
+	size_t compressed_size;
+};
+
+typedef struct bench_result bench_result;
+
+struct bench_result
+{
+	size_t size; // uncompressed bytes of one iteration
+	size_t compressed_size;
+	uint64 best_ns;
+	uint64 median_ns;
+	uint64 median_cycles; // 0 where there's no cycle counter
+	size_t peak_rss; // bytes, only this case's on Linux, the process' so far elsewhere
+	bool32 error;
+};
+
+local char *strategy_names[] = { "static", "dynamic", "all" }; // indexed by DEFLATE_*_BLOCKS
+
+// the game's own setting first, then faster and slower ones around it
+local deflate_params default_game_params[] =
+{
+	{ DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_ALL_BLOCKS, TRUE },
+	{ 1, DEFLATE_ALL_BLOCKS, TRUE },
+	{ 15, DEFLATE_ALL_BLOCKS, TRUE },
+	{ 500, DEFLATE_ALL_BLOCKS, TRUE },
+	{ DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_ALL_BLOCKS, FALSE },
+	{ DEFLATE_MAX_COMPARE, DEFLATE_ALL_BLOCKS, FALSE },
+	{ DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_DYNAMIC_BLOCKS, TRUE },
+	{ DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_STATIC_BLOCKS, TRUE },
+};
+
+local int32 default_windows[] = { 0x1000, 0x4000, 0x10000, 0x40000, 0x100000, 0x400000, 0x1000000 };
+
+// output of the deflate algos, the flush callback doesn't get a pointer of its own
+local byte *out_data = NULL;
+local size_t out_size = 0;
+local size_t out_alloc = 0;
+
+local byte *read_file(char *filename, size_t *size)
+{
+	FILE *in = rge_fopen(filename, "rb");
+
+	if (!in) return NULL;
+
+	fseek(in, 0, SEEK_END);
+	*size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	byte *data = malloc(max(1, *size));
+
+	if (data) fread(data, *size, 1, in);
+
+	rge_fclose(in);
+
+	return data;
+}
+
+local uint64 bench_cycles()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// the peak so far only goes down again on Linux, by writing 5 to clear_refs
+local void bench_reset_peak_rss()
+{
+#ifdef __linux__
+	FILE *f = rge_fopen("/proc/self/clear_refs", "w");
+
+	if (f) fputs("5", f);
+
+	rge_fclose(f);
+#endif
+}
+
+local size_t bench_peak_rss()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize;
+
+	return 0;
+#elif defined(__linux__)
+	FILE *f = rge_fopen("/proc/self/status", "r");
+	char line[256];
+	size_t peak = 0;
+
+	while (f && fgets(line, sizeof(line), f))
+	{
+		if (!strncmp(line, "VmHWM:", 6)) peak = (size_t)strtoull(line + 6, NULL, 10) * 1024;
+	}
+
+	rge_fclose(f);
+
+	return peak;
+#else
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+local int32 bench_flush(byte *data, int32 size)
+{
+	if (out_size + size > out_alloc)
+	{
+		out_alloc = max(out_alloc * 2, out_size + size);
+		out_data = realloc(out_data, out_alloc);
+
+		if (!out_data) return TRUE;
+	}
+
+	memcpy(out_data + out_size, data, size);
+	out_size += size;
+
+	return FALSE;
+}
+
+// same calls as rge_write and rge_close make, compressed size or 0 if it failed
+local size_t bench_deflate(deflate_backend *backend, void *work, deflate_params *params, byte *window, int32 window_size, byte *data, size_t size)
+{
+	int32 code;
+
+	out_size = 0;
+
+	memzero(work, backend->buf_size());
+	backend->init(work, params->max_compares, params->strategy, params->greedy_flag, window, window_size, bench_flush);
+
+	code = backend->data(work, data, (int32)size, FALSE);
+
+	if (code != DEFLATE_ERROR) code = backend->data(work, NULL, 0, TRUE);
+
+	backend->deinit(work);
+
+	return code == DEFLATE_ERROR ? 0 : out_size;
+}
+
+// same as rge_read_full, FALSE if it failed or the output differs
+local bool32 bench_inflate(inflate_backend *backend, void *work, bench_file *file, byte *out, bool32 check)
+{
+	size_t in_size = file->compressed_size;
+	size_t size = file->size;
+
+	memzero(work, backend->buf_size());
+
+	int32 code = backend->decode_full(file->compressed, &in_size, out, 0, &size, work);
+
+	backend->deinit(work);
+
+	if (code != INFLATE_EOF) return FALSE;
+
+	return size == file->size && (!check || !memcmp(out, file->data, size));
+}
+
+local int bench_compare_ns(const void *a, const void *b)
+{
+	uint64 ns_a = *(uint64 *)a;
+	uint64 ns_b = *(uint64 *)b;
+
+	return (ns_a > ns_b) - (ns_a < ns_b);
+}
+
+local void bench_run_case(bench_case *bench, bench_file *files, int32 num_files, int32 num_warmup, int32 num_iterations, int32 window_size, bench_result *result)
+{
+	deflate_backend *deflater = bench->kind == BENCH_DEFLATE ? deflate_get_backend(bench->backend) : NULL;
+	inflate_backend *inflater = bench->kind == BENCH_INFLATE ? inflate_get_backend(bench->backend) : NULL;
+	void *work = malloc(deflater ? deflater->buf_size() : inflater->buf_size());
+	byte *window = malloc(window_size);
+	size_t max_size = 0;
+
+	memzero(result, sizeof(bench_result));
+
+	for (int32 i = 0; i < num_files; i++)
+	{
+		result->size += files[i].size;
+
+		max_size = max(max_size, files[i].size);
+	}
+
+	byte *out = inflater ? malloc(max_size + INFLATE_FULL_SLACK) : NULL;
+	uint64 *ns = calloc(num_iterations, sizeof(uint64));
+	uint64 *cycles = calloc(num_iterations, sizeof(uint64));
+
+	bench_reset_peak_rss();
+
+	for (int32 i = -num_warmup; i < num_iterations && !result->error; i++)
+	{
+		size_t compressed_size = 0;
+		uint64 start_ns = rge_time_ns();
+		uint64 start_cycles = bench_cycles();
+
+		for (int32 j = 0; j < num_files && !result->error; j++)
+		{
+			if (deflater)
+			{
+				size_t size = bench_deflate(deflater, work, &bench->params, window, window_size, files[j].data, files[j].size);
+
+				if (!size) result->error = TRUE;
+
+				compressed_size += size;
+			}
+			else
+			{
+				// the first run checks the output, the timed ones don't pay for it
+				if (!bench_inflate(inflater, work, &files[j], out, i == -num_warmup)) result->error = TRUE;
+
+				compressed_size += files[j].compressed_size;
+			}
+		}
+
+		if (i < 0) continue;
+
+		cycles[i] = bench_cycles() - start_cycles;
+		ns[i] = rge_time_ns() - start_ns;
+
+		result->compressed_size = compressed_size;
+	}
+
+	result->peak_rss = bench_peak_rss();
+
+	if (!result->error)
+	{
+		qsort(ns, num_iterations, sizeof(uint64), bench_compare_ns);
+		qsort(cycles, num_iterations, sizeof(uint64), bench_compare_ns);
+
+		result->best_ns = ns[0];
+		result->median_ns = ns[num_iterations / 2];
+		result->median_cycles = cycles[num_iterations / 2];
+	}
+
+	rge_free(cycles);
+	rge_free(ns);
+	rge_free(out);
+	rge_free(window);
+	rge_free(work);
+}
+
+local double bench_mb_per_s(size_t size, uint64 ns)
+{
+	return ns ? size / 1e6 / (ns / 1e9) : 0;
+}
+
+local bool32 bench_add_file(bench_file **files, int32 *num_files, char *filename)
+{
+	bench_file *new_files = realloc(*files, (*num_files + 1) * sizeof(bench_file));
+
+	if (!new_files) return FALSE;
+
+	*files = new_files;
+
+	bench_file *file = &new_files[*num_files];
+
+	memzero(file, sizeof(bench_file));
+
+	file->filename = filename;
+	file->data = read_file(filename, &file->size);
+
+	if (!file->data)
+	{
+		printf("error: couldn't read %s\n", filename);
+
+		return FALSE;
+	}
+
+	(*num_files)++;
+
+	return TRUE;
+}
+
+// every regular file directly in a dir, through the same listing b uses
+local bool32 bench_add_path(bench_file **files, int32 *num_files, char *path)
+{
+	struct _stat st;
+
+	if (_stat(path, &st) || (st.st_mode & _S_IFMT) != _S_IFDIR) return bench_add_file(files, num_files, path);
+
+	batch_job *jobs;
+	int32 num_jobs = batch_find_files('w', path, "*", path, 0, -1, &jobs);
+
+	if (num_jobs < 0) return FALSE;
+
+	bool32 ok = TRUE;
+
+	for (int32 i = 0; i < num_jobs && ok; i++)
+	{
+		ok = bench_add_file(files, num_files, jobs[i].in_filename);
+
+		jobs[i].in_filename = NULL; // the file keeps it
+	}
+
+	batch_free_jobs(jobs, num_jobs);
+
+	return ok;
+}
+
+// nanoseconds of one complete rge_write into a new file, 0 if it failed
+local uint64 bench_write_file(char *filename, byte *data, size_t size, int32 deflate_flag, int32 window_size)
+{
+	uint64 start = rge_time_ns();
+	handle h = rge_open_write(filename, _O_WRONLY | _O_APPEND | _O_CREAT | _O_TRUNC | _O_BINARY | deflate_flag, _S_IREAD | _S_IWRITE);
+
+	if (h == INVALID_HANDLE) return 0;
+
+	rge_set_window_size(h, window_size);
+
+	rge_write_error = FALSE;
+
+	rge_write(h, data, (int32)size);
+
+	if (rge_close(h) || rge_write_error) return 0;
+
+	return rge_time_ns() - start;
+}
+
+// nanoseconds of reading the file back in pieces of the window size, 0 if it failed
+local uint64 bench_read_file(char *filename, byte *out, size_t size, int32 window_size)
+{
+	uint64 start = rge_time_ns();
+	handle h = rge_open_read(filename, _O_BINARY);
+
+	if (h == INVALID_HANDLE) return 0;
+
+	rge_set_window_size(h, window_size);
+
+	rge_read_error = FALSE;
+
+	size_t total = 0;
+
+	for (int32 num_read; (num_read = rge_read_chunk(h, out + total, (int32)min(size - total + 1, (size_t)window_size))) > 0; total += num_read);
+
+	rge_close(h);
+
+	if (rge_read_error || total != size) return 0;
+
+	return rge_time_ns() - start;
+}
+
+local int32 bench_windows(bench_file *file, int32 *windows, int32 num_windows, int32 num_iterations, char *tmp_filename)
+{
+	byte *out = malloc(file->size + 1);
+
+	printf("%s, %zu bytes, best of %d\n\n", file->filename, file->size, num_iterations);
+	printf("window     w game MB/s   w fast MB/s   r MB/s\n");
+
+	for (int32 i = 0; i < num_windows; i++)
+	{
+		uint64 best[3] = ZEROMEM;
+
+		// game deflate last, so the file that's read back is what the game writes
+		for (int32 j = 0; j < num_iterations; j++)
+		{
+			uint64 fast_ns = bench_write_file(tmp_filename, file->data, file->size, RGE_O_DEFLATE_FAST, windows[i]);
+			uint64 game_ns = bench_write_file(tmp_filename, file->data, file->size, RGE_O_DEFLATE_GAME, windows[i]);
+
+			if (!game_ns || !fast_ns)
+			{
+				printf("error: couldn't write %s\n", tmp_filename);
+
+				return 1;
+			}
+
+			if (!best[0] || game_ns < best[0]) best[0] = game_ns;
+			if (!best[1] || fast_ns < best[1]) best[1] = fast_ns;
+		}
+
+		for (int32 j = 0; j < num_iterations; j++)
+		{
+			uint64 read_ns = bench_read_file(tmp_filename, out, file->size, windows[i]);
+
+			if (!read_ns)
+			{
+				printf("error: couldn't read %s back\n", tmp_filename);
+
+				return 1;
+			}
+
+			if (!best[2] || read_ns < best[2]) best[2] = read_ns;
+		}
+
+		printf("%-10d %11.1f %13.1f %8.1f\n", windows[i], bench_mb_per_s(file->size, best[0]), bench_mb_per_s(file->size, best[1]), bench_mb_per_s(file->size, best[2]));
+	}
+
+	remove(tmp_filename);
+
+	rge_free(out);
+
+	return 0;
+}
+
+local void bench_add_case(bench_case *cases, int32 *num_cases, int32 kind, int32 backend, deflate_params *params)
+{
+	bench_case *bench = &cases[(*num_cases)++];
+
+	memzero(bench, sizeof(bench_case));
+
+	bench->kind = kind;
+	bench->backend = backend;
+
+	if (params) bench->params = *params;
+
+	if (kind == BENCH_INFLATE) sprintf(bench->name, "inflate %s", inflate_get_backend(backend)->name);
+	else if (backend == DEFLATE_BACKEND_GAME) sprintf(bench->name, "deflate game %d %s %s", params->max_compares, strategy_names[params->strategy], params->greedy_flag ? "greedy" : "lazy");
+	else sprintf(bench->name, "deflate %s", deflate_get_backend(backend)->name);
+}
+
+// <max compares>:<strategy>:<greedy|lazy>
+local bool32 bench_parse_game(char *arg, deflate_params *params)
+{
+	char strategy[16];
+	char parse[16];
+
+	if (sscanf(arg, "%d:%15[a-z]:%15[a-z]", &params->max_compares, strategy, parse) != 3) return FALSE;
+
+	params->max_compares = min(max(params->max_compares, DEFLATE_MIN_COMPARE), DEFLATE_MAX_COMPARE);
+	params->strategy = -1;
+
+	for (int32 i = 0; i < 3; i++)
+	{
+		if (!strcmp(strategy, strategy_names[i])) params->strategy = i;
+	}
+
+	if (params->strategy < 0 || (strcmp(parse, "greedy") && strcmp(parse, "lazy"))) return FALSE;
+
+	params->greedy_flag = !strcmp(parse, "greedy");
+
+	return TRUE;
+}
+
+int32 main(int32 argc, char **argv)
+{
+	int32 num_iterations = 5;
+	int32 num_warmup = 1;
+	int32 window_size = RGE_WINDOW_SIZE_DEFAULT;
+	bool32 json = FALSE;
+	bool32 run_best = FALSE;
+	bool32 run_windows = FALSE;
+	char *tmp_filename = "rge_fio_bench.tmp";
+	deflate_params game_params[MAX_CASES];
+	int32 num_game_params = 0;
+	char **paths = calloc(argc, sizeof(char *));
+	int32 num_paths = 0;
+
+	for (int32 i = 1; i < argc; i++)
+	{
+		if (!strncmp(argv[i], "--iterations=", 13))
+		{
+			num_iterations = max(1, atoi(argv[i] + 13));
+		}
+		else if (!strncmp(argv[i], "--warmup=", 9))
+		{
+			num_warmup = max(0, atoi(argv[i] + 9));
+		}
+		else if (!strncmp(argv[i], "--game=", 7) && num_game_params < MAX_CASES - 4)
+		{
+			if (!bench_parse_game(argv[i] + 7, &game_params[num_game_params++]))
+			{
+				printf("error: invalid game deflate setting %s\n\n", argv[i] + 7);
+				printf(USAGE);
+
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--best"))
+		{
+			run_best = TRUE;
+		}
+		else if (!strncmp(argv[i], "--window=", 9))
+		{
+			window_size = min(max(atoi(argv[i] + 9), RGE_WINDOW_SIZE_MIN), RGE_WINDOW_SIZE_MAX);
+		}
+		else if (!strcmp(argv[i], "--json"))
+		{
+			json = TRUE;
+		}
+		else if (!strncmp(argv[i], "--cpu=", 6) && cpu_find_level(argv[i] + 6) != CPU_LEVEL_INVALID)
+		{
+			cpu_set_level(cpu_find_level(argv[i] + 6));
+		}
+		else if (!strcmp(argv[i], "--windows"))
+		{
+			run_windows = TRUE;
+		}
+		else if (!strncmp(argv[i], "--tmp=", 6))
+		{
+			tmp_filename = argv[i] + 6;
+		}
+		else if (!strncmp(argv[i], "--", 2))
+		{
+			printf("error: unknown option %s\n\n", argv[i]);
+			printf(USAGE);
+
+			return 1;
+		}
+		else
+		{
+			paths[num_paths++] = argv[i];
+		}
+	}
+
+	if (!num_paths)
+	{
+		printf(USAGE);
+
+		return 1;
+	}
+
+	bench_file *files = NULL;
+	int32 num_files = 0;
+
+	if (run_windows)
+	{
+		int32 windows[MAX_WINDOWS];
+		int32 num_windows = 0;
+
+		for (int32 i = 1; i < num_paths && num_windows < MAX_WINDOWS; i++)
+		{
+			windows[num_windows++] = min(max(atoi(paths[i]), RGE_WINDOW_SIZE_MIN), RGE_WINDOW_SIZE_MAX);
+		}
+
+		if (!num_windows)
+		{
+			num_windows = sizeof(default_windows) / sizeof(default_windows[0]);
+
+			memcpy(windows, default_windows, sizeof(default_windows));
+		}
+
+		if (!bench_add_file(&files, &num_files, paths[0])) return 1;
+
+		int32 code = bench_windows(&files[0], windows, num_windows, num_iterations, tmp_filename);
+
+		rge_free(files[0].data);
+		rge_free(files);
+
+		rge_free_thread_buffers();
+
+		return code;
+	}
+
+	for (int32 i = 0; i < num_paths; i++)
+	{
+		if (!bench_add_path(&files, &num_files, paths[i])) return 1;
+	}
+
+	if (!num_files)
+	{
+		printf("error: no files to run on\n");
+
+		return 1;
+	}
+
+	// what the inflate cases decode
+	deflate_backend *game = deflate_get_backend(DEFLATE_BACKEND_GAME);
+	deflate_params defaults = { DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_ALL_BLOCKS, TRUE };
+	void *work = malloc(game->buf_size());
+	byte *window = malloc(window_size);
+
+	for (int32 i = 0; i < num_files; i++)
+	{
+		files[i].compressed_size = bench_deflate(game, work, &defaults, window, window_size, files[i].data, files[i].size);
+		files[i].compressed = malloc(max(1, files[i].compressed_size));
+
+		memcpy(files[i].compressed, out_data, files[i].compressed_size);
+	}
+
+	rge_free(window);
+	rge_free(work);
+
+	bench_case cases[MAX_CASES];
+	int32 num_cases = 0;
+
+	if (!num_game_params)
+	{
+		num_game_params = sizeof(default_game_params) / sizeof(default_game_params[0]);
+
+		memcpy(game_params, default_game_params, sizeof(default_game_params));
+	}
+
+	for (int32 i = 0; i < num_game_params; i++)
+	{
+		bench_add_case(cases, &num_cases, BENCH_DEFLATE, DEFLATE_BACKEND_GAME, &game_params[i]);
+	}
+
+	bench_add_case(cases, &num_cases, BENCH_DEFLATE, DEFLATE_BACKEND_ZLIB, &defaults);
+
+	if (run_best) bench_add_case(cases, &num_cases, BENCH_DEFLATE, DEFLATE_BACKEND_BEST, &defaults);
+
+	bench_add_case(cases, &num_cases, BENCH_INFLATE, INFLATE_BACKEND_FAST, NULL);
+	bench_add_case(cases, &num_cases, BENCH_INFLATE, INFLATE_BACKEND_ZLIB, NULL);
+
+	size_t total_size = 0;
+
+	for (int32 i = 0; i < num_files; i++)
+	{
+		total_size += files[i].size;
+	}
+
+	if (json)
+	{
+		printf("{\n  \"files\": %d,\n  \"bytes\": %zu,\n  \"iterations\": %d,\n  \"warmup\": %d,\n  \"window\": %d,\n  \"cpu\": \"%s\",\n  \"results\": [\n", num_files, total_size, num_iterations, num_warmup, window_size, cpu_get_kernels()->name);
+	}
+	else
+	{
+		printf("%d files, %zu bytes, median of %d after %d warm-up, %s kernels\n\n", num_files, total_size, num_iterations, num_warmup, cpu_get_kernels()->name);
+		printf("%-34s %9s %9s %7s %9s %10s\n", "", "MB/s", "best MB/s", "ratio", "cycles/B", "peak RSS K");
+	}
+
+	int32 num_errors = 0;
+
+	for (int32 i = 0; i < num_cases; i++)
+	{
+		bench_result result;
+
+		bench_run_case(&cases[i], files, num_files, num_warmup, num_iterations, window_size, &result);
+
+		double ratio = result.compressed_size ? (double)result.size / result.compressed_size : 0;
+		double cycles_per_byte = result.size ? (double)result.median_cycles / result.size : 0;
+
+		if (result.error) num_errors++;
+
+		if (json)
+		{
+			printf("    { \"name\": \"%s\", \"kind\": \"%s\", \"ok\": %s, \"bytes\": %zu, \"compressed_bytes\": %zu, \"ratio\": %.4f, "
+				"\"mb_per_s\": %.2f, \"best_mb_per_s\": %.2f, \"median_ns\": %llu, \"cycles_per_byte\": %.2f, \"peak_rss\": %zu }%s\n",
+				cases[i].name, cases[i].kind == BENCH_DEFLATE ? "deflate" : "inflate", result.error ? "false" : "true", result.size, result.compressed_size, ratio,
+				bench_mb_per_s(result.size, result.median_ns), bench_mb_per_s(result.size, result.best_ns), (unsigned long long)result.median_ns, cycles_per_byte, result.peak_rss,
+				i < num_cases - 1 ? "," : "");
+		}
+		else if (result.error)
+		{
+			printf("%-34s failed\n", cases[i].name);
+		}
+		else
+		{
+			printf("%-34s %9.1f %9.1f %7.3f %9.1f %10zu\n", cases[i].name, bench_mb_per_s(result.size, result.median_ns), bench_mb_per_s(result.size, result.best_ns), ratio, cycles_per_byte, result.peak_rss / 1024);
+		}
+
+		fflush(stdout);
+	}
+
+	if (json) printf("  ]\n}\n");
+
+	for (int32 i = 0; i < num_files; i++)
+	{
+		rge_free(files[i].compressed);
+		rge_free(files[i].data);
+	}
+
+	rge_free(files);
+	rge_free(out_data);
+	rge_free(paths);
+
+	return num_errors ? 1 : 0;
+}
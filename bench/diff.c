@@ -0,0 +1,883 @@
+#include <sys/stat.h>
+
+#include "main.h"
+#include "compress.h"
+#include "batch.h"
+#include "thread.h"
+#include "cpu.h"
+#include "ref/deflate_ref.h"
+
+#define USAGE \
+"usage: rge_fio_diff [options] [file or dir ...]\n\n" \
+"deflates a generated and fuzzed corpus, and the files given (every file directly in a dir), with the game deflate and with the\n" \
+"frozen reference copy of it in bench/ref at every setting, compares the output byte for byte and inflates it with zlib again,\n" \
+"the game deflate gets its input and writes its output in pieces of random sizes, the reference in the ones rge_fio uses,\n" \
+"then inflates the inputs put together and cut short at several points on threads and in one go, and compares both\n\n" \
+"options:\n" \
+"  --seed=<n>             same seed, same corpus and pieces (default 1)\n" \
+"  --size=<n>             largest generated input in bytes, edge cases included (default 131072)\n" \
+"  --fuzz=<n>             mutated copies of every generated input (default 2)\n" \
+"  --all-compares         every max compares from 1 to 1500 instead of the ones around each code path\n" \
+"  --threads=<n>          (default all cpus)\n" \
+"  --cpu=<level>          newest instructions the game deflate uses, generic, sse2, avx2 or avx512 (default the best the cpu has)\n" \
+"  --save=<dir>           write the inputs that failed there\n\n"
+
+#define DIFF_PIECE_SIZE 0x10000 // what rge_fio feeds and flushes with the default window
+#define DIFF_MAX_PIECE_SIZE 0x12000
+#define DIFF_NUM_EDGE_SIZES (sizeof(edge_sizes) / sizeof(*edge_sizes))
+#define DIFF_CUT_INPUT_SIZE 0x400000 // enough compressed input for Inf32DecodeParallel to split it among its threads
+#define DIFF_CUT_THREADS 4
+#define DIFF_NUM_CUTS 16
+
+typedef struct diff_input diff_input;
+
+struct diff_input
+{
+	char name[MAX_PATH];
+	byte *data;
+	size_t size;
+	byte *dict; // preset dictionary, NULL for most
+	int32 dict_size;
+};
+
+typedef struct diff_buffer diff_buffer;
+
+struct diff_buffer
+{
+	byte *data;
+	size_t size;
+	size_t alloc;
+	bool32 error;
+};
+
+typedef struct diff_queue diff_queue;
+
+struct diff_queue
+{
+	diff_input *inputs;
+	int32 num_inputs;
+	deflate_params *settings;
+	int32 num_settings;
+	uint64 seed;
+	char *save_dir;
+	volatile int32 next_job;
+	volatile int32 num_failed;
+	rge_mutex mutex; // printing and saving
+};
+
+typedef struct diff_worker diff_worker;
+
+struct diff_worker
+{
+	diff_queue *queue;
+	rge_thread thread;
+	void *ref_wd;
+	void *game_wd;
+	void *inflate_wd;
+	byte *pieces;
+	diff_buffer ref_out;
+	diff_buffer game_out;
+	byte *inflated;
+	size_t inflated_alloc;
+};
+
+local char *strategy_names[] = { "static", "dynamic", "all" }; // indexed by DEFLATE_*_BLOCKS
+
+// around the search thresholds, the sector size, the longest match and the window
+local size_t edge_sizes[] = { 0, 1, 2, 3, 4, 5, 257, 258, 259, 260, 4095, 4096, 4097, 4354, 32767, 32768, 32769, 65535, 65536, 65537 };
+
+// flash below 4, then every depth the chains of the corpus still notice, and the game's own
+local int32 default_compares[] = { 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 16, 24, 32, 48, 64, 75, 100, 128, 256, 512, 1024, 1500 };
+
+local char *words[] =
+{
+	"the", "enemy", "castle", "must", "be", "destroyed", "before", "your", "villagers", "gather", "gold", "stone", "wood", "food",
+	"king", "guard", "bridge", "north", "south", "river", "army", "attack", "defend", "town", "center", "wonder", "relic", "monastery",
+};
+
+local thread_local uint64 rng_state = 0; // splitmix64
+local thread_local diff_buffer *current_out = NULL; // the flush callback has no user pointer
+
+local uint64 diff_rand()
+{
+	uint64 z = (rng_state += 0x9E3779B97F4A7C15);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+
+	return z ^ (z >> 31);
+}
+
+local void diff_seed(uint64 seed, uint32 stream)
+{
+	rng_state = seed * 0x100000001B3 + stream;
+}
+
+local size_t diff_range(size_t n)
+{
+	return n ? (size_t)(diff_rand() % n) : 0;
+}
+
+local bool32 diff_put(diff_buffer *buf, byte *data, size_t size)
+{
+	if (buf->size + size > buf->alloc)
+	{
+		size_t alloc = max(buf->alloc * 2, buf->size + size);
+		byte *new_data = realloc(buf->data, max(alloc, 1));
+
+		if (!new_data)
+		{
+			buf->error = TRUE;
+
+			return FALSE;
+		}
+
+		buf->data = new_data;
+		buf->alloc = alloc;
+	}
+
+	memcpy(buf->data + buf->size, data, size);
+	buf->size += size;
+
+	return TRUE;
+}
+
+local int32 diff_flush(byte *out_buf_ofs, int32 out_buf_size)
+{
+	return !diff_put(current_out, out_buf_ofs, out_buf_size);
+}
+
+local void diff_text(byte *data, size_t size)
+{
+	size_t pos = 0;
+
+	while (pos < size)
+	{
+		char *word = words[diff_range(sizeof(words) / sizeof(*words))];
+
+		for (size_t i = 0; word[i] && pos < size; i++) data[pos++] = word[i];
+
+		if (pos < size) data[pos++] = diff_range(12) ? ' ' : '\n';
+	}
+}
+
+// unit like records of 40 bytes, a few flags changing, a running id, padding and a name
+local void diff_records(byte *data, size_t size)
+{
+	char *name = "ArcherVillagerScoutPriest";
+
+	for (size_t pos = 0; pos < size; pos++)
+	{
+		size_t field = pos % 40;
+
+		if (field < 8) data[pos] = (byte)diff_range(4);
+		else if (field < 12) data[pos] = (byte)((pos / 40) >> ((field - 8) * 8));
+		else if (field < 20) data[pos] = 0;
+		else data[pos] = (byte)name[field - 20];
+	}
+}
+
+local void diff_random(byte *data, size_t size)
+{
+	for (size_t pos = 0; pos < size; pos++) data[pos] = (byte)diff_rand();
+}
+
+// a random block repeated at about the window size, some just out of reach
+local void diff_repeats(byte *data, size_t size)
+{
+	size_t period = 0x8000 - 2 + diff_range(5);
+
+	for (size_t pos = 0; pos < size; pos++) data[pos] = pos < period ? (byte)diff_rand() : data[pos - period];
+}
+
+// runs of one byte up to a bit longer than the longest match, and short periods
+local void diff_runs(byte *data, size_t size)
+{
+	size_t pos = 0;
+
+	while (pos < size)
+	{
+		size_t len = 1 + diff_range(600); // min evaluates twice
+
+		len = min(len, size - pos);
+		size_t period = 1 + diff_range(7);
+
+		for (size_t i = 0; i < len; i++, pos++) data[pos] = i < period ? (byte)diff_rand() : data[pos - period];
+	}
+}
+
+// text, records, random and zeros taking turns, so the blocks switch types
+local void diff_mixed(byte *data, size_t size)
+{
+	size_t pos = 0;
+
+	while (pos < size)
+	{
+		size_t len = 1 + diff_range(0x3000);
+
+		len = min(len, size - pos);
+
+		switch (diff_range(4))
+		{
+			case 0: diff_text(data + pos, len); break;
+			case 1: diff_records(data + pos, len); break;
+			case 2: diff_random(data + pos, len); break;
+			default: memzero(data + pos, len); break;
+		}
+
+		pos += len;
+	}
+}
+
+// copies from just below and above the distances the game treats differently, 3 byte matches from 16 KiB on aren't taken
+local void diff_far(byte *data, size_t size)
+{
+	size_t dists[] = { 1, 2, 3, 16383, 16384, 16385, 32767, 32768 };
+
+	diff_random(data, size);
+
+	for (size_t pos = 0; pos < size; pos += 1 + diff_range(64))
+	{
+		size_t dist = dists[diff_range(sizeof(dists) / sizeof(*dists))];
+		size_t len = 3 + diff_range(diff_range(4) ? 2 : 300);
+
+		len = min(len, size - pos);
+
+		if (dist > pos) continue;
+
+		for (size_t i = 0; i < len; i++) data[pos + i] = data[pos + i - dist];
+
+		pos += len;
+	}
+}
+
+local void (*generators[])(byte *, size_t) = { diff_text, diff_records, diff_random, diff_repeats, diff_runs, diff_mixed, diff_far };
+local char *generator_names[] = { "text", "records", "random", "repeats", "runs", "mixed", "far" };
+
+#define DIFF_NUM_GENERATORS (sizeof(generators) / sizeof(*generators))
+
+// flips, fills, copies from somewhere before, deletes and inserts
+local void diff_mutate(diff_input *input)
+{
+	int32 num_edits = 1 + (int32)diff_range(8);
+
+	for (int32 i = 0; i < num_edits && input->size; i++)
+	{
+		size_t pos = diff_range(input->size);
+		size_t len = 1 + diff_range(diff_range(2) ? 8 : 1000);
+
+		len = min(len, input->size - pos);
+
+		switch (diff_range(5))
+		{
+			case 0:
+				input->data[pos] ^= (byte)(1 << diff_range(8));
+				break;
+			case 1:
+				memset(input->data + pos, (byte)diff_rand(), len);
+				break;
+			case 2:
+			{
+				size_t dist = 1 + diff_range(min(pos, 0x8000 + 8) + 1);
+
+				for (size_t j = 0; j < len && dist <= pos; j++) input->data[pos + j] = input->data[pos + j - dist];
+
+				break;
+			}
+			case 3:
+				memmove(input->data + pos, input->data + pos + len, input->size - pos - len);
+				input->size -= len;
+				break;
+			default:
+			{
+				byte *data = realloc(input->data, input->size + len);
+
+				if (!data) break;
+
+				input->data = data;
+
+				memmove(input->data + pos + len, input->data + pos, input->size - pos);
+				diff_random(input->data + pos, len);
+				input->size += len;
+
+				break;
+			}
+		}
+	}
+}
+
+local diff_input *diff_add_input(diff_input **inputs, int32 *num_inputs, size_t size)
+{
+	diff_input *new_inputs = realloc(*inputs, (*num_inputs + 1) * sizeof(diff_input));
+
+	if (!new_inputs) return NULL;
+
+	*inputs = new_inputs;
+
+	diff_input *input = &new_inputs[(*num_inputs)++];
+
+	memzero(input, sizeof(diff_input));
+
+	input->data = malloc(max(size, 1));
+	input->size = size;
+
+	return input->data ? input : NULL;
+}
+
+local bool32 diff_generate(diff_input **inputs, int32 *num_inputs, uint64 seed, size_t max_size, int32 num_fuzz)
+{
+	uint32 stream = 0;
+
+	for (int32 i = 0; i < DIFF_NUM_EDGE_SIZES && edge_sizes[i] <= max_size; i++)
+	{
+		for (int32 j = 0; j < 2; j++)
+		{
+			diff_input *input = diff_add_input(inputs, num_inputs, edge_sizes[i]);
+
+			if (!input) return FALSE;
+
+			diff_seed(seed, stream++);
+			generators[j ? 2 : 0](input->data, input->size);
+
+			snprintf(input->name, sizeof(input->name), "%s_%zu", generator_names[j ? 2 : 0], input->size);
+		}
+	}
+
+	for (int32 i = 0; i < DIFF_NUM_GENERATORS; i++)
+	{
+		diff_seed(seed, stream++);
+
+		size_t size = max_size / 2 + diff_range(max_size / 2 + 1);
+		diff_input *input = diff_add_input(inputs, num_inputs, size);
+
+		if (!input) return FALSE;
+
+		generators[i](input->data, input->size);
+
+		snprintf(input->name, sizeof(input->name), "%s", generator_names[i]);
+
+		int32 source_index = *num_inputs - 1;
+
+		for (int32 j = 0; j < num_fuzz; j++)
+		{
+			diff_input *fuzzed = diff_add_input(inputs, num_inputs, (*inputs)[source_index].size);
+
+			if (!fuzzed) return FALSE;
+
+			diff_input *source = &(*inputs)[source_index]; // after adding, the inputs may have moved
+
+			memcpy(fuzzed->data, source->data, source->size);
+
+			diff_seed(seed, stream++);
+			diff_mutate(fuzzed);
+
+			snprintf(fuzzed->name, sizeof(fuzzed->name), "%s_fuzz%d", generator_names[i], j + 1);
+		}
+	}
+
+	// the same text again with a dictionary of some of it, shorter and longer than the window
+	for (int32 i = 0; i < 2; i++)
+	{
+		diff_seed(seed, stream++);
+
+		size_t dict_size = i ? 0x9000 : 0x1000;
+		diff_input *input = diff_add_input(inputs, num_inputs, max_size / 4);
+
+		if (!input) return FALSE;
+
+		input->dict = malloc(dict_size);
+		input->dict_size = (int32)dict_size;
+
+		if (!input->dict) return FALSE;
+
+		diff_text(input->dict, dict_size);
+		diff_mixed(input->data, input->size);
+
+		// so the dictionary is worth something
+		for (size_t pos = 0; pos + 64 <= input->size; pos += 1024) memcpy(input->data + pos, input->dict + diff_range(dict_size - 64), 64);
+
+		snprintf(input->name, sizeof(input->name), "dict_%zu", dict_size);
+	}
+
+	return TRUE;
+}
+
+local bool32 diff_add_file(diff_input **inputs, int32 *num_inputs, char *filename)
+{
+	FILE *in = rge_fopen(filename, "rb");
+
+	if (!in)
+	{
+		printf("error: couldn't read %s\n", filename);
+
+		return FALSE;
+	}
+
+	fseek(in, 0, SEEK_END);
+	size_t size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	diff_input *input = diff_add_input(inputs, num_inputs, size);
+	bool32 ok = input && (!size || fread(input->data, size, 1, in) == 1);
+
+	rge_fclose(in);
+
+	if (!ok)
+	{
+		printf("error: couldn't read %s\n", filename);
+
+		return FALSE;
+	}
+
+	snprintf(input->name, sizeof(input->name), "%s", filename);
+
+	return TRUE;
+}
+
+// every regular file directly in a dir, through the same listing b uses
+local bool32 diff_add_path(diff_input **inputs, int32 *num_inputs, char *path)
+{
+	struct _stat st;
+
+	if (_stat(path, &st) || (st.st_mode & _S_IFMT) != _S_IFDIR) return diff_add_file(inputs, num_inputs, path);
+
+	batch_job *jobs;
+	int32 num_jobs = batch_find_files('w', path, "*", path, 0, -1, &jobs);
+
+	if (num_jobs < 0) return FALSE;
+
+	bool32 ok = TRUE;
+
+	for (int32 i = 0; i < num_jobs && ok; i++)
+	{
+		ok = diff_add_file(inputs, num_inputs, jobs[i].in_filename);
+	}
+
+	batch_free_jobs(jobs, num_jobs);
+
+	return ok;
+}
+
+// the reference the way rge_fio drives it, whole windows in and whole buffers out
+local bool32 diff_deflate_ref(diff_worker *worker, diff_input *input, deflate_params *params)
+{
+	worker->ref_out.size = 0;
+	current_out = &worker->ref_out;
+
+	memzero(worker->ref_wd, ref_deflate_buf_size()); // init leaves the rest as it is, rge_fio zeroes it too
+	ref_deflate_init(worker->ref_wd, params->max_compares, params->strategy, params->greedy_flag, worker->pieces, DIFF_PIECE_SIZE, diff_flush);
+
+	if (input->dict) ref_deflate_set_dictionary(worker->ref_wd, input->dict, input->dict_size);
+
+	bool32 error = FALSE;
+
+	for (size_t pos = 0; pos < input->size && !error; pos += DIFF_PIECE_SIZE)
+	{
+		error = ref_deflate_data(worker->ref_wd, input->data + pos, (int32)min(DIFF_PIECE_SIZE, input->size - pos), FALSE) == DEFLATE_ERROR;
+	}
+
+	if (!error) error = ref_deflate_data(worker->ref_wd, NULL, 0, TRUE) == DEFLATE_ERROR;
+
+	ref_deflate_deinit(worker->ref_wd);
+
+	return !error && !worker->ref_out.error;
+}
+
+// the game deflate through the backend table, input in random pieces down to nothing and a random output buffer size
+local bool32 diff_deflate_game(diff_worker *worker, diff_input *input, deflate_params *params)
+{
+	deflate_backend *game = deflate_get_backend(DEFLATE_BACKEND_GAME);
+
+	worker->game_out.size = 0;
+	current_out = &worker->game_out;
+
+	memzero(worker->game_wd, game->buf_size());
+	game->init(worker->game_wd, params->max_compares, params->strategy, params->greedy_flag, worker->pieces, (int32)(1 + diff_range(DIFF_MAX_PIECE_SIZE)), diff_flush);
+
+	if (input->dict) game->set_dictionary(worker->game_wd, input->dict, input->dict_size);
+
+	bool32 error = FALSE;
+
+	for (size_t pos = 0; pos < input->size && !error;)
+	{
+		size_t size = diff_range(4) ? diff_range(DIFF_MAX_PIECE_SIZE + 1) : diff_range(16);
+
+		size = min(size, input->size - pos);
+
+		error = game->data(worker->game_wd, input->data + pos, (int32)size, FALSE) == DEFLATE_ERROR;
+		pos += size;
+	}
+
+	if (!error) error = game->data(worker->game_wd, NULL, 0, TRUE) == DEFLATE_ERROR;
+
+	game->deinit(worker->game_wd);
+
+	return !error && !worker->game_out.error;
+}
+
+local bool32 diff_inflate(diff_worker *worker, diff_input *input)
+{
+	inflate_backend *zlib = inflate_get_backend(INFLATE_BACKEND_ZLIB);
+	size_t alloc = input->size + INFLATE_FULL_SLACK + 1;
+
+	if (alloc > worker->inflated_alloc)
+	{
+		rge_free(worker->inflated);
+
+		worker->inflated = malloc(alloc);
+		worker->inflated_alloc = worker->inflated ? alloc : 0;
+
+		if (!worker->inflated) return FALSE;
+	}
+
+	memzero(worker->inflate_wd, zlib->buf_size());
+
+	zlib->set_dictionary(worker->inflate_wd, input->dict, input->dict_size);
+
+	size_t in_size = worker->game_out.size;
+	size_t out_size = input->size + 1; // one more, so output that's too long shows
+
+	int32 code = zlib->decode_full(worker->game_out.data, &in_size, worker->inflated, 0, &out_size, worker->inflate_wd);
+
+	zlib->deinit(worker->inflate_wd);
+
+	return code == INFLATE_EOF && out_size == input->size && !memcmp(worker->inflated, input->data, input->size);
+}
+
+local void diff_fail(diff_worker *worker, diff_input *input, deflate_params *params, char *what)
+{
+	diff_queue *queue = worker->queue;
+
+	rge_mutex_lock(&queue->mutex);
+
+	printf("FAIL   %s, max compares %d, %s blocks, %s: %s\n", input->name, params->max_compares, strategy_names[params->strategy], params->greedy_flag ? "greedy" : "lazy", what);
+
+	if (queue->save_dir)
+	{
+		char filename[MAX_PATH];
+		char *name = strrchr(input->name, '/') ? strrchr(input->name, '/') + 1 : input->name;
+
+		snprintf(filename, sizeof(filename), "%s/%s", queue->save_dir, name);
+
+		FILE *out = rge_fopen(filename, "wb");
+
+		if (out) fwrite(input->data, 1, input->size, out);
+
+		rge_fclose(out);
+	}
+
+	queue->num_failed++;
+
+	rge_mutex_unlock(&queue->mutex);
+}
+
+// the parallel decode has to give back what the one in one go does on a cut stream too, the same output up to the error and the same size used
+local bool32 diff_cut(diff_worker *worker, diff_input *input, size_t cut, char *what, size_t what_size)
+{
+	size_t full_in_size = cut;
+	size_t full_out_size = input->size;
+
+	memzero(worker->inflate_wd, Inf32BufSize());
+
+	Inf32SetDictionary(worker->inflate_wd, NULL, 0);
+
+	int32 full_code = Inf32DecodeFull(worker->game_out.data, &full_in_size, worker->inflated, 0, &full_out_size, worker->inflate_wd);
+
+	byte *parallel_out = NULL;
+	size_t parallel_in_size = cut;
+	size_t parallel_out_size = 0;
+
+	int32 parallel_code = Inf32DecodeParallel(worker->game_out.data, &parallel_in_size, &parallel_out, &parallel_out_size, NULL, 0, DIFF_CUT_THREADS);
+
+	bool32 same = parallel_code == full_code && parallel_in_size == full_in_size && parallel_out_size == full_out_size
+		&& (!full_out_size || !memcmp(parallel_out, worker->inflated, full_out_size));
+
+	if (!same)
+	{
+		snprintf(what, what_size, "cut at %zu of %zu bytes, parallel %d, %zu used, %zu out, in one go %d, %zu used, %zu out",
+			cut, worker->game_out.size, parallel_code, parallel_in_size, parallel_out_size, full_code, full_in_size, full_out_size);
+	}
+
+	rge_free(parallel_out);
+
+	return same;
+}
+
+// the inputs one after the other, over again until there's enough of it, deflated once and then cut short
+local void diff_cuts(diff_worker *worker, diff_input *inputs, int32 num_inputs)
+{
+	deflate_params params = { DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_ALL_BLOCKS, FALSE };
+	diff_input input = ZEROMEM;
+	char what[256];
+	int32 num_failed = 0;
+
+	snprintf(input.name, sizeof(input.name), "cut");
+
+	rge_free(worker->inflated);
+
+	input.data = malloc(DIFF_CUT_INPUT_SIZE);
+	worker->inflated = malloc(DIFF_CUT_INPUT_SIZE + INFLATE_FULL_SLACK);
+	worker->inflated_alloc = worker->inflated ? DIFF_CUT_INPUT_SIZE + INFLATE_FULL_SLACK : 0;
+
+	if (!input.data || !worker->inflated)
+	{
+		diff_fail(worker, &input, &params, "out of memory");
+
+		rge_free(input.data);
+
+		return;
+	}
+
+	for (int32 i = 0; input.size < DIFF_CUT_INPUT_SIZE; i = (i + 1) % num_inputs)
+	{
+		size_t size = min(inputs[i].size, DIFF_CUT_INPUT_SIZE - input.size);
+
+		memcpy(input.data + input.size, inputs[i].data, size);
+		input.size += size;
+	}
+
+	if (!diff_deflate_game(worker, &input, &params))
+	{
+		diff_fail(worker, &input, &params, "game deflate failed");
+
+		rge_free(input.data);
+
+		return;
+	}
+
+	// all of it, then evenly spaced cuts, and the last byte missing
+	for (int32 i = 0; i <= DIFF_NUM_CUTS; i++)
+	{
+		size_t cut = i == 0 ? worker->game_out.size : i == DIFF_NUM_CUTS ? worker->game_out.size - 1 : worker->game_out.size / DIFF_NUM_CUTS * i;
+
+		if (!diff_cut(worker, &input, cut, what, sizeof(what)))
+		{
+			diff_fail(worker, &input, &params, what);
+
+			num_failed++;
+		}
+	}
+
+	printf("%d of %d cuts of %zu bytes inflated the same on %d threads as in one go\n", DIFF_NUM_CUTS + 1 - num_failed, DIFF_NUM_CUTS + 1, worker->game_out.size, DIFF_CUT_THREADS);
+
+	rge_free(input.data);
+}
+
+local void diff_run_job(diff_worker *worker, int32 job)
+{
+	diff_queue *queue = worker->queue;
+	diff_input *input = &queue->inputs[job / queue->num_settings];
+	deflate_params *params = &queue->settings[job % queue->num_settings];
+	char what[128];
+
+	// the pieces only depend on the job, so a failure comes back with the same seed no matter the threads
+	diff_seed(queue->seed ^ 0xD1FF, job);
+
+	if (!diff_deflate_ref(worker, input, params))
+	{
+		diff_fail(worker, input, params, "reference deflate failed");
+
+		return;
+	}
+
+	if (!diff_deflate_game(worker, input, params))
+	{
+		diff_fail(worker, input, params, "game deflate failed");
+
+		return;
+	}
+
+	if (worker->ref_out.size != worker->game_out.size || memcmp(worker->ref_out.data, worker->game_out.data, worker->ref_out.size))
+	{
+		size_t pos = 0;
+
+		while (pos < min(worker->ref_out.size, worker->game_out.size) && worker->ref_out.data[pos] == worker->game_out.data[pos]) pos++;
+
+		snprintf(what, sizeof(what), "first difference at byte %zu, %zu bytes from the reference, %zu from the game deflate", pos, worker->ref_out.size, worker->game_out.size);
+
+		diff_fail(worker, input, params, what);
+
+		return;
+	}
+
+	if (!diff_inflate(worker, input)) diff_fail(worker, input, params, "zlib doesn't inflate it to the input");
+}
+
+local void diff_thread(void *arg)
+{
+	diff_worker *worker = (diff_worker *)arg;
+	diff_queue *queue = worker->queue;
+	int32 num_jobs = queue->num_inputs * queue->num_settings;
+
+	for (ever)
+	{
+		int32 job = rge_atomic_inc(&queue->next_job) - 1;
+
+		if (job >= num_jobs) break;
+
+		diff_run_job(worker, job);
+	}
+}
+
+int32 main(int32 argc, char **argv)
+{
+	uint64 seed = 1;
+	size_t max_size = 0x20000;
+	int32 num_fuzz = 2;
+	bool32 all_compares = FALSE;
+	int32 num_threads = rge_num_cpus();
+	char *save_dir = NULL;
+	diff_input *inputs = NULL;
+	int32 num_inputs = 0;
+	char **paths = calloc(argc, sizeof(char *));
+	int32 num_paths = 0;
+
+	for (int32 i = 1; i < argc; i++)
+	{
+		if (!strncmp(argv[i], "--seed=", 7))
+		{
+			seed = strtoull(argv[i] + 7, NULL, 10);
+		}
+		else if (!strncmp(argv[i], "--size=", 7))
+		{
+			max_size = max(atoi(argv[i] + 7), 1);
+		}
+		else if (!strncmp(argv[i], "--fuzz=", 7))
+		{
+			num_fuzz = max(atoi(argv[i] + 7), 0);
+		}
+		else if (!strcmp(argv[i], "--all-compares"))
+		{
+			all_compares = TRUE;
+		}
+		else if (!strncmp(argv[i], "--threads=", 10))
+		{
+			num_threads = max(atoi(argv[i] + 10), 1);
+		}
+		else if (!strncmp(argv[i], "--save=", 7))
+		{
+			save_dir = argv[i] + 7;
+		}
+		else if (!strncmp(argv[i], "--cpu=", 6) && cpu_find_level(argv[i] + 6) != CPU_LEVEL_INVALID)
+		{
+			cpu_set_level(cpu_find_level(argv[i] + 6));
+		}
+		else if (!strncmp(argv[i], "--", 2))
+		{
+			printf("error: unknown option %s\n\n", argv[i]);
+			printf(USAGE);
+
+			return 1;
+		}
+		else
+		{
+			paths[num_paths++] = argv[i];
+		}
+	}
+
+	if (!diff_generate(&inputs, &num_inputs, seed, max_size, num_fuzz))
+	{
+		printf("error: out of memory\n");
+
+		return 1;
+	}
+
+	for (int32 i = 0; i < num_paths; i++)
+	{
+		if (!diff_add_path(&inputs, &num_inputs, paths[i])) return 1;
+	}
+
+	int32 num_compares = all_compares ? DEFLATE_MAX_COMPARE : sizeof(default_compares) / sizeof(*default_compares);
+	deflate_params *settings = malloc(num_compares * 6 * sizeof(deflate_params));
+	int32 num_settings = 0;
+
+	for (int32 i = 0; i < num_compares; i++)
+	{
+		for (int32 strategy = DEFLATE_STATIC_BLOCKS; strategy <= DEFLATE_ALL_BLOCKS; strategy++)
+		{
+			for (int32 greedy = 0; greedy < 2; greedy++)
+			{
+				settings[num_settings].max_compares = all_compares ? i + 1 : default_compares[i];
+				settings[num_settings].strategy = strategy;
+				settings[num_settings].greedy_flag = greedy;
+				num_settings++;
+			}
+		}
+	}
+
+	diff_queue queue = { inputs, num_inputs, settings, num_settings, seed, save_dir, 0, 0 };
+	diff_worker *workers = calloc(num_threads, sizeof(diff_worker));
+
+	rge_mutex_init(&queue.mutex);
+
+	size_t total_size = 0;
+
+	for (int32 i = 0; i < num_inputs; i++) total_size += inputs[i].size;
+
+	printf("%d inputs of %zu bytes, %d settings, %d threads, %s kernels\n", num_inputs, total_size, num_settings, num_threads, cpu_get_kernels()->name);
+
+	uint64 start = rge_time_ns();
+
+	for (int32 i = 0; i < num_threads; i++)
+	{
+		diff_worker *worker = &workers[i];
+
+		worker->queue = &queue;
+		worker->ref_wd = malloc(ref_deflate_buf_size());
+		worker->game_wd = malloc(deflate_get_backend(DEFLATE_BACKEND_GAME)->buf_size());
+		worker->inflate_wd = malloc(max(inflate_get_backend(INFLATE_BACKEND_ZLIB)->buf_size(), Inf32BufSize())); // the cuts use it for Inf32 after
+		worker->pieces = malloc(DIFF_MAX_PIECE_SIZE);
+
+		if (!worker->ref_wd || !worker->game_wd || !worker->inflate_wd || !worker->pieces)
+		{
+			printf("error: out of memory\n");
+
+			return 1;
+		}
+
+		// the main thread works too, so one thread means no threads
+		if (i && !rge_thread_create(&worker->thread, diff_thread, worker))
+		{
+			printf("error: couldn't start a thread\n");
+
+			return 1;
+		}
+	}
+
+	diff_thread(&workers[0]);
+
+	for (int32 i = 1; i < num_threads; i++)
+	{
+		rge_thread_join(&workers[i].thread);
+	}
+
+	printf("%d of %lld deflates the same as the reference and inflated again in %.1f s\n", num_inputs * num_settings - queue.num_failed, (long long)num_inputs * num_settings, (rge_time_ns() - start) / 1e9);
+
+	diff_cuts(&workers[0], inputs, num_inputs);
+
+	for (int32 i = 0; i < num_threads; i++)
+	{
+		rge_free(workers[i].ref_wd);
+		rge_free(workers[i].game_wd);
+		rge_free(workers[i].inflate_wd);
+		rge_free(workers[i].pieces);
+		rge_free(workers[i].ref_out.data);
+		rge_free(workers[i].game_out.data);
+		rge_free(workers[i].inflated);
+	}
+
+	for (int32 i = 0; i < num_inputs; i++)
+	{
+		rge_free(inputs[i].data);
+		rge_free(inputs[i].dict);
+	}
+
+	rge_mutex_destroy(&queue.mutex);
+
+	rge_free(workers);
+	rge_free(settings);
+	rge_free(inputs);
+	rge_free(paths);
+
+	return queue.num_failed ? 1 : 0;
+}
@@ -0,0 +1,519 @@
+#include "main.h"
+
+#define USAGE \
+"usage: rge_fio_gen [options] <out dir>\n\n" \
+"writes a deterministic corpus that looks like what the game deflates, for rge_fio_bench:\n" \
+"  scenario_<i>.scn       player data, trigger structs, a terrain grid and unit lists with float coordinates\n" \
+"  recorded_<i>.mgx       a recorded game command stream with sync packets in between\n" \
+"  zeros.bin              all zeros\n" \
+"  random.bin             incompressible\n" \
+"  repeat32k.bin          one random 32 KiB block over and over, every match is at the largest distance there is\n" \
+"  runs258.bin            runs of 258 bytes, the longest match there is, each of a different byte\n\n" \
+"options:\n" \
+"  --seed=<n>             same seed, same files (default 1)\n" \
+"  --size=<n>             approximate size of every file in bytes (default 1048576)\n" \
+"  --count=<n>            number of scenario and recorded game files (default 1)\n\n"
+
+#define GEN_MAX_PLAYERS 8
+#define GEN_NUM_TERRAINS 42
+
+typedef struct gen_buffer gen_buffer;
+
+struct gen_buffer
+{
+	byte *data;
+	size_t size;
+	size_t alloc;
+};
+
+local uint64 rng_state = 0; // splitmix64
+
+local char *words[] =
+{
+	"the", "enemy", "castle", "must", "be", "destroyed", "before", "your", "villagers", "gather", "gold", "stone", "wood", "food",
+	"king", "guard", "bridge", "north", "south", "river", "army", "attack", "defend", "town", "center", "wonder", "relic", "monastery",
+};
+
+local char *player_names[] = { "Player 1", "Player 2", "Player 3", "Player 4", "Player 5", "Player 6", "Player 7", "Player 8" };
+
+// good enough and the same everywhere
+local uint64 gen_rand()
+{
+	uint64 z = (rng_state += 0x9E3779B97F4A7C15ull);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+	return z ^ (z >> 31);
+}
+
+// a stream of its own for every file, so one file doesn't change when others are added
+local void gen_seed(uint64 seed, uint32 stream)
+{
+	rng_state = seed;
+	rng_state = gen_rand() ^ stream;
+}
+
+local int32 gen_range(int32 n)
+{
+	return (int32)(gen_rand() % (uint64)n);
+}
+
+local float gen_float(float lo, float hi)
+{
+	return lo + (hi - lo) * (float)(gen_rand() >> 40) / (float)(1 << 24);
+}
+
+local void gen_put(gen_buffer *buf, void *data, size_t size)
+{
+	if (buf->size + size > buf->alloc)
+	{
+		buf->alloc = max(buf->alloc * 2, buf->size + size);
+		buf->data = realloc(buf->data, buf->alloc);
+	}
+
+	memcpy(buf->data + buf->size, data, size);
+	buf->size += size;
+}
+
+// little endian like the game, whatever the host is
+local void gen_put_u8(gen_buffer *buf, uint32 value)
+{
+	byte b = (byte)value;
+
+	gen_put(buf, &b, 1);
+}
+
+local void gen_put_u16(gen_buffer *buf, uint32 value)
+{
+	gen_put_u8(buf, value);
+	gen_put_u8(buf, value >> 8);
+}
+
+local void gen_put_u32(gen_buffer *buf, uint32 value)
+{
+	gen_put_u16(buf, value);
+	gen_put_u16(buf, value >> 16);
+}
+
+local void gen_put_f32(gen_buffer *buf, float value)
+{
+	uint32 bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	gen_put_u32(buf, bits);
+}
+
+// length prefixed and zero terminated, the way scenarios store them
+local void gen_put_string(gen_buffer *buf, char *str)
+{
+	gen_put_u16(buf, (uint32)strlen(str) + 1);
+	gen_put(buf, str, strlen(str) + 1);
+}
+
+local void gen_put_text(gen_buffer *buf, int32 num_words)
+{
+	char text[1024] = ZEROSTR;
+
+	for (int32 i = 0; i < num_words && strlen(text) < sizeof(text) - 32; i++)
+	{
+		if (i) strcat(text, " ");
+
+		strcat(text, words[gen_range(sizeof(words) / sizeof(words[0]))]);
+	}
+
+	gen_put_string(buf, text);
+}
+
+local void gen_put_fixed_name(gen_buffer *buf, char *name, int32 size)
+{
+	char field[256] = ZEROSTR;
+
+	strncpy(field, name, min(size, (int32)sizeof(field)) - 1);
+
+	gen_put(buf, field, size);
+}
+
+local void gen_scenario_players(gen_buffer *buf)
+{
+	gen_put(buf, "1.21", 4);
+	gen_put_u32(buf, 6);
+	gen_put_u32(buf, GEN_MAX_PLAYERS);
+
+	for (int32 i = 0; i < 16; i++)
+	{
+		gen_put_fixed_name(buf, i < GEN_MAX_PLAYERS ? player_names[i] : EMPTYSTR, 256);
+	}
+
+	for (int32 i = 0; i < 16; i++)
+	{
+		gen_put_u32(buf, i < GEN_MAX_PLAYERS); // active
+		gen_put_u32(buf, i == 0); // human
+		gen_put_u32(buf, 1 + gen_range(18)); // civ
+		gen_put_u32(buf, 4);
+
+		gen_put_f32(buf, 200.0f);
+		gen_put_f32(buf, 200.0f);
+		gen_put_f32(buf, 100.0f);
+		gen_put_f32(buf, 200.0f);
+	}
+
+	gen_put_text(buf, 40 + gen_range(80));
+	gen_put_text(buf, 10 + gen_range(20));
+	gen_put_text(buf, 10 + gen_range(20));
+}
+
+// whole blocks of one terrain with ragged edges and elevation changing slowly, like hand made maps
+local void gen_scenario_terrain(gen_buffer *buf, int32 size)
+{
+	int32 cell = 8;
+	int32 num_cells = size / cell + 1;
+	byte *cells = malloc(num_cells * num_cells);
+
+	for (int32 i = 0; i < num_cells * num_cells; i++)
+	{
+		cells[i] = (byte)(gen_range(4) ? gen_range(8) : gen_range(GEN_NUM_TERRAINS));
+	}
+
+	gen_put_u32(buf, size);
+	gen_put_u32(buf, size);
+
+	int32 elevation = 0;
+
+	for (int32 y = 0; y < size; y++)
+	{
+		for (int32 x = 0; x < size; x++)
+		{
+			int32 cx = (x + (gen_range(8) ? 0 : gen_range(3) - 1)) / cell;
+			int32 cy = (y + (gen_range(8) ? 0 : gen_range(3) - 1)) / cell;
+
+			cx = min(max(cx, 0), num_cells - 1);
+			cy = min(max(cy, 0), num_cells - 1);
+
+			if (!gen_range(64)) elevation = min(max(elevation + gen_range(3) - 1, 0), 7);
+
+			gen_put_u8(buf, cells[cy * num_cells + cx]);
+			gen_put_u8(buf, elevation);
+			gen_put_u8(buf, 0);
+		}
+	}
+
+	rge_free(cells);
+}
+
+local void gen_scenario_units(gen_buffer *buf, int32 num_units, int32 map_size, uint32 *next_id)
+{
+	for (int32 i = 0; i <= GEN_MAX_PLAYERS; i++)
+	{
+		// gaia's trees and gold all over the map, players' units around their town center
+		float start_x = gen_float(10.0f, map_size - 10.0f);
+		float start_y = gen_float(10.0f, map_size - 10.0f);
+		int32 count = i ? num_units / 4 + gen_range(num_units / 4 + 1) : num_units;
+
+		gen_put_f32(buf, 200.0f);
+		gen_put_f32(buf, 200.0f);
+		gen_put_u32(buf, count);
+
+		for (int32 j = 0; j < count; j++)
+		{
+			float x = i ? start_x + gen_float(-12.0f, 12.0f) : gen_float(0.0f, (float)map_size);
+			float y = i ? start_y + gen_float(-12.0f, 12.0f) : gen_float(0.0f, (float)map_size);
+
+			// placed in the editor, so mostly on tile centers
+			if (gen_range(4))
+			{
+				x = (int32)x + 0.5f;
+				y = (int32)y + 0.5f;
+			}
+
+			gen_put_f32(buf, min(max(x, 0.0f), (float)map_size));
+			gen_put_f32(buf, min(max(y, 0.0f), (float)map_size));
+			gen_put_f32(buf, 1.0f);
+			gen_put_u32(buf, (*next_id)++);
+			gen_put_u16(buf, i ? 83 + gen_range(30) : 349 + gen_range(8));
+			gen_put_u8(buf, 2);
+			gen_put_f32(buf, gen_range(8) * 0.785398f);
+			gen_put_u16(buf, gen_range(3) ? 0 : gen_range(16));
+			gen_put_u32(buf, 0xFFFFFFFF);
+		}
+	}
+}
+
+// every effect and condition is the same struct with most fields -1, only a few set
+local void gen_scenario_triggers(gen_buffer *buf, int32 num_triggers, uint32 max_id)
+{
+	gen_put_u8(buf, 0);
+	gen_put_u32(buf, num_triggers);
+
+	for (int32 i = 0; i < num_triggers; i++)
+	{
+		int32 num_effects = 1 + gen_range(4);
+		int32 num_conditions = gen_range(3);
+
+		gen_put_u32(buf, 1); // enabled
+		gen_put_u8(buf, gen_range(10) == 0); // looping
+		gen_put_u8(buf, 0);
+		gen_put_u8(buf, gen_range(2)); // objective
+		gen_put_u32(buf, gen_range(3) ? 0 : i);
+		gen_put_u32(buf, 0);
+		gen_put_text(buf, gen_range(3) ? 0 : 5 + gen_range(20));
+		gen_put_text(buf, 1 + gen_range(4));
+
+		gen_put_u32(buf, num_effects);
+
+		for (int32 j = 0; j < num_effects; j++)
+		{
+			int32 type = 1 + gen_range(29);
+
+			gen_put_u32(buf, type);
+			gen_put_u32(buf, 23);
+
+			for (int32 k = 0; k < 23; k++)
+			{
+				if (k == 1 && type < 10) gen_put_u32(buf, gen_range(1000));
+				else if (k == 5) gen_put_u32(buf, 1 + gen_range(GEN_MAX_PLAYERS));
+				else if (k == 7 && gen_range(2)) gen_put_u32(buf, gen_range(max_id));
+				else if ((k == 10 || k == 11) && gen_range(2)) gen_put_u32(buf, gen_range(120));
+				else gen_put_u32(buf, 0xFFFFFFFF);
+			}
+
+			gen_put_text(buf, gen_range(2) ? 0 : 3 + gen_range(12));
+			gen_put_string(buf, EMPTYSTR);
+		}
+
+		for (int32 j = 0; j < num_effects; j++)
+		{
+			gen_put_u32(buf, j);
+		}
+
+		gen_put_u32(buf, num_conditions);
+
+		for (int32 j = 0; j < num_conditions; j++)
+		{
+			gen_put_u32(buf, 1 + gen_range(20));
+			gen_put_u32(buf, 16);
+
+			for (int32 k = 0; k < 16; k++)
+			{
+				if (k == 0) gen_put_u32(buf, gen_range(50));
+				else if (k == 4) gen_put_u32(buf, 1 + gen_range(GEN_MAX_PLAYERS));
+				else gen_put_u32(buf, 0xFFFFFFFF);
+			}
+		}
+
+		for (int32 j = 0; j < num_conditions; j++)
+		{
+			gen_put_u32(buf, j);
+		}
+	}
+}
+
+local void gen_scenario(gen_buffer *buf, size_t size)
+{
+	// a 3 byte tile grid about a third of the file, the units and triggers the rest
+	int32 map_size = 40;
+
+	while (map_size < 480 && (size_t)map_size * map_size * 9 < size) map_size++;
+
+	int32 num_units = max(16, (int32)(size / 3 / 31 / (GEN_MAX_PLAYERS / 2 + 1)));
+	uint32 next_id = 1;
+
+	gen_scenario_players(buf);
+	gen_scenario_terrain(buf, map_size);
+	gen_scenario_units(buf, num_units, map_size, &next_id);
+
+	while (buf->size < size)
+	{
+		gen_scenario_triggers(buf, 50, next_id);
+	}
+}
+
+// commands the players issue with a sync packet every few turns, units being picked again and again
+local void gen_recorded(gen_buffer *buf, size_t size)
+{
+	uint32 selected[GEN_MAX_PLAYERS][40];
+	int32 num_selected[GEN_MAX_PLAYERS] = ZEROMEM;
+	uint32 checksum = (uint32)gen_rand();
+	int32 turn = 0;
+
+	gen_put(buf, "VER 9.4", 8);
+	gen_put_u32(buf, 0);
+
+	while (buf->size < size)
+	{
+		if (!gen_range(6))
+		{
+			gen_put_u32(buf, 2); // sync
+			gen_put_u32(buf, 100 + gen_range(4) * 10);
+
+			if (!(turn++ % 4))
+			{
+				checksum += gen_range(0x10000);
+
+				gen_put_u32(buf, 0);
+				gen_put_u32(buf, checksum);
+				gen_put_u32(buf, 0);
+				gen_put_u32(buf, 0);
+			}
+
+			continue;
+		}
+
+		int32 player = gen_range(GEN_MAX_PLAYERS);
+		int32 command = gen_range(4);
+
+		if (!num_selected[player] || !gen_range(5))
+		{
+			num_selected[player] = 1 + gen_range(40);
+
+			for (int32 i = 0; i < num_selected[player]; i++)
+			{
+				selected[player][i] = 1000 + player * 500 + gen_range(200);
+			}
+		}
+
+		int32 num_units = command == 3 ? 1 : num_selected[player];
+		int32 length = 20 + num_units * 4;
+
+		gen_put_u32(buf, 1); // command
+		gen_put_u32(buf, length);
+		gen_put_u8(buf, command == 0 ? 0x03 : command == 1 ? 0x00 : command == 2 ? 0x13 : 0x66);
+		gen_put_u8(buf, player + 1);
+		gen_put_u16(buf, 0);
+		gen_put_u32(buf, command == 1 ? 1000 + gen_range(8000) : 0xFFFFFFFF);
+		gen_put_u32(buf, num_units);
+		gen_put_f32(buf, (float)(gen_range(200 * 16)) / 16.0f);
+		gen_put_f32(buf, (float)(gen_range(200 * 16)) / 16.0f);
+
+		for (int32 i = 0; i < num_units; i++)
+		{
+			gen_put_u32(buf, selected[player][i]);
+		}
+
+		gen_put_u32(buf, 0);
+	}
+}
+
+local void gen_zeros(gen_buffer *buf, size_t size)
+{
+	byte zeros[0x1000] = ZEROMEM;
+
+	while (buf->size < size) gen_put(buf, zeros, min(sizeof(zeros), size - buf->size));
+}
+
+local void gen_random(gen_buffer *buf, size_t size)
+{
+	while (buf->size < size) gen_put_u8(buf, (uint32)gen_rand());
+}
+
+local void gen_repeat32k(gen_buffer *buf, size_t size)
+{
+	byte *block = malloc(0x8000);
+
+	for (int32 i = 0; i < 0x8000; i++)
+	{
+		block[i] = (byte)gen_rand();
+	}
+
+	while (buf->size < size) gen_put(buf, block, min(0x8000, size - buf->size));
+
+	rge_free(block);
+}
+
+local void gen_runs258(gen_buffer *buf, size_t size)
+{
+	byte run[258];
+
+	for (int32 value = 0; buf->size < size; value = (value + 1 + gen_range(255)) & 0xFF)
+	{
+		memset(run, value, sizeof(run));
+
+		gen_put(buf, run, min(sizeof(run), size - buf->size));
+	}
+}
+
+local bool32 gen_write(char *dir, char *name, void (*func)(gen_buffer *, size_t), size_t size, uint64 seed, uint32 stream)
+{
+	gen_buffer buf = ZEROMEM;
+	char filename[MAX_PATH];
+
+	gen_seed(seed, stream);
+
+	func(&buf, size);
+
+	snprintf(filename, sizeof(filename), "%s/%s", dir, name);
+
+	FILE *out = rge_fopen(filename, "wb");
+	bool32 ok = out && fwrite(buf.data, buf.size, 1, out) == 1;
+
+	if (out && fclose(out)) ok = FALSE;
+
+	if (ok) printf("wrote %zu bytes to %s\n", buf.size, filename);
+	else printf("error: couldn't write %s\n", filename);
+
+	rge_free(buf.data);
+
+	return ok;
+}
+
+int32 main(int32 argc, char **argv)
+{
+	uint64 seed = 1;
+	size_t size = 0x100000;
+	int32 count = 1;
+	char *dir = NULL;
+
+	for (int32 i = 1; i < argc; i++)
+	{
+		if (!strncmp(argv[i], "--seed=", 7))
+		{
+			seed = strtoull(argv[i] + 7, NULL, 10);
+		}
+		else if (!strncmp(argv[i], "--size=", 7))
+		{
+			size = max(0x1000, strtoull(argv[i] + 7, NULL, 10));
+		}
+		else if (!strncmp(argv[i], "--count=", 8))
+		{
+			count = max(1, atoi(argv[i] + 8));
+		}
+		else if (!strncmp(argv[i], "--", 2))
+		{
+			printf("error: unknown option %s\n\n", argv[i]);
+			printf(USAGE);
+
+			return 1;
+		}
+		else
+		{
+			dir = argv[i];
+		}
+	}
+
+	if (!dir)
+	{
+		printf(USAGE);
+
+		return 1;
+	}
+
+	char name[64];
+	bool32 ok = TRUE;
+
+	for (int32 i = 0; i < count && ok; i++)
+	{
+		snprintf(name, sizeof(name), "scenario_%d.scn", i);
+		ok = gen_write(dir, name, gen_scenario, size, seed, i * 2);
+
+		snprintf(name, sizeof(name), "recorded_%d.mgx", i);
+		ok = ok && gen_write(dir, name, gen_recorded, size, seed, i * 2 + 1);
+	}
+
+	ok = ok && gen_write(dir, "zeros.bin", gen_zeros, size, seed, 0x80000000);
+	ok = ok && gen_write(dir, "random.bin", gen_random, size, seed, 0x80000001);
+	ok = ok && gen_write(dir, "repeat32k.bin", gen_repeat32k, size, seed, 0x80000002);
+	ok = ok && gen_write(dir, "runs258.bin", gen_runs258, size, seed, 0x80000003);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,600 @@
+// the kernels are local to deflate.c, so it's compiled into this file instead of being linked, that's all the exposure they get
+#include "../src/deflate.c" // not zlib/deflate.c, which the include path would find first
+
+#include <math.h>
+
+#define USAGE \
+"usage: rge_fio_kernels [options] [kernel ...]\n\n" \
+"times the inner functions of the game deflate on their own on a fixed 32 KiB input and reports ns per call and per byte,\n" \
+"the mean of all samples after the warm-up ones with its 95%% confidence interval, all kernels or the ones named:\n" \
+"%s\n" \
+"options:\n" \
+"  --samples=<n>          timed samples per kernel (default 30)\n" \
+"  --warmup=<n>           untimed samples before those (default 3)\n" \
+"  --rounds=<n>           times the kernel runs per sample (default 16)\n" \
+"  --max-compares=<n>     match search depth of find_match, greedy and lazy, 1 to 1500 (default 75)\n" \
+"  --file=<file>          input instead of the built-in one, its first 32 KiB, repeated if it's shorter\n" \
+"  --cpu=<level>          newest instructions the kernels use, generic, sse2, avx2 or avx512 (default the best the cpu has)\n" \
+"  --json                 print the results as json instead of a table\n\n"
+
+#define KERNEL_OUT_BUF_SIZE 0x10000
+#define KERNEL_NUM_BITS 0x1000 // put_bits calls per round
+#define KERNEL_MAX_SAMPLES 1000
+#define KERNEL_MAX_PAIRS 0x10000
+
+typedef struct kernel_sample kernel_sample;
+
+struct kernel_sample
+{
+	uint64 ns; // only the kernel, setting it up isn't counted
+	int64 calls;
+	int64 bytes; // input bytes, output bytes for put_bits, 0 where bytes don't mean anything
+};
+
+typedef struct kernel kernel;
+
+struct kernel
+{
+	char *name;
+	void (*run)(kernel_sample *sample, int32 num_rounds);
+};
+
+local byte input[DEFLATE_DICT_SIZE];
+local byte kernel_out_buf[KERNEL_OUT_BUF_SIZE];
+local work_data *kernel_wd = NULL;
+local int32 kernel_compares = DEFLATE_MAX_COMPARES_DEFAULT;
+
+local int32 put_bits_codes[KERNEL_NUM_BITS];
+local int32 put_bits_lens[KERNEL_NUM_BITS];
+local int32 huff_freq_1[DEFLATE_NUM_SYMBOLS_1];
+local int32 huff_freq_2[DEFLATE_NUM_SYMBOLS_2];
+local uint16 match_pairs[KERNEL_MAX_PAIRS][2];
+
+local volatile uint32 sink = 0; // keeps results the compiler could otherwise drop
+
+local uint64 rng_state = 0x72676566696F; // splitmix64, same as rge_fio_gen
+
+local uint64 kernel_rand()
+{
+	uint64 z = (rng_state += 0x9E3779B97F4A7C15);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+
+	return z ^ (z >> 31);
+}
+
+// unit records with a few fields changing and names in between, like the middle of a scenario
+local void kernel_make_input()
+{
+	char *names[] = { "Archer", "Villager", "Scout", "Priest", "Catapult", "Trireme", "Town Center", "Granary" };
+	int32 pos = 0;
+	float x = 10.0f;
+
+	while (pos < DEFLATE_DICT_SIZE)
+	{
+		byte record[40];
+		uint32 value = (uint32)kernel_rand();
+
+		memzero(record, sizeof(record));
+
+		x += (float)(value & 0xFF) / 64.0f;
+
+		memcpy(record, &x, sizeof(x));
+		record[8] = (byte)(value >> 8) & 0x07;
+		record[12] = (byte)(value >> 16);
+		strcpy((char *)record + 16, names[(value >> 24) & 7]);
+
+		int32 size = min(DEFLATE_DICT_SIZE - pos, (int32)sizeof(record));
+
+		memcpy(input + pos, record, size);
+		pos += size;
+	}
+}
+
+local bool32 kernel_read_input(char *filename)
+{
+	FILE *in = rge_fopen(filename, "rb");
+
+	if (!in) return FALSE;
+
+	size_t size = fread(input, 1, DEFLATE_DICT_SIZE, in);
+
+	rge_fclose(in);
+
+	if (!size) return FALSE;
+
+	for (size_t i = size; i < DEFLATE_DICT_SIZE; i++)
+	{
+		input[i] = input[i - size];
+	}
+
+	return TRUE;
+}
+
+// literal frequencies from the input, lengths and distances falling off like they do on game data
+local void kernel_make_tables()
+{
+	memzero(huff_freq_1, sizeof(huff_freq_1));
+
+	for (int32 i = 0; i < DEFLATE_DICT_SIZE; i++)
+	{
+		huff_freq_1[input[i]]++;
+	}
+
+	huff_freq_1[256] = 1;
+
+	for (int32 i = 257; i < 286; i++)
+	{
+		huff_freq_1[i] = 1 + (2000 >> ((i - 257) / 2));
+	}
+
+	for (int32 i = 0; i < 30; i++)
+	{
+		huff_freq_2[i] = 1 + (int32)(kernel_rand() % (400 >> (abs(i - 12) / 3)));
+	}
+
+	// a code and its extra bits, up to the 13 extra bits of the farthest distances
+	for (int32 i = 0; i < KERNEL_NUM_BITS; i++)
+	{
+		put_bits_lens[i] = 1 + (int32)(kernel_rand() % 15);
+		put_bits_codes[i] = (int32)(kernel_rand() & ((1 << put_bits_lens[i]) - 1));
+	}
+}
+
+local int32 kernel_flush(byte *out_buf_ofs, int32 out_buf_size)
+{
+	sink += out_buf_ofs[0];
+
+	return 0;
+}
+
+// what deflate_data sets up, with the input in the dictionary and optionally hashed
+local void kernel_load(bool32 hashed)
+{
+	deflate_init(kernel_wd, kernel_compares, DEFLATE_ALL_BLOCKS, TRUE, kernel_out_buf, KERNEL_OUT_BUF_SIZE, kernel_flush);
+
+	dict = wd->dict;
+	hash = wd->hash;
+	next = wd->next;
+	last = wd->last;
+	max_compares = wd->max_compares;
+
+	match_len = 0;
+	match_pos = 0;
+	bit_buf = 0;
+	bit_buf_len = 0;
+	bit_buf_total_flag = FALSE;
+
+	out_buf_cur_ofs = wd->out_buf_ofs;
+	out_buf_left = wd->out_buf_size;
+
+	mem_copy(dict, input, DEFLATE_DICT_SIZE);
+	mem_copy(dict + DEFLATE_DICT_SIZE, dict, DEFLATE_SECTOR_SIZE + DEFLATE_MAX_MATCH);
+
+	if (hashed) hash_data(0, DEFLATE_DICT_SIZE);
+}
+
+local void kernel_hash_data(kernel_sample *sample, int32 num_rounds)
+{
+	for (int32 round = 0; round < num_rounds; round++)
+	{
+		kernel_load(FALSE);
+
+		uint64 start = rge_time_ns();
+
+		for (int32 dict_pos = 0; dict_pos < DEFLATE_DICT_SIZE; dict_pos += DEFLATE_SECTOR_SIZE)
+		{
+			hash_data(dict_pos, DEFLATE_SECTOR_SIZE);
+		}
+
+		sample->ns += rge_time_ns() - start;
+		sample->calls += DEFLATE_DICT_SIZE / DEFLATE_SECTOR_SIZE;
+		sample->bytes += DEFLATE_DICT_SIZE;
+	}
+}
+
+// every position of the last 28 KiB that has a chain, the first sector only has short chains
+local void kernel_find_match(kernel_sample *sample, int32 num_rounds)
+{
+	kernel_load(TRUE);
+
+	for (int32 round = 0; round < num_rounds; round++)
+	{
+		int32 num_calls = 0;
+		uint32 lens = 0;
+
+		uint64 start = rge_time_ns();
+
+		for (int32 dict_pos = DEFLATE_SECTOR_SIZE; dict_pos < DEFLATE_DICT_SIZE - DEFLATE_MAX_MATCH; dict_pos++)
+		{
+			if (next[dict_pos] == DEFLATE_NIL) continue;
+
+			match_len = DEFLATE_THRESHOLD;
+
+			find_match(dict_pos);
+
+			lens += match_len;
+			num_calls++;
+		}
+
+		sample->ns += rge_time_ns() - start;
+		sample->calls += num_calls;
+		sample->bytes += DEFLATE_DICT_SIZE - DEFLATE_SECTOR_SIZE - DEFLATE_MAX_MATCH;
+
+		sink += lens;
+	}
+}
+
+// the match extension of find_match and dict_search_flash through the kernels of --cpu, on the pairs the chains lead to that start
+// with the same two bytes, the first few of each chain, bytes are the ones found equal
+local void kernel_match_len(kernel_sample *sample, int32 num_rounds)
+{
+	int32 num_pairs = 0;
+
+	kernel_load(TRUE);
+
+	for (int32 dict_pos = DEFLATE_SECTOR_SIZE; dict_pos < DEFLATE_DICT_SIZE - DEFLATE_MAX_MATCH && num_pairs < KERNEL_MAX_PAIRS; dict_pos++)
+	{
+		uint16 probe_pos = next[dict_pos];
+
+		for (int32 i = 0; i < 4 && probe_pos != DEFLATE_NIL && num_pairs < KERNEL_MAX_PAIRS; i++, probe_pos = next[probe_pos])
+		{
+			if (read_word(&dict[probe_pos]) != read_word(&dict[dict_pos])) continue;
+
+			match_pairs[num_pairs][0] = (uint16)dict_pos;
+			match_pairs[num_pairs][1] = probe_pos;
+			num_pairs++;
+		}
+	}
+
+	int32 (*match_len_fn)(byte *, byte *, int32) = wd->kernels->match_len;
+
+	for (int32 round = 0; round < num_rounds; round++)
+	{
+		uint32 lens = 0;
+
+		uint64 start = rge_time_ns();
+
+		for (int32 i = 0; i < num_pairs; i++)
+		{
+			lens += match_len_fn(&dict[match_pairs[i][0]], &dict[match_pairs[i][1]], DEFLATE_MAX_MATCH);
+		}
+
+		sample->ns += rge_time_ns() - start;
+		sample->calls += num_pairs;
+		sample->bytes += lens;
+
+		sink += lens;
+	}
+}
+
+// a sector per call like deflate_main, the tokens are dropped after each so a full token buffer never codes a block in between
+local void kernel_dict_search(kernel_sample *sample, int32 num_rounds, bool32 (*search)())
+{
+	for (int32 round = 0; round < num_rounds; round++)
+	{
+		kernel_load(TRUE);
+
+		wd->search_offset = 0;
+
+		for (int32 sector = 1; sector <= DEFLATE_DICT_SIZE / DEFLATE_SECTOR_SIZE; sector++)
+		{
+			wd->token_buf_ofs = wd->token_buf;
+			wd->token_buf_len = 0;
+			wd->flag_buf_ofs = wd->flag_buf;
+			wd->flag_buf_left = 32;
+			wd->search_bytes_left = DEFLATE_DICT_SIZE - wd->search_offset;
+			wd->search_threshold = sector * DEFLATE_SECTOR_SIZE;
+
+			uint64 start = rge_time_ns();
+
+			search();
+
+			sample->ns += rge_time_ns() - start;
+			sample->calls++;
+
+			// the last sector wraps it around to the start
+			if (!wd->search_offset) break;
+		}
+
+		sample->bytes += DEFLATE_DICT_SIZE;
+	}
+}
+
+local void kernel_dict_search_flash(kernel_sample *sample, int32 num_rounds)
+{
+	kernel_dict_search(sample, num_rounds, dict_search_flash);
+}
+
+local void kernel_dict_search_greedy(kernel_sample *sample, int32 num_rounds)
+{
+	kernel_dict_search(sample, num_rounds, dict_search_greedy);
+}
+
+local void kernel_dict_search_lazy(kernel_sample *sample, int32 num_rounds)
+{
+	kernel_dict_search(sample, num_rounds, dict_search_lazy);
+}
+
+local void kernel_put_bits(kernel_sample *sample, int32 num_rounds)
+{
+	kernel_load(FALSE);
+
+	for (int32 round = 0; round < num_rounds; round++)
+	{
+		int32 num_bits = 0;
+
+		out_buf_cur_ofs = wd->out_buf_ofs;
+		out_buf_left = wd->out_buf_size;
+
+		uint64 start = rge_time_ns();
+
+		for (int32 i = 0; i < KERNEL_NUM_BITS; i++)
+		{
+			put_bits(put_bits_codes[i], put_bits_lens[i]);
+
+			num_bits += put_bits_lens[i];
+		}
+
+		sample->ns += rge_time_ns() - start;
+		sample->calls += KERNEL_NUM_BITS;
+		sample->bytes += num_bits / 8;
+
+		sink += bit_buf;
+	}
+}
+
+// the tail of init_dynamic_block, the frequencies are copied in each time as huff_code_sizes adds up into them
+local void kernel_huff_codes(kernel_sample *sample, int32 num_rounds)
+{
+	kernel_load(FALSE);
+
+	uint64 start = rge_time_ns();
+
+	for (int32 round = 0; round < num_rounds; round++)
+	{
+		int_move(wd->freq_1, huff_freq_1, DEFLATE_NUM_SYMBOLS_1);
+		int_move(wd->freq_2, huff_freq_2, DEFLATE_NUM_SYMBOLS_2);
+
+		huff_code_sizes(DEFLATE_NUM_SYMBOLS_1, wd->freq_1, wd->size_1);
+		huff_sort_code_sizes(DEFLATE_NUM_SYMBOLS_1, wd->size_1);
+		huff_fix_code_sizes(15);
+		huff_make_codes(DEFLATE_NUM_SYMBOLS_1, wd->size_1, 15, wd->code_1);
+
+		huff_code_sizes(DEFLATE_NUM_SYMBOLS_2, wd->freq_2, wd->size_2);
+		huff_sort_code_sizes(DEFLATE_NUM_SYMBOLS_2, wd->size_2);
+		huff_fix_code_sizes(15);
+		huff_make_codes(DEFLATE_NUM_SYMBOLS_2, wd->size_2, 15, wd->code_2);
+
+		sink += wd->code_1[0];
+	}
+
+	sample->ns += rge_time_ns() - start;
+	sample->calls += num_rounds;
+}
+
+local void kernel_init_compress_code_sizes(kernel_sample *sample, int32 num_rounds)
+{
+	kernel_load(FALSE);
+	kernel_huff_codes(sample, 1);
+
+	memzero(sample, sizeof(kernel_sample));
+
+	uint64 start = rge_time_ns();
+
+	for (int32 round = 0; round < num_rounds; round++)
+	{
+		init_compress_code_sizes();
+
+		sink += wd->code_3[0];
+	}
+
+	sample->ns += rge_time_ns() - start;
+	sample->calls += num_rounds;
+}
+
+local kernel kernels[] =
+{
+	{ "hash_data", kernel_hash_data },
+	{ "find_match", kernel_find_match },
+	{ "match_len", kernel_match_len },
+	{ "dict_search_flash", kernel_dict_search_flash },
+	{ "dict_search_greedy", kernel_dict_search_greedy },
+	{ "dict_search_lazy", kernel_dict_search_lazy },
+	{ "put_bits", kernel_put_bits },
+	{ "huff_codes", kernel_huff_codes },
+	{ "init_compress_code_sizes", kernel_init_compress_code_sizes },
+};
+
+#define NUM_KERNELS (sizeof(kernels) / sizeof(*kernels))
+
+// two-sided 95% of student's t for 1 to 30 degrees of freedom, the normal distribution's after that
+local double t_95[] =
+{
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+local void kernel_mean(double *values, int32 num_values, double *mean, double *interval)
+{
+	double sum = 0.0;
+	double squares = 0.0;
+
+	for (int32 i = 0; i < num_values; i++)
+	{
+		sum += values[i];
+	}
+
+	*mean = sum / num_values;
+
+	for (int32 i = 0; i < num_values; i++)
+	{
+		squares += (values[i] - *mean) * (values[i] - *mean);
+	}
+
+	if (num_values < 2)
+	{
+		*interval = 0.0;
+
+		return;
+	}
+
+	double t = num_values - 1 <= sizeof(t_95) / sizeof(*t_95) ? t_95[num_values - 2] : 1.960;
+
+	*interval = t * sqrt(squares / (num_values - 1)) / sqrt(num_values);
+}
+
+int32 main(int32 argc, char **argv)
+{
+	int32 num_samples = 30;
+	int32 num_warmup = 3;
+	int32 num_rounds = 16;
+	bool32 json = FALSE;
+	char *input_filename = NULL;
+	bool32 selected[NUM_KERNELS];
+	bool32 any_selected = FALSE;
+
+	memzero(selected, sizeof(selected));
+
+	for (int32 i = 1; i < argc; i++)
+	{
+		if (!strncmp(argv[i], "--samples=", 10))
+		{
+			num_samples = min(max(atoi(argv[i] + 10), 1), KERNEL_MAX_SAMPLES);
+		}
+		else if (!strncmp(argv[i], "--warmup=", 9))
+		{
+			num_warmup = max(atoi(argv[i] + 9), 0);
+		}
+		else if (!strncmp(argv[i], "--rounds=", 9))
+		{
+			num_rounds = max(atoi(argv[i] + 9), 1);
+		}
+		else if (!strncmp(argv[i], "--max-compares=", 15))
+		{
+			kernel_compares = min(max(atoi(argv[i] + 15), DEFLATE_MIN_COMPARE), DEFLATE_MAX_COMPARE);
+		}
+		else if (!strncmp(argv[i], "--file=", 7))
+		{
+			input_filename = argv[i] + 7;
+		}
+		else if (!strcmp(argv[i], "--json"))
+		{
+			json = TRUE;
+		}
+		else if (!strncmp(argv[i], "--cpu=", 6) && cpu_find_level(argv[i] + 6) != CPU_LEVEL_INVALID)
+		{
+			cpu_set_level(cpu_find_level(argv[i] + 6));
+		}
+		else
+		{
+			bool32 found = FALSE;
+
+			for (int32 j = 0; j < NUM_KERNELS; j++)
+			{
+				if (!strcmp(argv[i], kernels[j].name)) found = selected[j] = any_selected = TRUE;
+			}
+
+			if (!found)
+			{
+				char names[1024] = ZEROSTR;
+
+				for (int32 j = 0; j < NUM_KERNELS; j++)
+				{
+					strcat(names, "  ");
+					strcat(names, kernels[j].name);
+					strcat(names, "\n");
+				}
+
+				printf("error: unknown kernel or option %s\n\n", argv[i]);
+				printf(USAGE, names);
+
+				return 1;
+			}
+		}
+	}
+
+	if (input_filename && !kernel_read_input(input_filename))
+	{
+		printf("error: couldn't read %s\n", input_filename);
+
+		return 1;
+	}
+	else if (!input_filename)
+	{
+		kernel_make_input();
+	}
+
+	kernel_make_tables();
+
+	kernel_wd = malloc(deflate_buf_size());
+
+	double *ns_per_call = malloc(num_samples * sizeof(double));
+	double *ns_per_byte = malloc(num_samples * sizeof(double));
+
+	if (!kernel_wd || !ns_per_call || !ns_per_byte)
+	{
+		printf("error: out of memory\n");
+
+		return 1;
+	}
+
+	if (json) printf("{\n  \"cpu\": \"%s\",\n  \"max_compares\": %d,\n  \"samples\": %d,\n  \"rounds\": %d,\n  \"kernels\": [\n", cpu_get_kernels()->name, kernel_compares, num_samples, num_rounds);
+	else printf("%s kernels\n\nkernel                      calls/sample     ns/call     +-95%%     ns/byte     +-95%%\n", cpu_get_kernels()->name);
+
+	bool32 first = TRUE;
+
+	for (int32 i = 0; i < NUM_KERNELS; i++)
+	{
+		if (any_selected && !selected[i]) continue;
+
+		kernel_sample sample;
+
+		for (int32 j = 0; j < num_warmup + num_samples; j++)
+		{
+			memzero(&sample, sizeof(sample));
+
+			kernels[i].run(&sample, num_rounds);
+
+			if (j < num_warmup) continue;
+
+			ns_per_call[j - num_warmup] = sample.calls ? (double)sample.ns / sample.calls : 0.0;
+			ns_per_byte[j - num_warmup] = sample.bytes ? (double)sample.ns / sample.bytes : 0.0;
+		}
+
+		double call_mean;
+		double call_interval;
+		double byte_mean;
+		double byte_interval;
+
+		kernel_mean(ns_per_call, num_samples, &call_mean, &call_interval);
+		kernel_mean(ns_per_byte, num_samples, &byte_mean, &byte_interval);
+
+		if (json)
+		{
+			printf("%s    { \"name\": \"%s\", \"calls_per_sample\": %lld, \"ns_per_call\": %.3f, \"ns_per_call_ci95\": %.3f", first ? "" : ",\n", kernels[i].name, (long long)sample.calls, call_mean, call_interval);
+
+			if (sample.bytes) printf(", \"ns_per_byte\": %.4f, \"ns_per_byte_ci95\": %.4f }", byte_mean, byte_interval);
+			else printf(", \"ns_per_byte\": null, \"ns_per_byte_ci95\": null }");
+		}
+		else
+		{
+			printf("%-27s %12lld %11.2f %9.2f", kernels[i].name, (long long)sample.calls, call_mean, call_interval);
+
+			if (sample.bytes) printf(" %11.4f %9.4f\n", byte_mean, byte_interval);
+			else printf(" %11s %9s\n", "-", "-");
+		}
+
+		first = FALSE;
+	}
+
+	if (json) printf("\n  ]\n}\n");
+
+	rge_free(ns_per_call);
+	rge_free(ns_per_byte);
+	rge_free(kernel_wd);
+
+	return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "main.h"
+
+// the reference game deflate in ref/deflate.c, same interface as deflate_* in compress.h
+size_t ref_deflate_buf_size();
+int32 ref_deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32));
+int32 ref_deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag);
+int32 ref_deflate_set_dictionary(void *_wd, byte *dict_ofs, int32 dict_size);
+void ref_deflate_deinit(void *_wd);
@@ -1,3 +1,30 @@
+newoption
+{
+	trigger = "io-uring",
+	description = "Build the io_uring file I/O backend (Linux 5.6 and up, picked at runtime with --io=uring)"
+}
+
+newoption
+{
+	trigger = "deflate-stats",
+	description = "Count what the game deflate does for w --stats, costs some speed"
+}
+
+newoption
+{
+	trigger = "pgo",
+	value = "step",
+	description = "Profile guided Release build, generate an instrumented one, run it on the training corpus, then use what it measured",
+	allowed =
+	{
+		{ "generate", "Instrumented, writes a profile when it exits" },
+		{ "use", "Optimized with the profile the instrumented build wrote" }
+	}
+}
+
+-- both steps have to agree on it, and make clean between them mustn't take it along
+local pgo_dir = path.getabsolute("build/pgo")
+
 workspace "rge_fio"
 	configurations { "Release", "Debug" }
 	location "build"
@@ -9,18 +36,19 @@ workspace "rge_fio"
 	includedirs { "zlib"}
 	includedirs { "src" }
 
-project "rge_fio"
-	kind "ConsoleApp"
-	language "C"
-	targetname "rge_fio"
-	targetdir "bin/%{cfg.buildcfg}"
-
 	defines { "Z_SOLO" }
 
 	configuration { "gmake" }
 		linkoptions { '-static-libstdc++', '-static-libgcc' }
+		links { "pthread" }
 		entrypoint ("main")
 
+	configuration { "gmake", "io-uring" }
+		defines { "RGE_IO_URING" }
+
+	configuration { "deflate-stats" }
+		defines { "RGE_DEFLATE_STATS" }
+
 	configuration { "vs*" }
 		characterset ("MBCS")
 		toolset ("v141_xp")
@@ -44,3 +72,99 @@ project "rge_fio"
 		runtime "release"
 		staticruntime "on"
 		flags { "LinkTimeOptimization" }
+
+	-- atomic counters since b, d and --pipelined count from several threads, the tools left out of the training get no profile and a warning
+	filter { "configurations:Release", "options:pgo=generate", "action:gmake*" }
+		buildoptions { "-fprofile-generate=" .. pgo_dir, "-fprofile-update=atomic" }
+		linkoptions { "-fprofile-generate=" .. pgo_dir }
+
+	filter { "configurations:Release", "options:pgo=use", "action:gmake*" }
+		buildoptions { "-fprofile-use=" .. pgo_dir, "-fprofile-correction", "-Wno-missing-profile" }
+
+	-- the .pgd and .pgc files go next to the exe
+	filter { "configurations:Release", "options:pgo=generate", "action:vs*" }
+		linkoptions { "/LTCG:PGInstrument" }
+
+	filter { "configurations:Release", "options:pgo=use", "action:vs*" }
+		linkoptions { "/LTCG:PGOptimize" }
+
+	filter {}
+
+project "rge_fio"
+	kind "ConsoleApp"
+	language "C"
+	targetname "rge_fio"
+	targetdir "bin/%{cfg.buildcfg}"
+
+-- the C API of src/rge_fio_lib.h for programs that want rge_fio in process, a static library and a shared one with only that API exported
+project "rge_fio_static"
+	kind "StaticLib"
+	language "C"
+	targetname "rge_fio_static"
+	targetdir "bin/%{cfg.buildcfg}"
+	pic "On"
+
+	removefiles { "src/main.c" }
+	defines { "RGE_FIO_BUILD" }
+
+	-- link time optimized objects only link with the same compiler, and that with it turned on as well
+	removeflags { "LinkTimeOptimization" }
+
+project "rge_fio_shared"
+	kind "SharedLib"
+	language "C"
+	targetname "rge_fio"
+	targetdir "bin/%{cfg.buildcfg}"
+	pic "On"
+
+	removefiles { "src/main.c" }
+	defines { "RGE_FIO_BUILD", "RGE_FIO_SHARED" }
+
+	configuration { "gmake" }
+		buildoptions { "-fvisibility=hidden" }
+
+-- throughput, ratio and memory of the deflate settings and inflate, and of reading and writing at different window sizes
+project "rge_fio_bench"
+	kind "ConsoleApp"
+	language "C"
+	targetname "rge_fio_bench"
+	targetdir "bin/%{cfg.buildcfg}"
+
+	removefiles { "src/main.c" }
+	files { "bench/bench.c" }
+
+	configuration { "vs*" }
+		links { "psapi" }
+
+-- ns per call and per byte of the game deflate's inner functions on their own, deflate.c is compiled into kernels.c for them
+project "rge_fio_kernels"
+	kind "ConsoleApp"
+	language "C"
+	targetname "rge_fio_kernels"
+	targetdir "bin/%{cfg.buildcfg}"
+
+	removefiles { "src/main.c", "src/deflate.c" }
+	files { "bench/kernels.c" }
+
+	configuration { "gmake" }
+		links { "m" }
+
+-- the game deflate against a frozen reference copy of it in bench/ref, byte for byte on a generated and fuzzed corpus at every setting
+project "rge_fio_diff"
+	kind "ConsoleApp"
+	language "C"
+	targetname "rge_fio_diff"
+	targetdir "bin/%{cfg.buildcfg}"
+
+	removefiles { "src/main.c" }
+	files { "bench/diff.c", "bench/ref/*.*" }
+
+-- deterministic corpus for rge_fio_bench, scenario and recorded game like files and the worst cases of deflate
+project "rge_fio_gen"
+	kind "ConsoleApp"
+	language "C"
+	targetname "rge_fio_gen"
+	targetdir "bin/%{cfg.buildcfg}"
+
+	removefiles { "zlib/*.*", "src/*.*" }
+	files { "bench/gen.c" }
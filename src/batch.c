@@ -0,0 +1,504 @@
+#include "thread.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
+#include "rge_fio.h"
+#include "batch.h"
+#include "trace.h"
+
+#define BATCH_MAX_LINE 4096
+#define BATCH_MAX_TOKENS 5
+
+typedef struct batch_queue batch_queue;
+
+struct batch_queue
+{
+	batch_job *jobs;
+	int32 num_jobs;
+	volatile int32 next_job;
+	batch_params *params;
+};
+
+typedef struct batch_worker batch_worker;
+
+struct batch_worker
+{
+	batch_queue *queue;
+	byte *buf; // input of w and uncompressed bytes of r, reused for every job of the worker
+	size_t buf_size;
+	rge_thread thread;
+	bool32 thread_flag;
+};
+
+local char *status_names[] = { "ok", "couldn't open input", "couldn't open output", "inflate error", "deflate error", "write error" }; // indexed by BATCH_*
+
+// takes over the filenames, they're NULL if allocating them failed, and freed if the job can't be added
+local bool32 batch_add_job(batch_job **jobs, int32 *num_jobs, char mode, char *in_filename, char *out_filename, int32 num_uncompressed_bytes, int32 offset)
+{
+	batch_job *new_jobs = in_filename && out_filename ? realloc(*jobs, (*num_jobs + 1) * sizeof(batch_job)) : NULL;
+
+	if (!new_jobs)
+	{
+		rge_free(in_filename);
+		rge_free(out_filename);
+
+		return FALSE;
+	}
+
+	*jobs = new_jobs;
+
+	batch_job *job = &new_jobs[(*num_jobs)++];
+
+	memzero(job, sizeof(batch_job));
+
+	job->mode = mode;
+	job->in_filename = in_filename;
+	job->out_filename = out_filename;
+	job->num_uncompressed_bytes = max(0, num_uncompressed_bytes);
+	job->offset = offset;
+
+	return TRUE;
+}
+
+// splits a line into whitespace separated tokens in place, double quotes keep spaces, stops at a # outside of quotes
+local int32 batch_split(char *line, char **tokens)
+{
+	int32 num_tokens = 0;
+	char *p = line;
+
+	for (ever)
+	{
+		while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+
+		if (!*p || *p == '#') break;
+
+		if (num_tokens == BATCH_MAX_TOKENS) return -1;
+
+		if (*p == '"')
+		{
+			tokens[num_tokens++] = ++p;
+
+			while (*p && *p != '"') p++;
+
+			if (!*p) return -1;
+		}
+		else
+		{
+			tokens[num_tokens++] = p;
+
+			while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+
+			if (!*p) break;
+		}
+
+		*p++ = '\0';
+	}
+
+	return num_tokens;
+}
+
+int32 batch_read_manifest(char *filename, batch_job **jobs)
+{
+	FILE *in = rge_fopen(filename, "r");
+	char line[BATCH_MAX_LINE];
+	int32 num_jobs = 0;
+	int32 line_num = 0;
+
+	*jobs = NULL;
+
+	if (!in)
+	{
+		printf("error: couldn't fopen %s for reading\n", filename);
+
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), in))
+	{
+		char *tokens[BATCH_MAX_TOKENS];
+		int32 num_tokens = batch_split(line, tokens);
+
+		line_num++;
+
+		if (!num_tokens) continue;
+
+		if (num_tokens < 3 || strlen(tokens[0]) != 1 || (*tokens[0] != 'r' && *tokens[0] != 'w'))
+		{
+			printf("error: line %d of %s isn't r/w <in> <out> [num uncompressed bytes at start] [offset]\n", line_num, filename);
+
+			rge_fclose(in);
+			batch_free_jobs(*jobs, num_jobs);
+			*jobs = NULL;
+
+			return -1;
+		}
+
+		char *in_filename = strdup(tokens[1]);
+		char *out_filename = strdup(tokens[2]);
+		int32 num_uncompressed_bytes = num_tokens > 3 ? atoi(tokens[3]) : 0;
+		int32 offset = num_tokens > 4 ? atoi(tokens[4]) : -1;
+
+		if (!batch_add_job(jobs, &num_jobs, *tokens[0], in_filename, out_filename, num_uncompressed_bytes, offset))
+		{
+			printf("error: out of memory\n");
+
+			rge_fclose(in);
+			batch_free_jobs(*jobs, num_jobs);
+			*jobs = NULL;
+
+			return -1;
+		}
+	}
+
+	rge_fclose(in);
+
+	return num_jobs;
+}
+
+// * matches any number of characters, ? a single one
+local bool32 batch_match(char *pattern, char *name)
+{
+	if (*pattern == '*')
+	{
+		for (ever)
+		{
+			if (batch_match(pattern + 1, name)) return TRUE;
+
+			if (!*name++) return FALSE;
+		}
+	}
+
+	if (!*pattern) return !*name;
+
+	if (!*name || (*pattern != '?' && *pattern != *name)) return FALSE;
+
+	return batch_match(pattern + 1, name + 1);
+}
+
+local char *batch_path(char *dir, char *name)
+{
+	size_t size = strlen(dir) + strlen(name) + 2;
+	char *path = malloc(size);
+
+	if (path) snprintf(path, size, "%s/%s", dir, name);
+
+	return path;
+}
+
+local int batch_compare_jobs(const void *a, const void *b)
+{
+	return strcmp(((batch_job *)a)->in_filename, ((batch_job *)b)->in_filename);
+}
+
+int32 batch_find_files(char mode, char *in_dir, char *pattern, char *out_dir, int32 num_uncompressed_bytes, int32 offset, batch_job **jobs)
+{
+	int32 num_jobs = 0;
+	bool32 out_of_memory = FALSE;
+
+	*jobs = NULL;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	char *search = batch_path(in_dir, "*");
+	HANDLE find = FindFirstFileA(search, &data);
+
+	rge_free(search);
+
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		printf("error: couldn't list %s\n", in_dir);
+
+		return -1;
+	}
+
+	do
+	{
+		if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || !batch_match(pattern, data.cFileName)) continue;
+
+		if (!batch_add_job(jobs, &num_jobs, mode, batch_path(in_dir, data.cFileName), batch_path(out_dir, data.cFileName), num_uncompressed_bytes, offset))
+		{
+			out_of_memory = TRUE;
+
+			break;
+		}
+	}
+	while (FindNextFileA(find, &data));
+
+	FindClose(find);
+#else
+	DIR *dir = opendir(in_dir);
+	struct dirent *entry;
+
+	if (!dir)
+	{
+		printf("error: couldn't list %s\n", in_dir);
+
+		return -1;
+	}
+
+	while ((entry = readdir(dir)))
+	{
+		if (!batch_match(pattern, entry->d_name)) continue;
+
+		char *in_filename = batch_path(in_dir, entry->d_name);
+		struct stat st;
+
+		if (!in_filename)
+		{
+			out_of_memory = TRUE;
+
+			break;
+		}
+
+		if (stat(in_filename, &st) || !S_ISREG(st.st_mode))
+		{
+			rge_free(in_filename);
+
+			continue;
+		}
+
+		if (!batch_add_job(jobs, &num_jobs, mode, in_filename, batch_path(out_dir, entry->d_name), num_uncompressed_bytes, offset))
+		{
+			out_of_memory = TRUE;
+
+			break;
+		}
+	}
+
+	closedir(dir);
+#endif
+
+	if (out_of_memory)
+	{
+		printf("error: out of memory\n");
+
+		batch_free_jobs(*jobs, num_jobs);
+		*jobs = NULL;
+
+		return -1;
+	}
+
+	// readdir order is whatever the file system likes
+	if (num_jobs) qsort(*jobs, num_jobs, sizeof(batch_job), batch_compare_jobs);
+
+	return num_jobs;
+}
+
+local byte *batch_buffer(batch_worker *worker, size_t size)
+{
+	if (size > worker->buf_size || !worker->buf)
+	{
+		rge_free(worker->buf);
+
+		worker->buf = malloc(max(size, 1));
+		worker->buf_size = worker->buf ? size : 0;
+	}
+
+	return worker->buf;
+}
+
+local int32 batch_read(batch_worker *worker, batch_job *job)
+{
+	batch_params *params = worker->queue->params;
+	handle h = rge_open_read(job->in_filename, _O_BINARY | params->inflate_flag);
+
+	if (h == INVALID_HANDLE) return BATCH_ERROR_OPEN_IN;
+
+	if (params->dict) rge_set_dictionary(h, params->dict, params->dict_size);
+
+	rge_set_window_size(h, params->window_size);
+
+	FILE *out = rge_fopen(job->out_filename, "wb");
+
+	if (!out)
+	{
+		rge_close(h);
+
+		return BATCH_ERROR_OPEN_OUT;
+	}
+
+	bool32 write_ok = TRUE;
+
+	if (job->offset >= 0) rge_fast_forward(h, job->offset);
+
+	if (job->num_uncompressed_bytes)
+	{
+		byte *uncompressed = batch_buffer(worker, job->num_uncompressed_bytes);
+
+		rge_read_uncompressed(h, uncompressed, job->num_uncompressed_bytes);
+
+		write_ok = fwrite(uncompressed, job->num_uncompressed_bytes, 1, out) == 1;
+	}
+
+	int32 num_decompressed_bytes = 0;
+	void *decompressed = NULL;
+
+	rge_read_error = FALSE;
+
+	rge_read_full(h, &decompressed, &num_decompressed_bytes);
+
+	TRACE_BEGIN(TRACE_WRITE);
+
+	if (num_decompressed_bytes && fwrite(decompressed, num_decompressed_bytes, 1, out) != 1) write_ok = FALSE;
+
+	job->data_size = num_decompressed_bytes;
+
+	rge_free(decompressed);
+
+	if (fclose(out)) write_ok = FALSE;
+
+	TRACE_END(TRACE_WRITE);
+
+	rge_close(h);
+
+	if (rge_read_error) return BATCH_ERROR_INFLATE;
+
+	return write_ok ? BATCH_OK : BATCH_ERROR_WRITE;
+}
+
+local int32 batch_write(batch_worker *worker, batch_job *job)
+{
+	batch_params *params = worker->queue->params;
+
+	// the input first, a missing one shouldn't truncate the output
+	FILE *in = rge_fopen(job->in_filename, "rb");
+
+	if (!in) return BATCH_ERROR_OPEN_IN;
+
+	TRACE_BEGIN(TRACE_READ);
+
+	fseek(in, 0, SEEK_END);
+	size_t size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	byte *data = batch_buffer(worker, size);
+	bool32 read_ok = data && fread(data, size, 1, in) == 1;
+
+	rge_fclose(in);
+
+	TRACE_END(TRACE_READ);
+
+	if (size && !read_ok) return BATCH_ERROR_OPEN_IN;
+
+	handle h;
+
+	if (job->offset >= 0)
+	{
+		h = rge_open_write(job->out_filename, _O_WRONLY | _O_CREAT | _O_BINARY | params->deflate_flag, _S_IREAD | _S_IWRITE);
+
+		if (h != INVALID_HANDLE) rge_fast_forward(h, job->offset);
+	}
+	else
+	{
+		h = rge_open_write(job->out_filename, _O_WRONLY | _O_APPEND | _O_CREAT | _O_TRUNC | _O_BINARY | params->deflate_flag, _S_IREAD | _S_IWRITE);
+	}
+
+	if (h == INVALID_HANDLE) return BATCH_ERROR_OPEN_OUT;
+
+	rge_set_deflate_params(h, params->params.max_compares, params->params.strategy, params->params.greedy_flag);
+
+	if (params->dict) rge_set_dictionary(h, params->dict, params->dict_size);
+
+	rge_set_window_size(h, params->window_size);
+
+	int32 num_uncompressed_bytes = (int32)min((size_t)job->num_uncompressed_bytes, size);
+
+	rge_write_error = FALSE;
+
+	rge_write_uncompressed(h, data, num_uncompressed_bytes);
+	rge_write(h, data + num_uncompressed_bytes, (int32)(size - num_uncompressed_bytes));
+
+	job->data_size = size - num_uncompressed_bytes;
+
+	if (rge_close(h)) rge_write_error = TRUE;
+
+	return rge_write_error ? BATCH_ERROR_WRITE : BATCH_OK;
+}
+
+local void batch_thread(void *arg)
+{
+	batch_worker *worker = (batch_worker *)arg;
+	batch_queue *queue = worker->queue;
+
+	for (ever)
+	{
+		int32 i = rge_atomic_inc(&queue->next_job) - 1;
+
+		if (i >= queue->num_jobs) break;
+
+		batch_job *job = &queue->jobs[i];
+
+		job->status = job->mode == 'r' ? batch_read(worker, job) : batch_write(worker, job);
+	}
+
+	rge_free(worker->buf);
+	rge_free_thread_buffers();
+}
+
+int32 batch_run(batch_job *jobs, int32 num_jobs, batch_params *params, int32 num_threads)
+{
+	batch_queue queue = ZEROMEM;
+
+	queue.jobs = jobs;
+	queue.num_jobs = num_jobs;
+	queue.next_job = 0;
+	queue.params = params;
+
+	num_threads = max(1, min(num_threads, num_jobs));
+
+	batch_worker *workers = calloc(num_threads, sizeof(batch_worker));
+
+	for (int32 i = 0; i < num_threads; i++)
+	{
+		workers[i].queue = &queue;
+	}
+
+	for (int32 i = 1; i < num_threads; i++)
+	{
+		workers[i].thread_flag = rge_thread_create(&workers[i].thread, batch_thread, &workers[i]);
+	}
+
+	batch_thread(&workers[0]);
+
+	for (int32 i = 1; i < num_threads; i++)
+	{
+		if (workers[i].thread_flag) rge_thread_join(&workers[i].thread);
+	}
+
+	rge_free(workers);
+
+	int32 num_failed = 0;
+
+	for (int32 i = 0; i < num_jobs; i++)
+	{
+		batch_job *job = &jobs[i];
+
+		if (job->status == BATCH_OK)
+		{
+			printf("ok     %c %s -> %s, %d + %zu bytes\n", job->mode, job->in_filename, job->out_filename, job->num_uncompressed_bytes, job->data_size);
+		}
+		else
+		{
+			printf("failed %c %s -> %s: %s\n", job->mode, job->in_filename, job->out_filename, status_names[job->status]);
+
+			num_failed++;
+		}
+	}
+
+	printf("%d of %d jobs ok\n", num_jobs - num_failed, num_jobs);
+
+	return num_failed;
+}
+
+void batch_free_jobs(batch_job *jobs, int32 num_jobs)
+{
+	for (int32 i = 0; i < num_jobs; i++)
+	{
+		rge_free(jobs[i].in_filename);
+		rge_free(jobs[i].out_filename);
+	}
+
+	rge_free(jobs);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "main.h"
+
+#include "compress.h"
+
+#define BATCH_OK 0
+#define BATCH_ERROR_OPEN_IN 1
+#define BATCH_ERROR_OPEN_OUT 2
+#define BATCH_ERROR_INFLATE 3
+#define BATCH_ERROR_DEFLATE 4
+#define BATCH_ERROR_WRITE 5
+
+typedef struct batch_job batch_job;
+
+struct batch_job
+{
+	char mode; // r or w, same as the commandline
+	char *in_filename;
+	char *out_filename;
+	int32 num_uncompressed_bytes; // at the start of the compressed file, after the offset
+	int32 offset; // where the compressed file starts, -1 to write a new file
+	int32 status;
+	size_t data_size; // inflated or deflated, without the uncompressed bytes
+};
+
+typedef struct batch_params batch_params;
+
+struct batch_params
+{
+	int32 deflate_flag;
+	int32 inflate_flag;
+	deflate_params params;
+	byte *dict;
+	int32 dict_size;
+	int32 window_size; // rge_set_window_size of every file
+};
+
+// one job per line, r/w <in> <out> [num uncompressed bytes at start] [offset], paths with spaces in double quotes, # starts a comment,
+// returns the number of jobs or -1
+int32 batch_read_manifest(char *filename, batch_job **jobs);
+
+// a job for every file in in_dir whose name matches pattern (* and ?), written to the same name in out_dir, returns the number of jobs or -1
+int32 batch_find_files(char mode, char *in_dir, char *pattern, char *out_dir, int32 num_uncompressed_bytes, int32 offset, batch_job **jobs);
+
+// runs the jobs on num_threads threads and prints a line per job in order, returns the number of failed jobs
+int32 batch_run(batch_job *jobs, int32 num_jobs, batch_params *params, int32 num_threads);
+
+void batch_free_jobs(batch_job *jobs, int32 num_jobs);
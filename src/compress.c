@@ -0,0 +1,48 @@
+#include "compress.h"
+
+local deflate_backend deflate_backends[DEFLATE_NUM_BACKENDS] =
+{
+	{ "game", deflate_buf_size, deflate_init, deflate_data, deflate_deinit, deflate_set_dictionary, deflate_get_stats },
+	{ "fast", zlib_deflate_buf_size, zlib_deflate_init, zlib_deflate_data, zlib_deflate_deinit, zlib_deflate_set_dictionary, zlib_deflate_get_stats },
+	{ "best", best_deflate_buf_size, best_deflate_init, best_deflate_data, best_deflate_deinit, best_deflate_set_dictionary, best_deflate_get_stats },
+};
+
+deflate_backend *deflate_get_backend(int32 backend)
+{
+	if (backend < 0 || backend >= DEFLATE_NUM_BACKENDS) return NULL;
+
+	return &deflate_backends[backend];
+}
+
+int32 deflate_find_backend(char *name)
+{
+	for (int32 i = 0; i < DEFLATE_NUM_BACKENDS; i++)
+	{
+		if (!strcmp(deflate_backends[i].name, name)) return i;
+	}
+
+	return DEFLATE_BACKEND_INVALID;
+}
+
+local inflate_backend inflate_backends[INFLATE_NUM_BACKENDS] =
+{
+	{ "fast", Inf32BufSize, Inf32Decode, Inf32SetDictionary, Inf32DecodeFull, Inf32Deinit },
+	{ "zlib", zlib_inflate_buf_size, zlib_inflate_decode, zlib_inflate_set_dictionary, zlib_inflate_decode_full, zlib_inflate_deinit },
+};
+
+inflate_backend *inflate_get_backend(int32 backend)
+{
+	if (backend < 0 || backend >= INFLATE_NUM_BACKENDS) return NULL;
+
+	return &inflate_backends[backend];
+}
+
+int32 inflate_find_backend(char *name)
+{
+	for (int32 i = 0; i < INFLATE_NUM_BACKENDS; i++)
+	{
+		if (!strcmp(inflate_backends[i].name, name)) return i;
+	}
+
+	return INFLATE_BACKEND_INVALID;
+}
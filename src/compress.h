@@ -6,20 +6,142 @@
 #define INFLATE_EOF -1
 #define INFLATE_ERROR -2
 
+#define INFLATE_FULL_SLACK 0x200 // out_buf of a one-shot decode needs this much room past *out_buf_size
+
+// in-tree inflate
 size_t Inf32BufSize();
 int32 Inf32Decode(byte *in_buf, size_t in_buf_ofs, size_t *in_buf_size, byte *out_buf, size_t out_buf_offset, size_t *out_buf_size, void *_wd, bool32 buffered);
+void Inf32SetDictionary(void *_wd, byte *dict, int32 dict_size); // before the first Inf32Decode, the stream has to be deflated with the same dictionary
+void Inf32Deinit(void *_wd); // nothing to free, it's only there for the backend table
+// one-shot decode of the whole input straight into out_buf, starts the stream when out_buf_ofs is 0, decodes until the end or past *out_buf_size
+// and returns INFLATE_OK in the latter case, call again with a bigger out_buf that holds the output so far, *in_buf_size becomes what's consumed
+int32 Inf32DecodeFull(byte *in_buf, size_t *in_buf_size, byte *out_buf, size_t out_buf_ofs, size_t *out_buf_size, void *_wd);
+int32 Inf32ScanSize(byte *in_buf, size_t in_buf_size, size_t *out_size, void *_wd); // walks the stream without writing anything to get its decompressed size
+// decodes the whole input on up to num_threads threads that each guess where a block starts in their part of it, guesses that turn out wrong
+// are decoded again sequentially, *out_buf is malloc'd and has the output decoded so far on INFLATE_ERROR too
+int32 Inf32DecodeParallel(byte *in_buf, size_t *in_buf_size, byte **out_buf, size_t *out_buf_size, byte *dict, int32 dict_size, int32 num_threads);
+
+// zlib inflate, same interface, slower
+size_t zlib_inflate_buf_size();
+int32 zlib_inflate_decode(byte *in_buf, size_t in_buf_ofs, size_t *in_buf_size, byte *out_buf, size_t out_buf_offset, size_t *out_buf_size, void *_wd, bool32 buffered);
+void zlib_inflate_set_dictionary(void *_wd, byte *dict, int32 dict_size);
+void zlib_inflate_deinit(void *_wd);
+int32 zlib_inflate_decode_full(byte *in_buf, size_t *in_buf_size, byte *out_buf, size_t out_buf_ofs, size_t *out_buf_size, void *_wd);
+
+#define INFLATE_BACKEND_INVALID -1
+#define INFLATE_BACKEND_FAST 0
+#define INFLATE_BACKEND_ZLIB 1
+#define INFLATE_NUM_BACKENDS 2
+
+typedef struct inflate_backend inflate_backend;
+
+struct inflate_backend
+{
+	char *name;
+	size_t (*buf_size)();
+	int32 (*decode)(byte *in_buf, size_t in_buf_ofs, size_t *in_buf_size, byte *out_buf, size_t out_buf_offset, size_t *out_buf_size, void *_wd, bool32 buffered);
+	void (*set_dictionary)(void *_wd, byte *dict, int32 dict_size);
+	int32 (*decode_full)(byte *in_buf, size_t *in_buf_size, byte *out_buf, size_t out_buf_ofs, size_t *out_buf_size, void *_wd);
+	void (*deinit)(void *_wd); // after the last decode of a stream whatever it returned, also on work data that was zeroed and never decoded with
+};
+
+inflate_backend *inflate_get_backend(int32 backend);
+int32 inflate_find_backend(char *name);
 
 #define DEFLATE_STATIC_BLOCKS 0
 #define DEFLATE_DYNAMIC_BLOCKS 1
 #define DEFLATE_ALL_BLOCKS 2
 
+#define DEFLATE_MIN_COMPARE 1
+#define DEFLATE_MAX_COMPARE 1500
 #define DEFLATE_MAX_COMPARES_DEFAULT 75
 
+#define DEFLATE_GREEDY_COMPARE_THRESHOLD 4 // below this greedy uses the flash search which ignores max_compares
+
+typedef struct deflate_params deflate_params;
+
+struct deflate_params
+{
+	int32 max_compares;
+	int32 strategy;
+	bool32 greedy_flag;
+};
+
 #define DEFLATE_INIT 0
 #define DEFLATE_OK 1
 #define DEFLATE_ERROR 2
 
+#define DEFLATE_STATS_RAW_BLOCK 0
+#define DEFLATE_STATS_STATIC_BLOCK 1
+#define DEFLATE_STATS_DYNAMIC_BLOCK 2
+#define DEFLATE_STATS_BLOCK_TYPES 3
+
+#define DEFLATE_STATS_PROBE_BUCKETS 12
+#define DEFLATE_STATS_MAX_LENGTH 258
+#define DEFLATE_STATS_DIST_CODES 30
+
+typedef struct deflate_stats deflate_stats;
+
+// what the game deflate did, only counted when built with RGE_DEFLATE_STATS (premake --deflate-stats) as it costs time
+struct deflate_stats
+{
+	uint64 find_match_calls;
+	uint64 chain_probes; // hash chain entries looked at by find_match
+	uint64 probe_histogram[DEFLATE_STATS_PROBE_BUCKETS]; // find_match calls by chain probes, 0, 1, 2-3, 4-7 and so on
+	uint64 compares_exhausted; // find_match calls that ran out of max_compares before the chain ended
+	uint64 literals;
+	uint64 matches;
+	uint64 match_bytes;
+	uint64 far_min_matches; // length 3 matches 16384 or more back, the game writes them as literals
+	uint64 length_histogram[DEFLATE_STATS_MAX_LENGTH + 1]; // matches by length
+	uint64 distance_histogram[DEFLATE_STATS_DIST_CODES]; // matches by distance code
+	uint64 blocks[DEFLATE_STATS_BLOCK_TYPES]; // by DEFLATE_STATS_*_BLOCK, without the empty one the game ends every stream with
+	uint64 block_bits[DEFLATE_STATS_BLOCK_TYPES]; // output of those blocks, header included
+	uint64 total_bits;
+};
+
+// game deflate, output is bit-exact with the game
 size_t deflate_buf_size();
 int32 deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32));
 int32 deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag);
+int32 deflate_set_dictionary(void *_wd, byte *dict_ofs, int32 dict_size);
 void deflate_deinit(void *_wd);
+bool32 deflate_get_stats(void *_wd, deflate_stats *stats); // any time after init, FALSE when built without RGE_DEFLATE_STATS
+
+// zlib deflate, produces slightly smaller output files and is a lot faster, but isn't bit-exact with the game
+size_t zlib_deflate_buf_size();
+int32 zlib_deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32));
+int32 zlib_deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag);
+int32 zlib_deflate_set_dictionary(void *_wd, byte *dict_ofs, int32 dict_size);
+void zlib_deflate_deinit(void *_wd);
+bool32 zlib_deflate_get_stats(void *_wd, deflate_stats *stats);
+
+// high-ratio deflate with an optimal parse, a lot slower and not bit-exact with the game, only the strategy is used
+size_t best_deflate_buf_size();
+int32 best_deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32));
+int32 best_deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag);
+int32 best_deflate_set_dictionary(void *_wd, byte *dict_ofs, int32 dict_size);
+void best_deflate_deinit(void *_wd);
+bool32 best_deflate_get_stats(void *_wd, deflate_stats *stats);
+
+#define DEFLATE_BACKEND_INVALID -1
+#define DEFLATE_BACKEND_GAME 0
+#define DEFLATE_BACKEND_ZLIB 1
+#define DEFLATE_BACKEND_BEST 2
+#define DEFLATE_NUM_BACKENDS 3
+
+typedef struct deflate_backend deflate_backend;
+
+struct deflate_backend
+{
+	char *name;
+	size_t (*buf_size)();
+	int32 (*init)(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32));
+	int32 (*data)(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag);
+	void (*deinit)(void *_wd);
+	int32 (*set_dictionary)(void *_wd, byte *dict_ofs, int32 dict_size); // between init and the first data, only the last DEFLATE_DICT_SIZE bytes are used
+	bool32 (*get_stats)(void *_wd, deflate_stats *stats); // FALSE if the backend doesn't count anything
+};
+
+deflate_backend *deflate_get_backend(int32 backend);
+int32 deflate_find_backend(char *name);
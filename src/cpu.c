@@ -0,0 +1,235 @@
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#include "cpu.h"
+
+// the newer levels are built into every binary and only run where cpu_detect found them, gcc and clang need to be told per function
+#if defined(CPU_X86) && !defined(_MSC_VER)
+#define CPU_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CPU_TARGET(isa)
+#endif
+
+local cpu_kernels cpu_levels[CPU_NUM_LEVELS] =
+{
+	{ "generic", generic_match_len },
+	{ "sse2", sse2_match_len },
+	{ "avx2", avx2_match_len },
+	{ "avx512", avx512_match_len },
+};
+
+local int32 detected_level = CPU_LEVEL_INVALID;
+local int32 level = CPU_LEVEL_INVALID; // racing threads all set the same
+
+local int32 cpu_ctz(uint64 v)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+
+#ifdef _M_X64
+	_BitScanForward64(&i, v);
+#else
+	if (!_BitScanForward(&i, (uint32)v))
+	{
+		_BitScanForward(&i, (uint32)(v >> 32));
+
+		i += 32;
+	}
+#endif
+
+	return (int32)i;
+#else
+	return __builtin_ctzll(v);
+#endif
+}
+
+// the last few bytes, or all of them where there's nothing wider
+local int32 cpu_match_len_tail(byte *a, byte *b, int32 len, int32 limit)
+{
+	while (len + 8 <= limit)
+	{
+		uint64 x, y;
+
+		memcpy(&x, a + len, sizeof(x));
+		memcpy(&y, b + len, sizeof(y));
+
+		if (x != y) return len + (cpu_ctz(x ^ y) >> 3);
+
+		len += 8;
+	}
+
+	while (len < limit && a[len] == b[len]) len++;
+
+	return len;
+}
+
+int32 generic_match_len(byte *a, byte *b, int32 limit)
+{
+	return cpu_match_len_tail(a, b, 0, limit);
+}
+
+#ifdef CPU_X86
+CPU_TARGET("sse2")
+int32 sse2_match_len(byte *a, byte *b, int32 limit)
+{
+	int32 len = 0;
+
+	for (; len + 16 <= limit; len += 16)
+	{
+		__m128i x = _mm_loadu_si128((__m128i *)(a + len));
+		__m128i y = _mm_loadu_si128((__m128i *)(b + len));
+		uint32 diff = (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xFFFF;
+
+		if (diff) return len + cpu_ctz(diff);
+	}
+
+	return cpu_match_len_tail(a, b, len, limit);
+}
+
+CPU_TARGET("avx2")
+int32 avx2_match_len(byte *a, byte *b, int32 limit)
+{
+	int32 len = 0;
+
+	for (; len + 32 <= limit; len += 32)
+	{
+		__m256i x = _mm256_loadu_si256((__m256i *)(a + len));
+		__m256i y = _mm256_loadu_si256((__m256i *)(b + len));
+		uint32 diff = ~(uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+
+		if (diff) return len + cpu_ctz(diff);
+	}
+
+	return cpu_match_len_tail(a, b, len, limit);
+}
+
+// masked loads don't touch the bytes masked off, so the tail goes in one more compare
+CPU_TARGET("avx512f,avx512bw")
+int32 avx512_match_len(byte *a, byte *b, int32 limit)
+{
+	for (int32 len = 0; len < limit; len += 64)
+	{
+		__mmask64 mask = limit - len >= 64 ? ~(__mmask64)0 : ((__mmask64)1 << (limit - len)) - 1;
+		__m512i x = _mm512_maskz_loadu_epi8(mask, a + len);
+		__m512i y = _mm512_maskz_loadu_epi8(mask, b + len);
+		uint64 diff = _mm512_mask_cmpneq_epi8_mask(mask, x, y);
+
+		if (diff) return len + cpu_ctz(diff);
+	}
+
+	return limit;
+}
+
+local void cpu_id(int32 leaf, int32 subleaf, uint32 regs[4])
+{
+#ifdef _MSC_VER
+	__cpuidex((int *)regs, leaf, subleaf);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// which register states the os saves on a task switch, the cpu having the instructions isn't enough
+local uint64 cpu_xgetbv()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32 lo, hi;
+
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+
+	return ((uint64)hi << 32) | lo;
+#endif
+}
+#else
+int32 sse2_match_len(byte *a, byte *b, int32 limit)
+{
+	return generic_match_len(a, b, limit);
+}
+
+int32 avx2_match_len(byte *a, byte *b, int32 limit)
+{
+	return generic_match_len(a, b, limit);
+}
+
+int32 avx512_match_len(byte *a, byte *b, int32 limit)
+{
+	return generic_match_len(a, b, limit);
+}
+#endif
+
+int32 cpu_detect()
+{
+	if (detected_level != CPU_LEVEL_INVALID) return detected_level;
+
+	int32 best = CPU_LEVEL_GENERIC;
+
+#ifdef CPU_X86
+	uint32 regs[4];
+
+	cpu_id(0, 0, regs);
+
+	uint32 max_leaf = regs[0];
+
+	cpu_id(1, 0, regs);
+
+	bool32 sse2 = (regs[3] >> 26) & 1;
+	bool32 osxsave = (regs[2] >> 27) & 1;
+	bool32 avx = (regs[2] >> 28) & 1;
+	uint64 xcr0 = osxsave ? cpu_xgetbv() : 0;
+	bool32 avx2 = FALSE;
+	bool32 avx512 = FALSE;
+
+	if (max_leaf >= 7)
+	{
+		cpu_id(7, 0, regs);
+
+		// xmm and ymm state, then also the opmask and the upper zmm
+		avx2 = avx && (xcr0 & 0x06) == 0x06 && ((regs[1] >> 5) & 1);
+		avx512 = avx2 && (xcr0 & 0xE6) == 0xE6 && ((regs[1] >> 16) & 1) && ((regs[1] >> 30) & 1);
+	}
+
+	if (sse2) best = CPU_LEVEL_SSE2;
+	if (avx2) best = CPU_LEVEL_AVX2;
+	if (avx512) best = CPU_LEVEL_AVX512;
+#endif
+
+	detected_level = best;
+
+	return best;
+}
+
+void cpu_set_level(int32 new_level)
+{
+	level = min(max(new_level, CPU_LEVEL_GENERIC), cpu_detect());
+}
+
+int32 cpu_get_level()
+{
+	if (level == CPU_LEVEL_INVALID) level = cpu_detect();
+
+	return level;
+}
+
+cpu_kernels *cpu_get_kernels()
+{
+	return &cpu_levels[cpu_get_level()];
+}
+
+int32 cpu_find_level(char *name)
+{
+	for (int32 i = 0; i < CPU_NUM_LEVELS; i++)
+	{
+		if (!strcmp(cpu_levels[i].name, name)) return i;
+	}
+
+	return CPU_LEVEL_INVALID;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "main.h"
+
+#define CPU_LEVEL_INVALID -1
+#define CPU_LEVEL_GENERIC 0
+#define CPU_LEVEL_SSE2 1
+#define CPU_LEVEL_AVX2 2
+#define CPU_LEVEL_AVX512 3
+#define CPU_NUM_LEVELS 4
+
+// how many bytes at a and b are the same from the start, up to limit, nothing past limit is read
+int32 generic_match_len(byte *a, byte *b, int32 limit);
+int32 sse2_match_len(byte *a, byte *b, int32 limit);
+int32 avx2_match_len(byte *a, byte *b, int32 limit);
+int32 avx512_match_len(byte *a, byte *b, int32 limit); // AVX-512BW
+
+typedef struct cpu_kernels cpu_kernels;
+
+// the same results on every level, only faster, only the match extension is here, nothing else measured faster built for the newer levels
+struct cpu_kernels
+{
+	char *name;
+	int32 (*match_len)(byte *a, byte *b, int32 limit);
+};
+
+int32 cpu_detect(); // the best level the cpu and the os both support, generic on anything but x86
+void cpu_set_level(int32 level); // at most this level from now on, capped by what cpu_detect says, to compare or check the others
+int32 cpu_get_level();
+cpu_kernels *cpu_get_kernels(); // picked at the first call from what cpu_detect says
+int32 cpu_find_level(char *name);
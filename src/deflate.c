@@ -1,140 +1,6 @@
-// use zlib deflate instead of game deflate, produces slightly smaller output files and is a lot faster,
-// but uses more than infile size memory vs a fixed UINT16_MAX buffer size
-// #define USE_ZLIB_DEFLATE
-
-#ifdef USE_ZLIB_DEFLATE
-#include <zlib.h>
-#endif
-
 #include "compress.h"
-
-#ifdef USE_ZLIB_DEFLATE
-local void *zalloc(void *opaque, uint32 items, uint32 size)
-{
-	return calloc(size, items);
-};
-
-local void zfree(void *opaque, void *address)
-{
-	free(address);
-}
-
-local z_stream deflate_stream = ZEROMEM;
-local int32 deflate_code;
-
-local byte *buffer = NULL;
-local size_t buffer_len = 0;
-
-#define DEFAULT_ALLOC 0x10000
-
-local byte *data = NULL;
-local size_t data_alloc = 0;
-local size_t data_pos = 0;
-
-local int32 (*flush_out_buf)(byte *out_buf_ofs, int32 out_buf_size) = NULL;
-
-size_t deflate_buf_size()
-{
-	return 0;
-}
-
-int32 deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32))
-{
-	buffer = out_buf_ofs;
-	buffer_len = out_buf_size;
-	flush_out_buf = out_buf_flush;
-
-	data_alloc = DEFAULT_ALLOC;
-	data = malloc(DEFAULT_ALLOC);
-	data_pos = 0;
-
-	return DEFLATE_INIT;
-}
-
-int32 deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag)
-{
-	if (!eof_flag)
-	{
-		if (data_pos + in_buf_size > data_alloc)
-		{
-			size_t new_alloc = (data_alloc * 2) + in_buf_size;
-			byte *new_data = malloc(new_alloc);
-
-			memcpy(new_data, data, data_alloc);
-			rge_free(data);
-
-			data_alloc = new_alloc;
-			data = new_data;
-		}
-
-		memcpy(data + data_pos, in_buf_ofs, in_buf_size);
-
-		data_pos += in_buf_size;
-	}
-	else
-	{
-		memzero(&deflate_stream, sizeof(deflate_stream));
-
-		deflate_stream.zalloc = zalloc;
-		deflate_stream.zfree = zfree;
-
-		deflate_stream.next_in = data;
-		deflate_stream.avail_in = data_pos + 1;
-
-		deflate_code = deflateInit2(&deflate_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
-
-		if (deflate_code != Z_OK)
-		{
-			printf("deflate error %d: %s\n", deflate_code, deflate_stream.msg);
-
-			return DEFLATE_ERROR;
-		}
-
-		while (deflate_code == Z_OK)
-		{
-			memzero(buffer, buffer_len);
-
-			deflate_stream.next_out = buffer;
-			deflate_stream.avail_out = buffer_len;
-
-			deflate_code = deflate(&deflate_stream, Z_FINISH);
-
-			if (deflate_code == Z_OK || deflate_code == Z_STREAM_END)
-			{
-				flush_out_buf(buffer, buffer_len - deflate_stream.avail_out);
-			}
-			else
-			{
-				printf("deflate error %d: %s\n", deflate_code, deflate_stream.msg);
-
-				deflateEnd(&deflate_stream);
-
-				return DEFLATE_ERROR;
-			}
-		}
-
-		deflateEnd(&deflate_stream);
-	}
-
-	return DEFLATE_OK;
-}
-
-void deflate_deinit(void *_wd)
-{
-	buffer = NULL;
-	buffer_len = 0;
-
-	rge_free(data);
-	data_alloc = 0;
-	data_pos = 0;
-}
-#else
 #include "deflate.h"
-
-#define DEFLATE_MIN_COMPARE 1
-#define DEFLATE_MAX_COMPARE 1500
-
-#define DEFLATE_GREEDY_COMPARE_THRESHOLD 4
+#include "trace.h"
 
 #define DEFLATE_SIG_INIT 0x12345678
 #define DEFLATE_SIG_DONE 0xABCD1234
@@ -153,6 +19,7 @@ void deflate_deinit(void *_wd)
 	*wd->token_buf_ofs++ = dict[wd->search_offset++]; \
 	wd->search_bytes_left--; \
 	wd->token_buf_bytes++; \
+	DEFLATE_STAT(wd->stats.literals++); \
 	FLAG(0); \
 } while(0)
 
@@ -163,34 +30,35 @@ void deflate_deinit(void *_wd)
 	wd->search_offset += (len); \
 	wd->search_bytes_left -= (len); \
 	wd->token_buf_bytes += (len); \
+	DEFLATE_STAT(stats_match(len, dist)); \
 	FLAG(1); \
 } while(0)
 
-local work_data *wd = NULL;
+local thread_local work_data *wd = NULL;
 
-local byte *dict = NULL;
-local uint16 *hash = NULL;
-local uint16 *next = NULL;
-local uint16 *last = NULL;
+local thread_local byte *dict = NULL;
+local thread_local uint16 *hash = NULL;
+local thread_local uint16 *next = NULL;
+local thread_local uint16 *last = NULL;
 
-local int32 max_compares = 0;
-local int32 match_len = 0;
-local uint32 match_pos = 0;
+local thread_local int32 max_compares = 0;
+local thread_local int32 match_len = 0;
+local thread_local uint32 match_pos = 0;
 
-local uint32 bit_buf = 0;
-local int32 bit_buf_len = 0;
-local bool32 bit_buf_total_flag = 0;
+local thread_local uint32 bit_buf = 0;
+local thread_local int32 bit_buf_len = 0;
+local thread_local bool32 bit_buf_total_flag = 0;
 
-local byte *out_buf_cur_ofs = NULL;
-local int32 out_buf_left = 0;
+local thread_local byte *out_buf_cur_ofs = NULL;
+local thread_local int32 out_buf_left = 0;
 
-local int32 code_list_len = 0;
-local int32 num_codes[33] = ZEROMEM;
-local int32 next_code[33] = ZEROMEM;
-local int32 new_code_sizes[DEFLATE_MAX_SYMBOLS] = ZEROMEM;
-local int32 code_list[DEFLATE_MAX_SYMBOLS] = ZEROMEM;
-local int32 others[DEFLATE_MAX_SYMBOLS] = ZEROMEM;
-local int32 heap[DEFLATE_MAX_SYMBOLS + 1] = ZEROMEM;
+local thread_local int32 code_list_len = 0;
+local thread_local int32 num_codes[33] = ZEROMEM;
+local thread_local int32 next_code[33] = ZEROMEM;
+local thread_local int32 new_code_sizes[DEFLATE_MAX_SYMBOLS] = ZEROMEM;
+local thread_local int32 code_list[DEFLATE_MAX_SYMBOLS] = ZEROMEM;
+local thread_local int32 others[DEFLATE_MAX_SYMBOLS] = ZEROMEM;
+local thread_local int32 heap[DEFLATE_MAX_SYMBOLS + 1] = ZEROMEM;
 
 local void int_set(int32 *dst, int32 dat, size_t len);
 local void uint_set(uint32 *dst, uint32 dat, size_t len);
@@ -215,6 +83,7 @@ local bool32 send_raw_block();
 local void init_static_block();
 local void init_dynamic_block();
 
+local bool32 code_tokens();
 local bool32 code_block();
 local bool32 code_token_buf(bool32 last_block_flag);
 
@@ -239,6 +108,42 @@ local bool32 dict_fill();
 local void deflate_main_init();
 local int32 deflate_main();
 
+#ifdef RGE_DEFLATE_STATS
+local uint64 stats_bit_pos()
+{
+	return (wd->out_bytes + (out_buf_cur_ofs - wd->out_buf_ofs)) * 8 + bit_buf_len;
+}
+
+local void stats_find_match(int32 num_probes)
+{
+	int32 bucket = 0;
+
+	while (bucket < DEFLATE_STATS_PROBE_BUCKETS - 1 && num_probes >> bucket) bucket++;
+
+	wd->stats.find_match_calls++;
+	wd->stats.chain_probes += num_probes;
+	wd->stats.probe_histogram[bucket]++;
+}
+
+local void stats_match(int32 len, int32 dist)
+{
+	uint32 match_dist = dist - 1;
+
+	wd->stats.matches++;
+	wd->stats.match_bytes += len;
+	wd->stats.length_histogram[len]++;
+	wd->stats.distance_histogram[match_dist < 512 ? dist_lo_code[match_dist] : dist_hi_code[match_dist >> 8]]++;
+}
+
+local void stats_block(int32 type)
+{
+	uint64 bits = stats_bit_pos() - wd->block_start;
+
+	wd->stats.blocks[type]++;
+	wd->stats.block_bits[type] += bits;
+}
+#endif
+
 local void int_set(int32 *dst, int32 dat, size_t len)
 {
 	while (len--) dst[len] = dat;
@@ -734,6 +639,8 @@ local bool32 send_raw_block()
 
 local void init_dynamic_block()
 {
+	TRACE_BEGIN(TRACE_DYNAMIC_BLOCK);
+
 	int_set(wd->freq_1, 0, DEFLATE_NUM_SYMBOLS_1);
 	int_set(wd->freq_2, 0, DEFLATE_NUM_SYMBOLS_2);
 
@@ -789,6 +696,8 @@ local void init_dynamic_block()
 	huff_make_codes(DEFLATE_NUM_SYMBOLS_2, wd->size_2, 15, wd->code_2);
 
 	init_compress_code_sizes();
+
+	TRACE_END(TRACE_DYNAMIC_BLOCK);
 }
 
 local void init_static_block()
@@ -807,7 +716,7 @@ local void init_static_block()
 	huff_make_codes(DEFLATE_NUM_SYMBOLS_2, wd->size_2, 15, wd->code_2);
 }
 
-local bool32 code_block()
+local bool32 code_tokens()
 {
 	byte *token_ptr = wd->token_buf;
 	uint32 flag_left = 0;
@@ -862,12 +771,25 @@ local bool32 code_block()
 	return put_bits(wd->code_1[256], wd->size_1[256]) != FALSE;
 }
 
+local bool32 code_block()
+{
+	TRACE_BEGIN(TRACE_CODE_BLOCK);
+
+	bool32 error = code_tokens();
+
+	TRACE_END(TRACE_CODE_BLOCK);
+
+	return error;
+}
+
 local bool32 code_token_buf(bool32 last_block_flag)
 {
 	wd->token_buf_end = wd->search_offset;
 
 	if (wd->token_buf_len)
 	{
+		DEFLATE_STAT(wd->block_start = stats_bit_pos());
+
 		if (put_bits(0, 1)) return TRUE;
 
 		if (wd->strategy == DEFLATE_STATIC_BLOCKS)
@@ -876,6 +798,8 @@ local bool32 code_token_buf(bool32 last_block_flag)
 
 			if (send_static_block()) return TRUE;
 			if (code_block()) return TRUE;
+
+			DEFLATE_STAT(stats_block(DEFLATE_STATS_STATIC_BLOCK));
 		}
 		else if (wd->strategy == DEFLATE_DYNAMIC_BLOCKS)
 		{
@@ -883,6 +807,8 @@ local bool32 code_token_buf(bool32 last_block_flag)
 
 			if (send_dynamic_block()) return TRUE;
 			if (code_block()) return TRUE;
+
+			DEFLATE_STAT(stats_block(DEFLATE_STATS_DYNAMIC_BLOCK));
 		}
 		else if (wd->token_buf_len < 128)
 		{
@@ -915,6 +841,8 @@ local bool32 code_token_buf(bool32 last_block_flag)
 			if (raw_bits < static_bits && raw_bits < dynamic_bits)
 			{
 				if (send_raw_block()) return TRUE;
+
+				DEFLATE_STAT(stats_block(DEFLATE_STATS_RAW_BLOCK));
 			}
 			else
 			{
@@ -924,11 +852,15 @@ local bool32 code_token_buf(bool32 last_block_flag)
 
 					if (send_static_block()) return TRUE;
 					if (code_block()) return TRUE;
+
+					DEFLATE_STAT(stats_block(DEFLATE_STATS_STATIC_BLOCK));
 				}
 				else
 				{
 					if (send_dynamic_block()) return TRUE;
 					if (code_block()) return TRUE;
+
+					DEFLATE_STAT(stats_block(DEFLATE_STATS_DYNAMIC_BLOCK));
 				}
 			}
 		}
@@ -940,6 +872,8 @@ local bool32 code_token_buf(bool32 last_block_flag)
 
 				if (send_dynamic_block()) return TRUE;
 				if (code_block()) return TRUE;
+
+				DEFLATE_STAT(stats_block(DEFLATE_STATS_DYNAMIC_BLOCK));
 			}
 			else
 			{
@@ -964,11 +898,15 @@ local bool32 code_token_buf(bool32 last_block_flag)
 				if (raw_bits < dynamic_bits)
 				{
 					if (send_raw_block()) return TRUE;
+
+					DEFLATE_STAT(stats_block(DEFLATE_STATS_RAW_BLOCK));
 				}
 				else
 				{
 					if (send_dynamic_block()) return TRUE;
 					if (code_block()) return TRUE;
+
+					DEFLATE_STAT(stats_block(DEFLATE_STATS_DYNAMIC_BLOCK));
 				}
 			}
 		}
@@ -995,6 +933,8 @@ local bool32 code_token_buf(bool32 last_block_flag)
 
 local void delete_data(int32 dict_pos)
 {
+	TRACE_BEGIN(TRACE_DELETE);
+
 	uint32 k = dict_pos + DEFLATE_SECTOR_SIZE;
 
 	for (uint32 i = dict_pos; i < k; i++)
@@ -1010,10 +950,14 @@ local void delete_data(int32 dict_pos)
 			next[j] = DEFLATE_NIL;
 		}
 	}
+
+	TRACE_END(TRACE_DELETE);
 }
 
 local void hash_data(int32 dict_pos, int32 bytes_to_do)
 {
+	TRACE_BEGIN(TRACE_HASH);
+
 	uint32 i = max(0, bytes_to_do - DEFLATE_THRESHOLD);
 
 	if (i < (uint32)bytes_to_do)
@@ -1040,6 +984,8 @@ local void hash_data(int32 dict_pos, int32 bytes_to_do)
 			hash[j] = i;
 		}
 	}
+
+	TRACE_END(TRACE_HASH);
 }
 
 local void find_match(int32 dict_pos)
@@ -1053,57 +999,45 @@ local void find_match(int32 dict_pos)
 
 	int32 compares_left = max_compares;
 	uint16 probe_pos = dict_pos & (DEFLATE_DICT_SIZE - 1);
+	int32 (*match_len_fn)(byte *, byte *, int32) = wd->kernels->match_len;
 
 	for (ever)
 	{
 		for (ever)
 		{
-			if (compares_left <= 0) return;
+			if (compares_left <= 0) goto exhausted;
 
 			compares_left--;
 			probe_pos = next[probe_pos];
-			if (probe_pos == DEFLATE_NIL) return;
+			if (probe_pos == DEFLATE_NIL) goto done;
 
 			if (read_word(&s[probe_pos]) == l) break;
 
 			compares_left--;
 			probe_pos = next[probe_pos];
-			if (probe_pos == DEFLATE_NIL) return;
+			if (probe_pos == DEFLATE_NIL) goto done;
 
 			if (read_word(&s[probe_pos]) == l) break;
 
 			compares_left--;
 			probe_pos = next[probe_pos];
-			if (probe_pos == DEFLATE_NIL) return;
+			if (probe_pos == DEFLATE_NIL) goto done;
 
 			if (read_word(&s[probe_pos]) == l) break;
 
 			compares_left--;
 			probe_pos = next[probe_pos];
-			if (probe_pos == DEFLATE_NIL) return;
+			if (probe_pos == DEFLATE_NIL) goto done;
 
 			if (read_word(&s[probe_pos]) == l) break;
 		}
 
 		if (read_word(&dict[probe_pos]) != m) continue;
 
-		uint16 *p = r;
-		uint16 *q = (uint16 *)&dict[probe_pos];
-
-		int32 probe_len = 32;
+		// the game compares a word at a time up to 258, which comes to the same as the first byte that differs
+		int32 probe_len = match_len_fn((byte *)r, &dict[probe_pos], DEFLATE_MAX_MATCH);
 
-		do
-		{
-		}
-		while (read_word(++p) == read_word(++q)
-			&& read_word(++p) == read_word(++q)
-			&& read_word(++p) == read_word(++q)
-			&& read_word(++p) == read_word(++q)
-			&& --probe_len > 0);
-
-		if (!probe_len) goto max_match;
-
-		probe_len = ((p - r) * 2) + (*(byte *)p == *(byte *)q); // read_word doesn't work???
+		if (probe_len == DEFLATE_MAX_MATCH) goto max_match;
 
 		if (probe_len > match_len)
 		{
@@ -1115,11 +1049,19 @@ local void find_match(int32 dict_pos)
 		}
 	}
 
+exhausted:;
+	DEFLATE_STAT(wd->stats.compares_exhausted++);
+
+done:;
+	DEFLATE_STAT(stats_find_match(max_compares - compares_left));
+
 	return;
 
 max_match:;
 	match_pos = probe_pos;
 	match_len = DEFLATE_MAX_MATCH;
+
+	DEFLATE_STAT(stats_find_match(max_compares - compares_left));
 }
 
 local bool32 empty_flag_buf()
@@ -1157,7 +1099,15 @@ local bool32 flush_flag_buf()
 
 local bool32 flush_out_buffer()
 {
-	if (wd->flush_out_buf(wd->out_buf_ofs, wd->out_buf_size - out_buf_left)) return TRUE;
+	TRACE_BEGIN(TRACE_FLUSH);
+
+	bool32 error = wd->flush_out_buf(wd->out_buf_ofs, wd->out_buf_size - out_buf_left) != 0;
+
+	TRACE_END(TRACE_FLUSH);
+
+	if (error) return TRUE;
+
+	DEFLATE_STAT(wd->out_bytes += wd->out_buf_size - out_buf_left);
 
 	out_buf_cur_ofs = wd->out_buf_ofs;
 	out_buf_left = wd->out_buf_size;
@@ -1280,6 +1230,8 @@ local bool32 dict_search_lazy()
 
 		if (match_len == DEFLATE_MIN_MATCH && match_dist >= 16384)
 		{
+			DEFLATE_STAT(wd->stats.far_min_matches++);
+
 			CHAR;
 		}
 		else
@@ -1306,31 +1258,10 @@ local bool32 dict_search_flash()
 			continue;
 		}
 
-		uint16 *p = (uint16 *)&dict[match_pos];
-		uint16 *q = (uint16 *)&dict[wd->search_offset];
-
-		if (read_word(p) == read_word(q))
+		if (read_word(&dict[match_pos]) == read_word(&dict[wd->search_offset]))
 		{
-			match_len = 32;
-
-			do
-			{
-			}
-			while (read_word(++p) == read_word(++q)
-				&& read_word(++p) == read_word(++q)
-				&& read_word(++p) == read_word(++q)
-				&& read_word(++p) == read_word(++q)
-				&& --match_len > 0);
-
-			if (match_len)
-			{
-				// match_len = ((byte)(*(byte *)dict_search_offset - *(byte *)dict_match_pos) < 1) + (((byte *)dict_match_pos - match_pos - dict) & 0xFFFFFFFE);
-				match_len = ((byte)(*q - *p) < 1) + (byte)((byte *)p - match_pos - dict);
-			}
-			else
-			{
-				match_len = DEFLATE_MAX_MATCH;
-			}
+			// same as in find_match, the game's word compare up to 258 is the first byte that differs
+			match_len = wd->kernels->match_len(&dict[match_pos], &dict[wd->search_offset], DEFLATE_MAX_MATCH);
 
 			if (match_len > wd->search_bytes_left)
 			{
@@ -1348,6 +1279,8 @@ local bool32 dict_search_flash()
 
 			if (match_len == DEFLATE_MIN_MATCH && match_dist >= 16384)
 			{
+				DEFLATE_STAT(wd->stats.far_min_matches++);
+
 				CHAR;
 			}
 			else
@@ -1404,6 +1337,8 @@ local bool32 dict_search_greedy()
 
 		if (match_len == DEFLATE_MIN_MATCH && match_dist >= 16384)
 		{
+			DEFLATE_STAT(wd->stats.far_min_matches++);
+
 			CHAR;
 		}
 		else
@@ -1419,19 +1354,29 @@ local bool32 dict_search_greedy()
 
 local bool32 dict_search()
 {
+	bool32 error;
+
+	TRACE_BEGIN(TRACE_SEARCH);
+
 	if (wd->greedy_flag)
 	{
 		if (max_compares < DEFLATE_GREEDY_COMPARE_THRESHOLD)
 		{
-			return dict_search_flash();
+			error = dict_search_flash();
 		}
 		else
 		{
-			return dict_search_greedy();
+			error = dict_search_greedy();
 		}
 	}
+	else
+	{
+		error = dict_search_lazy();
+	}
+
+	TRACE_END(TRACE_SEARCH);
 
-	return dict_search_lazy();
+	return error;
 }
 
 local bool32 dict_search_main(int32 dict_ofs)
@@ -1512,10 +1457,9 @@ local int32 deflate_main()
 
 		if (wd->eof_flag && !wd->in_buf_left)
 		{
-			if (!dict_search_eof() && !flush_flag_buf() && !flush_bits() && !flush_out_buffer())
-			{
-				wd->sig = DEFLATE_SIG_DONE;
-			}
+			if (dict_search_eof() || flush_flag_buf() || flush_bits() || flush_out_buffer()) return DEFLATE_ERROR;
+
+			wd->sig = DEFLATE_SIG_DONE;
 
 			return DEFLATE_OK;
 		}
@@ -1523,7 +1467,10 @@ local int32 deflate_main()
 		wd->search_bytes_left = 0;
 	}
 
-	return DEFLATE_OK;
+	// out_buf_flush failed, stop here
+	wd->sig = DEFLATE_SIG_DONE;
+
+	return DEFLATE_ERROR;
 }
 
 size_t deflate_buf_size()
@@ -1553,6 +1500,10 @@ int32 deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_
 	wd->saved_out_buf_left = wd->out_buf_size;
 	wd->flush_out_buf = out_buf_flush;
 	wd->main_read_left = 4096;
+	wd->kernels = cpu_get_kernels();
+
+	DEFLATE_STAT(memzero(&wd->stats, sizeof(deflate_stats)));
+	DEFLATE_STAT(wd->out_bytes = 0);
 
 	deflate_main_init();
 
@@ -1602,10 +1553,57 @@ int32 deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_fl
 	return status;
 }
 
+// primes the ring buffer so it ends with the dictionary and the data follows right after it, like the inflate side sees it,
+// the sectors the dictionary is in get deleted from the hash chains once the data wraps into them
+int32 deflate_set_dictionary(void *_wd, byte *dict_ofs, int32 dict_size)
+{
+	wd = (work_data *)_wd;
+
+	if (!wd || wd->sig != DEFLATE_SIG_INIT || wd->main_read_pos || wd->main_dict_pos || wd->main_del_flag) return DEFLATE_ERROR;
+
+	if (dict_size <= 0) return DEFLATE_OK;
+
+	if (dict_size > DEFLATE_DICT_SIZE)
+	{
+		dict_ofs += dict_size - DEFLATE_DICT_SIZE;
+		dict_size = DEFLATE_DICT_SIZE;
+	}
+
+	dict = wd->dict;
+	hash = wd->hash;
+	next = wd->next;
+	last = wd->last;
+
+	mem_copy(dict + DEFLATE_DICT_SIZE - dict_size, dict_ofs, dict_size);
+
+	hash_data(DEFLATE_DICT_SIZE - dict_size, dict_size);
+
+	wd->main_del_flag = TRUE;
+
+	return DEFLATE_OK;
+}
+
 void deflate_deinit(void *_wd)
 {
 	wd = (work_data *)_wd;
 
 	wd->sig = DEFLATE_SIG_DONE;
 }
+
+bool32 deflate_get_stats(void *_wd, deflate_stats *stats)
+{
+#ifdef RGE_DEFLATE_STATS
+	work_data *stats_wd = (work_data *)_wd;
+
+	*stats = stats_wd->stats;
+
+	// the position deflate_data left off at
+	stats->total_bits = (stats_wd->out_bytes + (stats_wd->saved_out_buf_cur_ofs - stats_wd->out_buf_ofs)) * 8 + stats_wd->saved_bit_buf_len;
+
+	return TRUE;
+#else
+	memzero(stats, sizeof(deflate_stats));
+
+	return FALSE;
 #endif
+}
@@ -3,6 +3,7 @@
 #include "main.h"
 
 #include "defs.h"
+#include "cpu.h"
 
 #define DEFLATE_MIN_MATCH 3
 #define DEFLATE_THRESHOLD (DEFLATE_MIN_MATCH - 1)
@@ -31,6 +32,12 @@
 
 #define DEFLATE_NIL 0xFFFFui16
 
+#ifdef RGE_DEFLATE_STATS
+#define DEFLATE_STAT(x) do { x; } while(0)
+#else
+#define DEFLATE_STAT(x) do { } while(0)
+#endif
+
 typedef struct work_data work_data;
 
 struct work_data
@@ -88,5 +95,11 @@ struct work_data
 	int32 (*flush_out_buf)(byte *, int32);
 	byte *saved_out_buf_cur_ofs;
 	int32 saved_out_buf_left;
+	cpu_kernels *kernels; // picked at init, the stream can move to another thread
 	uint32 sig;
+#ifdef RGE_DEFLATE_STATS
+	deflate_stats stats;
+	uint64 out_bytes; // flushed so far, for the bit position of a block
+	uint64 block_start; // bit position the current block started at
+#endif
 };
@@ -0,0 +1,1364 @@
+#include "compress.h"
+#include "deflate.h"
+
+// high-ratio deflate: hash chain match finder, iterative cost model optimal parse and block splitting,
+// output is standard raw deflate the game inflates just fine, but it's slower and not bit-exact with the game
+
+#define BEST_WINDOW_SIZE DEFLATE_DICT_SIZE
+#define BEST_CHUNK_SIZE 0x40000 // input parsed in one go
+#define BEST_BUF_SIZE (BEST_WINDOW_SIZE + BEST_CHUNK_SIZE)
+#define BEST_BUF_SLACK 16 // match compares read a word past the end
+
+#define BEST_HASH_BITS 15
+#define BEST_HASH_SIZE (1 << BEST_HASH_BITS)
+#define BEST_MAX_DEPTH 512
+#define BEST_NICE_MATCH DEFLATE_MAX_MATCH // positions covered by a match this long aren't searched
+
+#define BEST_CHUNK_PASSES 2 // optimal parse passes over a whole chunk before splitting it into blocks
+#define BEST_BLOCK_PASSES 2 // optimal parse passes over each block with the block's own cost model
+#define BEST_SPLIT_BYTES 0x1000 // block splitting granularity
+#define BEST_UNUSED_COST 12 // bits assumed for symbols the cost model hasn't seen yet
+#define BEST_RLE_PASSES 2 // code size run-length coding passes, each with the code length code of the previous one
+
+#define BEST_NUM_LIT_LEN 286
+#define BEST_NUM_DIST 30
+#define BEST_MAX_RLE (DEFLATE_NUM_SYMBOLS_1 + DEFLATE_NUM_SYMBOLS_2)
+#define BEST_MAX_CODE_SIZE 15
+#define BEST_MAX_RLE_CODE_SIZE 7
+#define BEST_MAX_STORED 0xFFFF
+
+#define BEST_NIL -1
+
+typedef struct best_match best_match;
+
+struct best_match
+{
+	uint16 len; // literal byte if dist is 0
+	uint16 dist;
+};
+
+typedef struct best_rle best_rle;
+
+struct best_rle
+{
+	byte sym[BEST_MAX_RLE];
+	byte extra[BEST_MAX_RLE];
+	int32 len;
+	int32 size_3[DEFLATE_NUM_SYMBOLS_3];
+	int32 bit_lengths;
+	uint32 bits; // whole header
+};
+
+typedef struct best_block best_block;
+
+struct best_block
+{
+	int32 freq_1[DEFLATE_NUM_SYMBOLS_1];
+	int32 freq_2[DEFLATE_NUM_SYMBOLS_2];
+	int32 size_1[DEFLATE_NUM_SYMBOLS_1];
+	int32 size_2[DEFLATE_NUM_SYMBOLS_2];
+	uint32 code_1[DEFLATE_NUM_SYMBOLS_1];
+	uint32 code_2[DEFLATE_NUM_SYMBOLS_2];
+	uint32 code_3[DEFLATE_NUM_SYMBOLS_3];
+	int32 used_lit_codes;
+	int32 used_dist_codes;
+	best_rle rle;
+};
+
+typedef struct best_work_data best_work_data;
+
+struct best_work_data
+{
+	byte *buf; // BEST_WINDOW_SIZE history followed by the chunk being filled
+	int32 buf_start;
+	int32 buf_fill;
+	int32 hash_end; // positions before it are in the hash chains already
+	int32 *head;
+	int32 *prev;
+	uint32 *match_ofs;
+	best_match *matches;
+	int32 matches_alloc;
+	uint32 *cost;
+	best_match *choice;
+	best_match *tokens;
+	best_match *block_tokens; // the tokens still open from the previous chunk come first
+	int32 num_open_tokens;
+	int32 strategy;
+	uint32 lit_len_cost[DEFLATE_NUM_SYMBOLS_1];
+	uint32 dist_cost[DEFLATE_NUM_SYMBOLS_2];
+	uint32 len_cost[DEFLATE_MAX_MATCH + 1];
+	best_block block;
+	best_block temp_block;
+	uint64 bit_buf;
+	int32 bit_buf_len;
+	byte *out_buf_ofs;
+	int32 out_buf_size;
+	int32 out_buf_pos;
+	int32 (*flush_out_buf)(byte *, int32);
+	bool32 error;
+};
+
+local byte len_sym_extra[DEFLATE_NUM_SYMBOLS_1 - 256] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0, 0, 0 };
+local byte dist_sym_extra[DEFLATE_NUM_SYMBOLS_2] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 0, 0 };
+local byte rle_sym_extra[DEFLATE_NUM_SYMBOLS_3] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7 };
+
+local int32 best_dist_sym(int32 dist)
+{
+	return dist <= 512 ? dist_lo_code[dist - 1] : dist_hi_code[(dist - 1) >> 8];
+}
+
+local int32 best_dist_extra(int32 dist)
+{
+	return dist <= 512 ? dist_lo_extra[dist - 1] : dist_hi_extra[(dist - 1) >> 8];
+}
+
+local int32 best_dist_mask(int32 dist)
+{
+	return dist <= 512 ? dist_lo_mask[dist - 1] : dist_hi_mask[(dist - 1) >> 8];
+}
+
+local uint32 best_hash(byte *p)
+{
+	return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (BEST_HASH_SIZE - 1);
+}
+
+// bit output
+
+local void best_put_byte(best_work_data *wd, byte b)
+{
+	if (wd->out_buf_pos == wd->out_buf_size)
+	{
+		if (wd->flush_out_buf(wd->out_buf_ofs, wd->out_buf_pos)) wd->error = TRUE;
+
+		wd->out_buf_pos = 0;
+	}
+
+	wd->out_buf_ofs[wd->out_buf_pos++] = b;
+}
+
+local void best_put_bits(best_work_data *wd, uint32 bits, int32 len)
+{
+	wd->bit_buf |= (uint64)bits << wd->bit_buf_len;
+	wd->bit_buf_len += len;
+
+	if (wd->bit_buf_len >= 32)
+	{
+		for (int32 i = 0; i < 4; i++)
+		{
+			best_put_byte(wd, (byte)wd->bit_buf);
+			wd->bit_buf >>= 8;
+		}
+
+		wd->bit_buf_len -= 32;
+	}
+}
+
+local void best_flush_bits(best_work_data *wd)
+{
+	while (wd->bit_buf_len > 0)
+	{
+		best_put_byte(wd, (byte)wd->bit_buf);
+		wd->bit_buf >>= 8;
+		wd->bit_buf_len -= 8;
+	}
+
+	wd->bit_buf = 0;
+	wd->bit_buf_len = 0;
+}
+
+// huffman codes
+
+local void best_huff_sort(int32 *syms, int32 *sym_freq, int32 num)
+{
+	// insertion sort by frequency, at most 288 symbols and mostly few of them
+	for (int32 i = 1; i < num; i++)
+	{
+		int32 s = syms[i];
+		int32 j = i - 1;
+
+		while (j >= 0 && sym_freq[syms[j]] > sym_freq[s])
+		{
+			syms[j + 1] = syms[j];
+			j--;
+		}
+
+		syms[j + 1] = s;
+	}
+}
+
+// minimum redundancy code lengths for ascending frequencies, done in place (moffat & katajainen)
+local void best_huff_min_redundancy(int32 *a, int32 n)
+{
+	int32 root = 0;
+	int32 leaf = 2;
+
+	a[0] += a[1];
+
+	for (int32 next = 1; next < n - 1; next++)
+	{
+		if (leaf >= n || a[root] < a[leaf])
+		{
+			a[next] = a[root];
+			a[root++] = next;
+		}
+		else
+		{
+			a[next] = a[leaf++];
+		}
+
+		if (leaf >= n || (root < next && a[root] < a[leaf]))
+		{
+			a[next] += a[root];
+			a[root++] = next;
+		}
+		else
+		{
+			a[next] += a[leaf++];
+		}
+	}
+
+	a[n - 2] = 0;
+
+	for (int32 next = n - 3; next >= 0; next--)
+	{
+		a[next] = a[a[next]] + 1;
+	}
+
+	int32 avbl = 1;
+	int32 used = 0;
+	int32 depth = 0;
+	root = n - 2;
+	int32 next = n - 1;
+
+	while (avbl > 0)
+	{
+		while (root >= 0 && a[root] == depth)
+		{
+			used++;
+			root--;
+		}
+
+		while (avbl > used)
+		{
+			a[next--] = depth;
+			avbl--;
+		}
+
+		avbl = 2 * used;
+		depth++;
+		used = 0;
+	}
+}
+
+// optimal length-limited code lengths for ascending frequencies, done in place (package-merge),
+// needs num <= 1 << max_code_size
+local void best_huff_package_merge(int32 *a, int32 n, int32 max_code_size)
+{
+	uint32 lists[2][2 * DEFLATE_MAX_SYMBOLS];
+	byte is_leaf[BEST_MAX_CODE_SIZE][2 * DEFLATE_MAX_SYMBOLS];
+	uint32 *prev = lists[0];
+	uint32 *cur = lists[1];
+	int32 prev_len = 0;
+
+	// level 0 is the final list, each level up merges the leaves with the packaged pairs of the level below
+	for (int32 level = max_code_size - 1; level >= 0; level--)
+	{
+		int32 num_packages = prev_len / 2;
+		int32 i = 0;
+		int32 j = 0;
+		int32 k = 0;
+
+		while (i < n || j < num_packages)
+		{
+			if (i < n && (j >= num_packages || (uint32)a[i] <= prev[2 * j] + prev[2 * j + 1]))
+			{
+				cur[k] = a[i++];
+				is_leaf[level][k++] = TRUE;
+			}
+			else
+			{
+				cur[k] = prev[2 * j] + prev[2 * j + 1];
+				is_leaf[level][k++] = FALSE;
+				j++;
+			}
+		}
+
+		uint32 *temp = prev;
+		prev = cur;
+		cur = temp;
+		prev_len = k;
+	}
+
+	for (int32 i = 0; i < n; i++)
+	{
+		a[i] = 0;
+	}
+
+	// the first 2n - 2 items of the final list are the code, every time a leaf is picked on some level its code gets a bit longer,
+	// leaves are picked lowest frequency first
+	for (int32 level = 0, take = 2 * n - 2; level < max_code_size && take > 0; level++)
+	{
+		int32 leaves = 0;
+
+		for (int32 k = 0; k < take; k++)
+		{
+			if (is_leaf[level][k]) a[leaves++]++;
+		}
+
+		take = 2 * (take - leaves);
+	}
+}
+
+local void best_huff_code_sizes(int32 num_symbols, int32 *sym_freq, int32 max_code_size, int32 *code_sizes)
+{
+	int32 syms[DEFLATE_MAX_SYMBOLS];
+	int32 lens[DEFLATE_MAX_SYMBOLS];
+	int32 num = 0;
+
+	for (int32 i = 0; i < num_symbols; i++)
+	{
+		code_sizes[i] = 0;
+
+		if (sym_freq[i]) syms[num++] = i;
+	}
+
+	if (num <= 1)
+	{
+		// a lone code of one bit is incomplete, which inflate only takes for distances, give it an unused partner
+		if (num)
+		{
+			code_sizes[syms[0]] = 1;
+			code_sizes[syms[0] ? 0 : 1] = 1;
+		}
+
+		return;
+	}
+
+	best_huff_sort(syms, sym_freq, num);
+
+	for (int32 i = 0; i < num; i++)
+	{
+		lens[i] = sym_freq[syms[i]];
+	}
+
+	best_huff_min_redundancy(lens, num);
+
+	// package-merge only when the unlimited code is too long, it's optimal but a lot slower
+	if (lens[0] > max_code_size)
+	{
+		for (int32 i = 0; i < num; i++)
+		{
+			lens[i] = sym_freq[syms[i]];
+		}
+
+		best_huff_package_merge(lens, num, max_code_size);
+	}
+
+	for (int32 i = 0; i < num; i++)
+	{
+		code_sizes[syms[i]] = lens[i];
+	}
+}
+
+local void best_huff_make_codes(int32 num_symbols, int32 *code_sizes, uint32 *codes)
+{
+	int32 num_codes[16] = ZEROMEM;
+	uint32 next_code[16] = ZEROMEM;
+
+	for (int32 i = 0; i < num_symbols; i++)
+	{
+		num_codes[code_sizes[i]]++;
+	}
+
+	num_codes[0] = 0;
+
+	for (int32 i = 1, j = 0; i < 16; i++)
+	{
+		j = (j + num_codes[i - 1]) << 1;
+		next_code[i] = j;
+	}
+
+	for (int32 i = 0; i < num_symbols; i++)
+	{
+		int32 len = code_sizes[i];
+		uint32 code = 0;
+
+		if (!len)
+		{
+			codes[i] = 0;
+
+			continue;
+		}
+
+		for (uint32 j = next_code[len]++, l = len; l > 0; l--)
+		{
+			code = (code << 1) | (j & 1);
+			j >>= 1;
+		}
+
+		codes[i] = code;
+	}
+}
+
+// block headers
+
+local void best_rle_put(best_rle *rle, int32 sym, int32 extra)
+{
+	rle->sym[rle->len] = (byte)sym;
+	rle->extra[rle->len++] = (byte)extra;
+}
+
+// same run-length coding the game does, longest repeats first
+local void best_rle_greedy(best_rle *rle, int32 *sizes, int32 num)
+{
+	rle->len = 0;
+
+	for (int32 i = 0; i < num;)
+	{
+		int32 size = sizes[i];
+		int32 run = 1;
+
+		while (i + run < num && sizes[i + run] == size) run++;
+
+		i += run;
+
+		if (!size)
+		{
+			while (run >= 11)
+			{
+				int32 r = min(run, 138);
+
+				best_rle_put(rle, 18, r - 11);
+				run -= r;
+			}
+
+			if (run >= 3)
+			{
+				best_rle_put(rle, 17, run - 3);
+				run = 0;
+			}
+		}
+		else
+		{
+			best_rle_put(rle, size, 0);
+			run--;
+
+			while (run >= 3)
+			{
+				int32 r = min(run, 6);
+
+				best_rle_put(rle, 16, r - 3);
+				run -= r;
+			}
+		}
+
+		while (run--) best_rle_put(rle, size, 0);
+	}
+}
+
+// cheapest run-length coding for the code sizes of the previous pass, repeat_last also works after zeros
+// and a run is often cheaper split up differently or partly sent as plain code sizes
+local void best_rle_optimal(best_rle *rle, int32 *sizes, int32 num, int32 *size_3)
+{
+	uint32 cost[BEST_MAX_RLE + 1];
+	int16 choice[BEST_MAX_RLE]; // number of code sizes covered, the symbol follows from it
+	int32 sym_cost[DEFLATE_NUM_SYMBOLS_3];
+	int32 run = 0;
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_3; i++)
+	{
+		sym_cost[i] = (size_3[i] ? size_3[i] : BEST_MAX_RLE_CODE_SIZE) + rle_sym_extra[i];
+	}
+
+	cost[num] = 0;
+
+	for (int32 i = num - 1; i >= 0; i--)
+	{
+		run = (i + 1 < num && sizes[i + 1] == sizes[i]) ? run + 1 : 1;
+
+		cost[i] = sym_cost[sizes[i]] + cost[i + 1];
+		choice[i] = 1;
+
+		if (i > 0 && sizes[i - 1] == sizes[i])
+		{
+			for (int32 r = 3; r <= min(run, 6); r++)
+			{
+				if (sym_cost[16] + cost[i + r] < cost[i])
+				{
+					cost[i] = sym_cost[16] + cost[i + r];
+					choice[i] = (int16)-r;
+				}
+			}
+		}
+
+		if (!sizes[i])
+		{
+			for (int32 r = 3; r <= min(run, 138); r++)
+			{
+				uint32 c = sym_cost[r <= 10 ? 17 : 18] + cost[i + r];
+
+				if (c < cost[i])
+				{
+					cost[i] = c;
+					choice[i] = (int16)r;
+				}
+			}
+		}
+	}
+
+	rle->len = 0;
+
+	for (int32 i = 0; i < num;)
+	{
+		int32 r = choice[i];
+
+		if (r < 0)
+		{
+			best_rle_put(rle, 16, -r - 3);
+			r = -r;
+		}
+		else if (r >= 11)
+		{
+			best_rle_put(rle, 18, r - 11);
+		}
+		else if (r >= 3)
+		{
+			best_rle_put(rle, 17, r - 3);
+		}
+		else
+		{
+			best_rle_put(rle, sizes[i], 0);
+		}
+
+		i += r;
+	}
+}
+
+// builds the code length code for the run-length coded code sizes, returns the header size in bits
+local uint32 best_rle_code(best_rle *rle)
+{
+	int32 freq_3[DEFLATE_NUM_SYMBOLS_3] = ZEROMEM;
+
+	for (int32 i = 0; i < rle->len; i++)
+	{
+		freq_3[rle->sym[i]]++;
+	}
+
+	best_huff_code_sizes(DEFLATE_NUM_SYMBOLS_3, freq_3, BEST_MAX_RLE_CODE_SIZE, rle->size_3);
+
+	for (rle->bit_lengths = DEFLATE_NUM_SYMBOLS_3; rle->bit_lengths > 4; rle->bit_lengths--)
+	{
+		if (rle->size_3[bit_length_order[rle->bit_lengths - 1]]) break;
+	}
+
+	rle->bits = 5 + 5 + 4 + 3 * rle->bit_lengths;
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_3; i++)
+	{
+		rle->bits += freq_3[i] * (rle->size_3[i] + rle_sym_extra[i]);
+	}
+
+	return rle->bits;
+}
+
+// builds the dynamic codes of a block from its frequencies, returns the header size in bits
+local uint32 best_init_dynamic_block(best_block *block)
+{
+	int32 sizes[BEST_MAX_RLE];
+	best_rle rle;
+
+	best_huff_code_sizes(DEFLATE_NUM_SYMBOLS_1, block->freq_1, BEST_MAX_CODE_SIZE, block->size_1);
+	best_huff_code_sizes(DEFLATE_NUM_SYMBOLS_2, block->freq_2, BEST_MAX_CODE_SIZE, block->size_2);
+
+	for (block->used_lit_codes = BEST_NUM_LIT_LEN; block->used_lit_codes > 257; block->used_lit_codes--)
+	{
+		if (block->size_1[block->used_lit_codes - 1]) break;
+	}
+
+	for (block->used_dist_codes = BEST_NUM_DIST; block->used_dist_codes > 1; block->used_dist_codes--)
+	{
+		if (block->size_2[block->used_dist_codes - 1]) break;
+	}
+
+	int32 num = block->used_lit_codes + block->used_dist_codes;
+
+	memcpy(sizes, block->size_1, block->used_lit_codes * sizeof(int32));
+	memcpy(sizes + block->used_lit_codes, block->size_2, block->used_dist_codes * sizeof(int32));
+
+	best_rle_greedy(&block->rle, sizes, num);
+	best_rle_code(&block->rle);
+
+	for (int32 pass = 0; pass < BEST_RLE_PASSES; pass++)
+	{
+		best_rle_optimal(&rle, sizes, num, block->rle.size_3);
+
+		if (best_rle_code(&rle) >= block->rle.bits) break;
+
+		block->rle = rle;
+	}
+
+	return block->rle.bits;
+}
+
+local void best_init_static_block(best_block *block)
+{
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_1; i++)
+	{
+		block->size_1[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	}
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_2; i++)
+	{
+		block->size_2[i] = 5;
+	}
+}
+
+local uint32 best_data_bits(best_block *block)
+{
+	uint32 bits = 0;
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_1; i++)
+	{
+		bits += block->freq_1[i] * (block->size_1[i] + (i > 256 ? len_sym_extra[i - 256] : 0));
+	}
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_2; i++)
+	{
+		bits += block->freq_2[i] * (block->size_2[i] + dist_sym_extra[i]);
+	}
+
+	return bits;
+}
+
+local uint32 best_stored_bits(int32 num_bytes)
+{
+	int32 num_blocks = max(1, (num_bytes + BEST_MAX_STORED - 1) / BEST_MAX_STORED);
+
+	return num_blocks * (3 + 7 + 32) + (num_bytes << 3);
+}
+
+local void best_count(best_block *block, best_match *tokens, int32 num_tokens, bool32 clear)
+{
+	if (clear)
+	{
+		memzero(block->freq_1, sizeof(block->freq_1));
+		memzero(block->freq_2, sizeof(block->freq_2));
+
+		block->freq_1[256] = 1;
+	}
+
+	for (int32 i = 0; i < num_tokens; i++)
+	{
+		if (tokens[i].dist)
+		{
+			block->freq_1[len_code[tokens[i].len - DEFLATE_MIN_MATCH]]++;
+			block->freq_2[best_dist_sym(tokens[i].dist)]++;
+		}
+		else
+		{
+			block->freq_1[tokens[i].len]++;
+		}
+	}
+}
+
+local void best_merge(best_block *dst, best_block *a, best_block *b)
+{
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_1; i++)
+	{
+		dst->freq_1[i] = a->freq_1[i] + b->freq_1[i];
+	}
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_2; i++)
+	{
+		dst->freq_2[i] = a->freq_2[i] + b->freq_2[i];
+	}
+
+	dst->freq_1[256] = 1;
+}
+
+// cheapest block type for the tokens counted in block, uses the strategy of the game deflate,
+// num_bytes is 0 for a block that started in an earlier chunk, its bytes are gone so it can't be stored
+local uint32 best_block_cost(best_work_data *wd, best_block *block, int32 num_bytes)
+{
+	uint32 dynamic_bits = UINT32_MAX;
+	uint32 static_bits = UINT32_MAX;
+
+	if (wd->strategy != DEFLATE_STATIC_BLOCKS)
+	{
+		dynamic_bits = 3 + best_init_dynamic_block(block) + best_data_bits(block);
+	}
+
+	if (wd->strategy != DEFLATE_DYNAMIC_BLOCKS)
+	{
+		best_block *temp = &wd->temp_block;
+
+		memcpy(temp->freq_1, block->freq_1, sizeof(block->freq_1));
+		memcpy(temp->freq_2, block->freq_2, sizeof(block->freq_2));
+
+		best_init_static_block(temp);
+
+		static_bits = 3 + best_data_bits(temp);
+	}
+
+	uint32 bits = min(dynamic_bits, static_bits);
+
+	if (wd->strategy == DEFLATE_ALL_BLOCKS && num_bytes) bits = min(bits, best_stored_bits(num_bytes));
+
+	return bits;
+}
+
+// optimal parse
+
+local void best_set_costs(best_work_data *wd, best_block *block)
+{
+	int32 size_1[DEFLATE_NUM_SYMBOLS_1];
+	int32 size_2[DEFLATE_NUM_SYMBOLS_2];
+
+	best_huff_code_sizes(DEFLATE_NUM_SYMBOLS_1, block->freq_1, BEST_MAX_CODE_SIZE, size_1);
+	best_huff_code_sizes(DEFLATE_NUM_SYMBOLS_2, block->freq_2, BEST_MAX_CODE_SIZE, size_2);
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_1; i++)
+	{
+		wd->lit_len_cost[i] = size_1[i] ? size_1[i] : BEST_UNUSED_COST;
+	}
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_2; i++)
+	{
+		wd->dist_cost[i] = (size_2[i] ? size_2[i] : BEST_UNUSED_COST) + dist_sym_extra[i];
+	}
+
+	for (int32 i = DEFLATE_MIN_MATCH; i <= DEFLATE_MAX_MATCH; i++)
+	{
+		wd->len_cost[i] = wd->lit_len_cost[len_code[i - DEFLATE_MIN_MATCH]] + len_extra[i - DEFLATE_MIN_MATCH];
+	}
+}
+
+local void best_set_static_costs(best_work_data *wd)
+{
+	best_block *temp = &wd->temp_block;
+
+	best_init_static_block(temp);
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_1; i++)
+	{
+		wd->lit_len_cost[i] = temp->size_1[i];
+	}
+
+	for (int32 i = 0; i < DEFLATE_NUM_SYMBOLS_2; i++)
+	{
+		wd->dist_cost[i] = temp->size_2[i] + dist_sym_extra[i];
+	}
+
+	for (int32 i = DEFLATE_MIN_MATCH; i <= DEFLATE_MAX_MATCH; i++)
+	{
+		wd->len_cost[i] = wd->lit_len_cost[len_code[i - DEFLATE_MIN_MATCH]] + len_extra[i - DEFLATE_MIN_MATCH];
+	}
+}
+
+local void best_find_matches(best_work_data *wd, int32 chunk_start, int32 chunk_end)
+{
+	byte *buf = wd->buf;
+	int32 num_matches = 0;
+	int32 (*match_len)(byte *, byte *, int32) = cpu_get_kernels()->match_len;
+
+	for (int32 pos = chunk_start; pos < chunk_end; pos++)
+	{
+		wd->match_ofs[pos - chunk_start] = num_matches;
+
+		int32 limit = min(DEFLATE_MAX_MATCH, chunk_end - pos);
+
+		if (limit < DEFLATE_MIN_MATCH) continue;
+
+		uint32 h = best_hash(buf + pos);
+		int32 probe_pos = wd->head[h];
+		int32 min_pos = pos - BEST_WINDOW_SIZE;
+		int32 best_len = DEFLATE_MIN_MATCH - 1;
+
+		// bytes left over by the last chunk were hashed along with it, skip what came after them
+		while (probe_pos >= pos) probe_pos = wd->prev[probe_pos];
+
+		for (int32 depth = BEST_MAX_DEPTH; depth > 0 && probe_pos != BEST_NIL && probe_pos >= min_pos; depth--)
+		{
+			if (buf[probe_pos + best_len] == buf[pos + best_len])
+			{
+				int32 len = match_len(buf + probe_pos, buf + pos, limit);
+
+				if (len > best_len)
+				{
+					if (num_matches == wd->matches_alloc)
+					{
+						wd->matches_alloc *= 2;
+						wd->matches = realloc(wd->matches, wd->matches_alloc * sizeof(best_match));
+					}
+
+					wd->matches[num_matches].len = (uint16)len;
+					wd->matches[num_matches].dist = (uint16)(pos - probe_pos);
+					num_matches++;
+
+					best_len = len;
+
+					if (len >= limit) break;
+				}
+			}
+
+			probe_pos = wd->prev[probe_pos];
+		}
+
+		if (pos >= wd->hash_end)
+		{
+			wd->prev[pos] = wd->head[h];
+			wd->head[h] = pos;
+		}
+
+		if (best_len >= BEST_NICE_MATCH)
+		{
+			// the parse can only take the long match or literals in here, just hash the positions
+			for (int32 end = pos + best_len - 1; pos < end;)
+			{
+				pos++;
+
+				wd->match_ofs[pos - chunk_start] = num_matches;
+
+				if (chunk_end - pos >= DEFLATE_MIN_MATCH && pos >= wd->hash_end)
+				{
+					h = best_hash(buf + pos);
+					wd->prev[pos] = wd->head[h];
+					wd->head[h] = pos;
+				}
+			}
+		}
+	}
+
+	wd->match_ofs[chunk_end - chunk_start] = num_matches;
+	wd->hash_end = max(wd->hash_end, chunk_end - DEFLATE_MIN_MATCH + 1);
+}
+
+// cheapest way to code [start, end) with the current costs, returns the number of tokens
+local int32 best_parse(best_work_data *wd, int32 chunk_start, int32 start, int32 end, best_match *tokens)
+{
+	byte *buf = wd->buf;
+	uint32 *cost = wd->cost - chunk_start;
+	best_match *choice = wd->choice - chunk_start;
+	uint32 *match_ofs = wd->match_ofs - chunk_start;
+
+	cost[end] = 0;
+
+	for (int32 pos = end - 1; pos >= start; pos--)
+	{
+		uint32 best_cost = wd->lit_len_cost[buf[pos]] + cost[pos + 1];
+		int32 best_len = 1;
+		int32 best_dist = 0;
+		int32 max_len = end - pos;
+		int32 len = DEFLATE_MIN_MATCH;
+
+		for (uint32 i = match_ofs[pos]; i < match_ofs[pos + 1]; i++)
+		{
+			int32 match_len = min(wd->matches[i].len, max_len);
+			int32 dist = wd->matches[i].dist;
+			uint32 dist_cost = wd->dist_cost[best_dist_sym(dist)];
+
+			for (; len <= match_len; len++)
+			{
+				uint32 c = dist_cost + wd->len_cost[len] + cost[pos + len];
+
+				if (c < best_cost)
+				{
+					best_cost = c;
+					best_len = len;
+					best_dist = dist;
+				}
+			}
+		}
+
+		cost[pos] = best_cost;
+		choice[pos].len = (uint16)best_len;
+		choice[pos].dist = (uint16)best_dist;
+	}
+
+	int32 num_tokens = 0;
+
+	for (int32 pos = start; pos < end;)
+	{
+		if (choice[pos].dist)
+		{
+			tokens[num_tokens++] = choice[pos];
+			pos += choice[pos].len;
+		}
+		else
+		{
+			tokens[num_tokens].len = buf[pos++];
+			tokens[num_tokens++].dist = 0;
+		}
+	}
+
+	return num_tokens;
+}
+
+local int32 best_token_bytes(best_match *token)
+{
+	return token->dist ? token->len : 1;
+}
+
+// block output
+
+local void best_write_tokens(best_work_data *wd, best_block *block, best_match *tokens, int32 num_tokens)
+{
+	for (int32 i = 0; i < num_tokens; i++)
+	{
+		int32 len = tokens[i].len;
+		int32 dist = tokens[i].dist;
+
+		if (dist)
+		{
+			int32 len_sym = len_code[len - DEFLATE_MIN_MATCH];
+			int32 dist_sym = best_dist_sym(dist);
+
+			best_put_bits(wd, block->code_1[len_sym], block->size_1[len_sym]);
+			best_put_bits(wd, (len - DEFLATE_MIN_MATCH) & len_mask[len - DEFLATE_MIN_MATCH], len_extra[len - DEFLATE_MIN_MATCH]);
+			best_put_bits(wd, block->code_2[dist_sym], block->size_2[dist_sym]);
+			best_put_bits(wd, (dist - 1) & best_dist_mask(dist), best_dist_extra(dist));
+		}
+		else
+		{
+			best_put_bits(wd, block->code_1[len], block->size_1[len]);
+		}
+	}
+
+	best_put_bits(wd, block->code_1[256], block->size_1[256]);
+}
+
+local void best_write_stored(best_work_data *wd, byte *data, int32 num_bytes, bool32 last_block_flag)
+{
+	do
+	{
+		int32 len = min(num_bytes, BEST_MAX_STORED);
+
+		num_bytes -= len;
+
+		best_put_bits(wd, last_block_flag && !num_bytes, 1);
+		best_put_bits(wd, 0, 2);
+		best_flush_bits(wd);
+
+		best_put_byte(wd, (byte)(len & 0xFF));
+		best_put_byte(wd, (byte)(len >> 8));
+		best_put_byte(wd, (byte)(~len & 0xFF));
+		best_put_byte(wd, (byte)(~len >> 8));
+
+		for (int32 i = 0; i < len; i++)
+		{
+			best_put_byte(wd, data[i]);
+		}
+
+		data += len;
+	}
+	while (num_bytes > 0);
+}
+
+// start is BEST_NIL for a block that started in an earlier chunk
+local void best_write_block(best_work_data *wd, best_match *tokens, int32 num_tokens, int32 start, int32 end, bool32 last_block_flag)
+{
+	best_block *block = &wd->block;
+
+	best_count(block, tokens, num_tokens, TRUE);
+
+	uint32 dynamic_bits = UINT32_MAX;
+	uint32 static_bits = UINT32_MAX;
+	uint32 stored_bits = UINT32_MAX;
+
+	if (wd->strategy != DEFLATE_STATIC_BLOCKS)
+	{
+		// inflaters differ on how they take incomplete codes, make sure there are always at least two
+		int32 num_dist = 0;
+
+		for (int32 i = 0; i < BEST_NUM_DIST; i++)
+		{
+			if (block->freq_2[i]) num_dist++;
+		}
+
+		for (int32 i = 0; i < BEST_NUM_DIST && num_dist < 2; i++)
+		{
+			if (!block->freq_2[i])
+			{
+				block->freq_2[i] = 1;
+				num_dist++;
+			}
+		}
+
+		if (block->freq_1[256] == 1 && num_tokens == 0) block->freq_1[0] = 1;
+
+		dynamic_bits = best_init_dynamic_block(block) + best_data_bits(block);
+	}
+
+	if (wd->strategy != DEFLATE_DYNAMIC_BLOCKS)
+	{
+		best_block *temp = &wd->temp_block;
+
+		memcpy(temp->freq_1, block->freq_1, sizeof(block->freq_1));
+		memcpy(temp->freq_2, block->freq_2, sizeof(block->freq_2));
+
+		best_init_static_block(temp);
+
+		static_bits = best_data_bits(temp);
+	}
+
+	if (wd->strategy == DEFLATE_ALL_BLOCKS && start != BEST_NIL) stored_bits = best_stored_bits(end - start);
+
+	if (stored_bits < dynamic_bits && stored_bits < static_bits)
+	{
+		best_write_stored(wd, wd->buf + start, end - start, last_block_flag);
+	}
+	else if (static_bits <= dynamic_bits)
+	{
+		best_init_static_block(block);
+		best_huff_make_codes(DEFLATE_NUM_SYMBOLS_1, block->size_1, block->code_1);
+		best_huff_make_codes(DEFLATE_NUM_SYMBOLS_2, block->size_2, block->code_2);
+
+		best_put_bits(wd, last_block_flag, 1);
+		best_put_bits(wd, 1, 2);
+		best_write_tokens(wd, block, tokens, num_tokens);
+	}
+	else
+	{
+		best_huff_make_codes(DEFLATE_NUM_SYMBOLS_1, block->size_1, block->code_1);
+		best_huff_make_codes(DEFLATE_NUM_SYMBOLS_2, block->size_2, block->code_2);
+		best_huff_make_codes(DEFLATE_NUM_SYMBOLS_3, block->rle.size_3, block->code_3);
+
+		best_put_bits(wd, last_block_flag, 1);
+		best_put_bits(wd, 2, 2);
+		best_put_bits(wd, block->used_lit_codes - 257, 5);
+		best_put_bits(wd, block->used_dist_codes - 1, 5);
+		best_put_bits(wd, block->rle.bit_lengths - 4, 4);
+
+		for (int32 i = 0; i < block->rle.bit_lengths; i++)
+		{
+			best_put_bits(wd, block->rle.size_3[bit_length_order[i]], 3);
+		}
+
+		for (int32 i = 0; i < block->rle.len; i++)
+		{
+			int32 sym = block->rle.sym[i];
+
+			best_put_bits(wd, block->code_3[sym], block->rle.size_3[sym]);
+			best_put_bits(wd, block->rle.extra[i], rle_sym_extra[sym]);
+		}
+
+		best_write_tokens(wd, block, tokens, num_tokens);
+	}
+}
+
+// parses [start, end) again with the block's own cost model, behind the tokens still open, returns the number of all of them
+local int32 best_parse_block(best_work_data *wd, best_block *block, int32 chunk_start, int32 start, int32 end)
+{
+	int32 num_tokens = 0;
+
+	for (int32 pass = 0; pass < BEST_BLOCK_PASSES; pass++)
+	{
+		if (pass) best_count(block, wd->block_tokens, wd->num_open_tokens + num_tokens, TRUE);
+
+		best_set_costs(wd, block);
+
+		num_tokens = best_parse(wd, chunk_start, start, end, wd->block_tokens + wd->num_open_tokens);
+	}
+
+	return wd->num_open_tokens + num_tokens;
+}
+
+local void best_compress_chunk(best_work_data *wd, bool32 last_chunk_flag)
+{
+	int32 chunk_start = wd->buf_start;
+	int32 chunk_end = wd->buf_fill;
+
+	if (chunk_start == chunk_end)
+	{
+		if (last_chunk_flag && wd->num_open_tokens)
+		{
+			best_write_block(wd, wd->block_tokens, wd->num_open_tokens, BEST_NIL, chunk_end, TRUE);
+
+			wd->num_open_tokens = 0;
+		}
+		else if (last_chunk_flag)
+		{
+			// nothing left, end the stream with an empty static block like the game does
+			best_put_bits(wd, 1, 1);
+			best_put_bits(wd, 1, 2);
+			best_put_bits(wd, 0, 7);
+		}
+
+		return;
+	}
+
+	best_find_matches(wd, chunk_start, chunk_end);
+
+	// cost model for the whole chunk, starting from the static codes
+	int32 num_tokens = 0;
+
+	best_set_static_costs(wd);
+
+	for (int32 pass = 0; pass < BEST_CHUNK_PASSES; pass++)
+	{
+		if (pass)
+		{
+			best_count(&wd->block, wd->tokens, num_tokens, TRUE);
+			best_set_costs(wd, &wd->block);
+		}
+
+		num_tokens = best_parse(wd, chunk_start, chunk_start, chunk_end, wd->tokens);
+	}
+
+	// unless it's the end, the tokens in the last DEFLATE_MAX_MATCH bytes are left for the next chunk,
+	// the matches in there are cut short by the end of what's been read so far
+	if (!last_chunk_flag)
+	{
+		int32 cut = chunk_end - DEFLATE_MAX_MATCH;
+		int32 end = chunk_start;
+		int32 num = 0;
+
+		while (end < cut)
+		{
+			end += best_token_bytes(&wd->tokens[num++]);
+		}
+
+		chunk_end = end;
+		num_tokens = num;
+	}
+
+	// greedy block splitting, a segment joins the current block unless it's cheaper on its own,
+	// the first one joins the block left open by the previous chunk the same way
+	best_block *cur = &wd->block;
+	best_block seg;
+	best_block merged;
+
+	bool32 open_flag = wd->num_open_tokens > 0;
+	int32 block_start = chunk_start;
+	int32 block_token = open_flag ? -1 : 0;
+	int32 pos = chunk_start;
+	int32 i = 0;
+
+	best_count(cur, wd->block_tokens, wd->num_open_tokens, TRUE);
+
+	while (i < num_tokens)
+	{
+		int32 seg_start = pos;
+		int32 seg_token = i;
+
+		while (i < num_tokens && pos - seg_start < BEST_SPLIT_BYTES)
+		{
+			pos += best_token_bytes(&wd->tokens[i++]);
+		}
+
+		if (seg_token == block_token)
+		{
+			best_count(cur, wd->tokens + seg_token, i - seg_token, FALSE);
+
+			continue;
+		}
+
+		best_count(&seg, wd->tokens + seg_token, i - seg_token, TRUE);
+		best_merge(&merged, cur, &seg);
+
+		uint32 merged_bits = best_block_cost(wd, &merged, open_flag ? 0 : pos - block_start);
+		uint32 split_bits = best_block_cost(wd, cur, open_flag ? 0 : seg_start - block_start) + best_block_cost(wd, &seg, pos - seg_start);
+
+		if (merged_bits <= split_bits)
+		{
+			best_merge(cur, cur, &seg);
+
+			continue;
+		}
+
+		// cur is done, parse it again with its own cost model and write it
+		int32 num_block_tokens = best_parse_block(wd, cur, chunk_start, block_start, seg_start);
+
+		best_write_block(wd, wd->block_tokens, num_block_tokens, open_flag ? BEST_NIL : block_start, seg_start, FALSE);
+
+		wd->num_open_tokens = 0;
+		open_flag = FALSE;
+		block_start = seg_start;
+		block_token = seg_token;
+
+		memcpy(cur->freq_1, seg.freq_1, sizeof(seg.freq_1));
+		memcpy(cur->freq_2, seg.freq_2, sizeof(seg.freq_2));
+	}
+
+	int32 num_block_tokens = best_parse_block(wd, cur, chunk_start, block_start, chunk_end);
+
+	// unless it's the end, the last block stays open for the next chunk to join, a block header less for data
+	// that goes on the same way, but not if it's better stored, its bytes are gone by then
+	if (!last_chunk_flag && num_block_tokens <= BEST_BUF_SIZE)
+	{
+		best_count(cur, wd->block_tokens, num_block_tokens, TRUE);
+
+		if (open_flag || best_block_cost(wd, cur, 0) <= best_block_cost(wd, cur, chunk_end - block_start))
+		{
+			wd->num_open_tokens = num_block_tokens;
+			wd->buf_start = chunk_end;
+
+			return;
+		}
+	}
+
+	best_write_block(wd, wd->block_tokens, num_block_tokens, open_flag ? BEST_NIL : block_start, chunk_end, last_chunk_flag);
+
+	wd->num_open_tokens = 0;
+	wd->buf_start = chunk_end;
+}
+
+// keeps the window in front of the next chunk and the bytes the last one left over
+local void best_slide(best_work_data *wd)
+{
+	int32 shift = max(0, wd->buf_start - BEST_WINDOW_SIZE);
+	int32 keep = wd->buf_fill - shift;
+
+	memmove(wd->buf, wd->buf + shift, keep);
+
+	for (int32 i = 0; i < BEST_HASH_SIZE; i++)
+	{
+		wd->head[i] = wd->head[i] >= shift ? wd->head[i] - shift : BEST_NIL;
+	}
+
+	for (int32 i = 0; i < keep; i++)
+	{
+		wd->prev[i] = wd->prev[i + shift] >= shift ? wd->prev[i + shift] - shift : BEST_NIL;
+	}
+
+	wd->buf_start -= shift;
+	wd->buf_fill = keep;
+	wd->hash_end = max(0, wd->hash_end - shift);
+}
+
+size_t best_deflate_buf_size()
+{
+	return sizeof(best_work_data);
+}
+
+int32 best_deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32))
+{
+	best_work_data *wd = (best_work_data *)_wd;
+
+	wd->buf = calloc(BEST_BUF_SIZE + BEST_BUF_SLACK, 1);
+	wd->head = malloc(BEST_HASH_SIZE * sizeof(int32));
+	wd->prev = malloc(BEST_BUF_SIZE * sizeof(int32));
+	wd->match_ofs = malloc((BEST_BUF_SIZE + 1) * sizeof(uint32));
+	wd->matches_alloc = BEST_BUF_SIZE;
+	wd->matches = malloc(wd->matches_alloc * sizeof(best_match));
+	wd->cost = malloc((BEST_BUF_SIZE + 1) * sizeof(uint32));
+	wd->choice = malloc((BEST_BUF_SIZE + 1) * sizeof(best_match));
+	wd->tokens = malloc(BEST_BUF_SIZE * sizeof(best_match));
+	wd->block_tokens = malloc(2 * BEST_BUF_SIZE * sizeof(best_match)); // an open block of up to BEST_BUF_SIZE and a chunk
+
+	if (!wd->buf || !wd->head || !wd->prev || !wd->match_ofs || !wd->matches || !wd->cost || !wd->choice || !wd->tokens || !wd->block_tokens)
+	{
+		wd->error = TRUE;
+
+		return DEFLATE_ERROR;
+	}
+
+	for (int32 i = 0; i < BEST_HASH_SIZE; i++)
+	{
+		wd->head[i] = BEST_NIL;
+	}
+
+	wd->buf_start = 0;
+	wd->buf_fill = 0;
+	wd->hash_end = 0;
+	wd->num_open_tokens = 0;
+	wd->strategy = strategy;
+	wd->out_buf_ofs = out_buf_ofs;
+	wd->out_buf_size = out_buf_size;
+	wd->out_buf_pos = 0;
+	wd->flush_out_buf = out_buf_flush;
+	wd->bit_buf = 0;
+	wd->bit_buf_len = 0;
+	wd->error = FALSE;
+
+	return DEFLATE_INIT;
+}
+
+int32 best_deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag)
+{
+	best_work_data *wd = (best_work_data *)_wd;
+
+	if (wd->error) return DEFLATE_ERROR;
+
+	while (in_buf_size > 0)
+	{
+		int32 len = min(in_buf_size, BEST_BUF_SIZE - wd->buf_fill);
+
+		memcpy(wd->buf + wd->buf_fill, in_buf_ofs, len);
+
+		wd->buf_fill += len;
+		in_buf_ofs += len;
+		in_buf_size -= len;
+
+		if (wd->buf_fill == BEST_BUF_SIZE)
+		{
+			best_compress_chunk(wd, FALSE);
+			best_slide(wd);
+		}
+	}
+
+	if (eof_flag)
+	{
+		best_compress_chunk(wd, TRUE);
+		best_flush_bits(wd);
+
+		if (wd->out_buf_pos && wd->flush_out_buf(wd->out_buf_ofs, wd->out_buf_pos)) wd->error = TRUE;
+
+		wd->out_buf_pos = 0;
+	}
+
+	return wd->error ? DEFLATE_ERROR : DEFLATE_OK;
+}
+
+// the dictionary becomes the history in front of the first chunk, matches into it work like into any earlier data
+int32 best_deflate_set_dictionary(void *_wd, byte *dict_ofs, int32 dict_size)
+{
+	best_work_data *wd = (best_work_data *)_wd;
+
+	if (wd->error || wd->buf_fill) return DEFLATE_ERROR;
+
+	if (dict_size <= 0) return DEFLATE_OK;
+
+	if (dict_size > BEST_WINDOW_SIZE)
+	{
+		dict_ofs += dict_size - BEST_WINDOW_SIZE;
+		dict_size = BEST_WINDOW_SIZE;
+	}
+
+	memcpy(wd->buf, dict_ofs, dict_size);
+
+	for (int32 pos = 0; pos < dict_size - DEFLATE_THRESHOLD; pos++)
+	{
+		uint32 h = best_hash(wd->buf + pos);
+
+		wd->prev[pos] = wd->head[h];
+		wd->head[h] = pos;
+	}
+
+	wd->buf_start = dict_size;
+	wd->buf_fill = dict_size;
+
+	return DEFLATE_OK;
+}
+
+void best_deflate_deinit(void *_wd)
+{
+	best_work_data *wd = (best_work_data *)_wd;
+
+	rge_free(wd->buf);
+	rge_free(wd->head);
+	rge_free(wd->prev);
+	rge_free(wd->match_ofs);
+	rge_free(wd->matches);
+	rge_free(wd->cost);
+	rge_free(wd->choice);
+	rge_free(wd->tokens);
+	rge_free(wd->block_tokens);
+}
+
+bool32 best_deflate_get_stats(void *_wd, deflate_stats *stats)
+{
+	memzero(stats, sizeof(deflate_stats));
+
+	return FALSE;
+}
@@ -0,0 +1,154 @@
+#include <zlib.h>
+
+#include "compress.h"
+
+// streams through zlib's deflate, memory use is constant no matter the infile size
+
+typedef struct zlib_work_data zlib_work_data;
+
+struct zlib_work_data
+{
+	z_stream stream;
+	int32 code;
+	byte *buffer;
+	size_t buffer_len;
+	int32 (*flush_out_buf)(byte *out_buf_ofs, int32 out_buf_size);
+};
+
+local void *zalloc(void *opaque, uint32 items, uint32 size)
+{
+	return calloc(size, items);
+};
+
+local void zfree(void *opaque, void *address)
+{
+	free(address);
+}
+
+local bool32 zlib_deflate_flush(zlib_work_data *wd)
+{
+	if (wd->flush_out_buf(wd->buffer, wd->buffer_len - wd->stream.avail_out)) return TRUE;
+
+	wd->stream.next_out = wd->buffer;
+	wd->stream.avail_out = wd->buffer_len;
+
+	return FALSE;
+}
+
+size_t zlib_deflate_buf_size()
+{
+	return sizeof(zlib_work_data);
+}
+
+int32 zlib_deflate_init(void *_wd, int32 max_compares, int32 strategy, bool32 greedy_flag, byte *out_buf_ofs, int32 out_buf_size, int32 (*out_buf_flush)(byte *, int32))
+{
+	zlib_work_data *wd = (zlib_work_data *)_wd;
+
+	wd->buffer = out_buf_ofs;
+	wd->buffer_len = out_buf_size;
+	wd->flush_out_buf = out_buf_flush;
+
+	memzero(&wd->stream, sizeof(wd->stream));
+
+	wd->stream.zalloc = zalloc;
+	wd->stream.zfree = zfree;
+
+	wd->code = deflateInit2(&wd->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+
+	if (wd->code != Z_OK)
+	{
+		fprintf(stderr, "deflate error %d: %s\n", wd->code, wd->stream.msg);
+
+		return DEFLATE_ERROR;
+	}
+
+	wd->stream.next_out = wd->buffer;
+	wd->stream.avail_out = wd->buffer_len;
+
+	return DEFLATE_INIT;
+}
+
+int32 zlib_deflate_data(void *_wd, byte *in_buf_ofs, int32 in_buf_size, bool32 eof_flag)
+{
+	zlib_work_data *wd = (zlib_work_data *)_wd;
+
+	if (wd->code != Z_OK) return DEFLATE_ERROR;
+
+	wd->stream.next_in = in_buf_ofs;
+	wd->stream.avail_in = in_buf_size;
+
+	int32 flush = eof_flag ? Z_FINISH : Z_NO_FLUSH;
+
+	for (ever)
+	{
+		wd->code = deflate(&wd->stream, flush);
+
+		if (wd->code != Z_OK && wd->code != Z_STREAM_END && wd->code != Z_BUF_ERROR)
+		{
+			fprintf(stderr, "deflate error %d: %s\n", wd->code, wd->stream.msg);
+
+			return DEFLATE_ERROR;
+		}
+
+		if (wd->code == Z_STREAM_END)
+		{
+			if (zlib_deflate_flush(wd)) return DEFLATE_ERROR;
+
+			return DEFLATE_OK;
+		}
+
+		if (!wd->stream.avail_out)
+		{
+			if (zlib_deflate_flush(wd))
+			{
+				wd->code = Z_ERRNO;
+
+				return DEFLATE_ERROR;
+			}
+		}
+		else if (!wd->stream.avail_in && flush == Z_NO_FLUSH)
+		{
+			// all input consumed, the rest stays in the out buffer until it's full
+			wd->code = Z_OK;
+
+			return DEFLATE_OK;
+		}
+	}
+}
+
+int32 zlib_deflate_set_dictionary(void *_wd, byte *dict_ofs, int32 dict_size)
+{
+	zlib_work_data *wd = (zlib_work_data *)_wd;
+
+	if (wd->code != Z_OK) return DEFLATE_ERROR;
+
+	if (dict_size <= 0) return DEFLATE_OK;
+
+	wd->code = deflateSetDictionary(&wd->stream, dict_ofs, dict_size);
+
+	if (wd->code != Z_OK)
+	{
+		fprintf(stderr, "deflate error %d: %s\n", wd->code, wd->stream.msg);
+
+		return DEFLATE_ERROR;
+	}
+
+	return DEFLATE_OK;
+}
+
+void zlib_deflate_deinit(void *_wd)
+{
+	zlib_work_data *wd = (zlib_work_data *)_wd;
+
+	deflateEnd(&wd->stream);
+
+	wd->buffer = NULL;
+	wd->buffer_len = 0;
+}
+
+bool32 zlib_deflate_get_stats(void *_wd, deflate_stats *stats)
+{
+	memzero(stats, sizeof(deflate_stats));
+
+	return FALSE;
+}
@@ -0,0 +1,273 @@
+#include "thread.h"
+
+#include "compress.h"
+#include "detect.h"
+
+#define DETECT_IN_BUF_SIZE 0x10000
+#define DETECT_OUT_BUF_SIZE 0x1000 // small so a mismatch is noticed soon after the encoder emits it
+
+typedef struct detect_job detect_job;
+typedef struct detect_worker detect_worker;
+
+struct detect_job
+{
+	byte *compressed;
+	size_t compressed_size;
+	byte *data;
+	size_t data_size;
+	deflate_params *candidates;
+	bool32 *matched;
+	int32 num_candidates;
+	volatile int32 next_candidate;
+	volatile int32 first_match;
+	bool32 find_all;
+	rge_mutex mutex;
+};
+
+struct detect_worker
+{
+	detect_job *job;
+	rge_thread thread;
+	byte *wd;
+	byte out_buf[DETECT_OUT_BUF_SIZE];
+	int32 candidate;
+	size_t out_pos;
+	bool32 mismatch;
+};
+
+local thread_local detect_worker *current_worker = NULL; // flush callback has no user pointer
+
+local int32 strategies[] = { DEFLATE_ALL_BLOCKS, DEFLATE_DYNAMIC_BLOCKS, DEFLATE_STATIC_BLOCKS };
+local bool32 greedy_flags[] = { TRUE, FALSE };
+
+// most likely candidates come first, everything after a match can be skipped unless we want all of them
+local int32 detect_candidates(deflate_params *candidates)
+{
+	int32 num_candidates = 0;
+
+	for (int32 i = DEFLATE_MIN_COMPARE - 1; i <= DEFLATE_MAX_COMPARE; i++)
+	{
+		int32 max_compares = i < DEFLATE_MIN_COMPARE ? DEFLATE_MAX_COMPARES_DEFAULT : i;
+
+		if (i == DEFLATE_MAX_COMPARES_DEFAULT) continue;
+
+		for (int32 j = 0; j < sizeof(strategies) / sizeof(*strategies); j++)
+		{
+			for (int32 k = 0; k < sizeof(greedy_flags) / sizeof(*greedy_flags); k++)
+			{
+				if (greedy_flags[k] && max_compares > DEFLATE_MIN_COMPARE && max_compares < DEFLATE_GREEDY_COMPARE_THRESHOLD) continue;
+
+				candidates[num_candidates].max_compares = max_compares;
+				candidates[num_candidates].strategy = strategies[j];
+				candidates[num_candidates].greedy_flag = greedy_flags[k];
+				num_candidates++;
+			}
+		}
+	}
+
+	return num_candidates;
+}
+
+local bool32 detect_inflate(detect_job *job, byte *in_buf, size_t in_buf_size)
+{
+	void *inflate_wd = calloc(max(1, Inf32BufSize()), 1);
+	size_t in_buf_point = 0;
+	size_t data_alloc = DETECT_IN_BUF_SIZE * 16;
+	int32 code;
+
+	job->data = malloc(data_alloc);
+	job->data_size = 0;
+
+	do
+	{
+		size_t temp_size = in_buf_size;
+		size_t temp_max = DETECT_IN_BUF_SIZE;
+
+		if (job->data_size + temp_max > data_alloc)
+		{
+			data_alloc *= 2;
+			job->data = realloc(job->data, data_alloc);
+		}
+
+		code = Inf32Decode(in_buf, in_buf_point, &temp_size, job->data + job->data_size, 0, &temp_max, inflate_wd, TRUE);
+
+		in_buf_point += temp_size;
+		job->data_size += temp_max;
+	}
+	while (code == INFLATE_OK);
+
+	rge_free(inflate_wd);
+
+	job->compressed = in_buf;
+	job->compressed_size = in_buf_point;
+
+	return code == INFLATE_EOF;
+}
+
+local bool32 detect_abort(detect_worker *worker)
+{
+	return worker->mismatch || (!worker->job->find_all && worker->candidate > worker->job->first_match);
+}
+
+local int32 detect_flush(byte *out_buf_ofs, int32 out_buf_size)
+{
+	detect_worker *worker = current_worker;
+	detect_job *job = worker->job;
+
+	if (worker->out_pos + out_buf_size > job->compressed_size || memcmp(job->compressed + worker->out_pos, out_buf_ofs, out_buf_size))
+	{
+		worker->mismatch = TRUE;
+
+		return 1;
+	}
+
+	worker->out_pos += out_buf_size;
+
+	return detect_abort(worker);
+}
+
+local bool32 detect_candidate(detect_worker *worker, deflate_params *params)
+{
+	detect_job *job = worker->job;
+
+	worker->out_pos = 0;
+	worker->mismatch = FALSE;
+
+	memzero(worker->wd, deflate_buf_size());
+	deflate_init(worker->wd, params->max_compares, params->strategy, params->greedy_flag, worker->out_buf, DETECT_OUT_BUF_SIZE, &detect_flush);
+
+	for (size_t pos = 0; pos < job->data_size; pos += DETECT_IN_BUF_SIZE)
+	{
+		int32 size = (int32)min(DETECT_IN_BUF_SIZE, job->data_size - pos);
+
+		if (deflate_data(worker->wd, job->data + pos, size, FALSE) == DEFLATE_ERROR || detect_abort(worker)) break;
+	}
+
+	if (!detect_abort(worker)) deflate_data(worker->wd, NULL, 0, TRUE);
+
+	deflate_deinit(worker->wd);
+
+	return !detect_abort(worker) && worker->out_pos == job->compressed_size;
+}
+
+local void detect_thread(void *arg)
+{
+	detect_worker *worker = (detect_worker *)arg;
+	detect_job *job = worker->job;
+
+	current_worker = worker;
+
+	for (ever)
+	{
+		worker->candidate = rge_atomic_inc(&job->next_candidate) - 1;
+
+		if (worker->candidate >= job->num_candidates) break;
+
+		if (!job->find_all && worker->candidate > job->first_match) break;
+
+		if (detect_candidate(worker, &job->candidates[worker->candidate]))
+		{
+			rge_mutex_lock(&job->mutex);
+
+			job->matched[worker->candidate] = TRUE;
+
+			if (worker->candidate < job->first_match) job->first_match = worker->candidate;
+
+			rge_mutex_unlock(&job->mutex);
+		}
+	}
+
+	current_worker = NULL;
+}
+
+local int32 detect_compare_params(const void *a, const void *b)
+{
+	deflate_params *pa = (deflate_params *)a;
+	deflate_params *pb = (deflate_params *)b;
+
+	if (pa->strategy != pb->strategy) return pb->strategy - pa->strategy;
+	if (pa->greedy_flag != pb->greedy_flag) return pb->greedy_flag - pa->greedy_flag;
+
+	return pa->max_compares - pb->max_compares;
+}
+
+int32 deflate_detect(byte *in_buf, size_t in_buf_size, int32 num_threads, bool32 find_all, deflate_params *matches, int32 max_matches, size_t *stream_size)
+{
+	detect_job job = ZEROMEM;
+
+	if (!detect_inflate(&job, in_buf, in_buf_size))
+	{
+		rge_free(job.data);
+
+		return DETECT_ERROR;
+	}
+
+	if (stream_size) *stream_size = job.compressed_size;
+
+	job.candidates = malloc(sizeof(deflate_params) * DETECT_MAX_MATCHES);
+	job.num_candidates = detect_candidates(job.candidates);
+	job.matched = calloc(job.num_candidates, sizeof(bool32));
+	job.next_candidate = 0;
+	job.first_match = job.num_candidates;
+	job.find_all = find_all;
+
+	rge_mutex_init(&job.mutex);
+
+	num_threads = max(1, min(num_threads, job.num_candidates));
+
+	detect_worker *workers = calloc(num_threads, sizeof(detect_worker));
+
+	for (int32 i = 0; i < num_threads; i++)
+	{
+		workers[i].job = &job;
+		workers[i].wd = malloc(deflate_buf_size());
+	}
+
+	for (int32 i = 1; i < num_threads; i++)
+	{
+		if (!rge_thread_create(&workers[i].thread, detect_thread, &workers[i])) workers[i].job = NULL;
+	}
+
+	detect_thread(&workers[0]);
+
+	for (int32 i = 1; i < num_threads; i++)
+	{
+		if (workers[i].job) rge_thread_join(&workers[i].thread);
+	}
+
+	int32 num_matches = 0;
+
+	for (int32 i = 0; i < job.num_candidates && num_matches < max_matches; i++)
+	{
+		if (!job.matched[i]) continue;
+
+		if (!find_all && i != job.first_match) continue;
+
+		matches[num_matches++] = job.candidates[i];
+
+		// flash search ignores max_compares, so the skipped ones match as well
+		if (find_all && job.candidates[i].greedy_flag && job.candidates[i].max_compares == DEFLATE_MIN_COMPARE)
+		{
+			for (int32 j = DEFLATE_MIN_COMPARE + 1; j < DEFLATE_GREEDY_COMPARE_THRESHOLD && num_matches < max_matches; j++)
+			{
+				matches[num_matches] = job.candidates[i];
+				matches[num_matches++].max_compares = j;
+			}
+		}
+	}
+
+	if (find_all) qsort(matches, num_matches, sizeof(deflate_params), detect_compare_params);
+
+	for (int32 i = 0; i < num_threads; i++)
+	{
+		rge_free(workers[i].wd);
+	}
+
+	rge_free(workers);
+	rge_mutex_destroy(&job.mutex);
+	rge_free(job.matched);
+	rge_free(job.candidates);
+	rge_free(job.data);
+
+	return num_matches;
+}
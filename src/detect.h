@@ -0,0 +1,13 @@
+#pragma once
+
+#include "main.h"
+
+#include "compress.h"
+
+#define DETECT_ERROR -1
+
+#define DETECT_MAX_MATCHES ((DEFLATE_MAX_COMPARE + 1) * 6) // every max_compares for every strategy and greedy_flag
+
+// inflates in_buf and searches the game deflate parameters that reproduce its compressed stream exactly,
+// returns the number of matching parameters written to matches (all of them if find_all, else the most likely one) or DETECT_ERROR
+int32 deflate_detect(byte *in_buf, size_t in_buf_size, int32 num_threads, bool32 find_all, deflate_params *matches, int32 max_matches, size_t *stream_size);
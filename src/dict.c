@@ -0,0 +1,156 @@
+#include "dict.h"
+
+// cover style training: every substring of DICT_KMER_SIZE bytes is scored by the number of samples it's in,
+// the samples are split into one epoch per dictionary segment and each epoch contributes its best scoring segment,
+// substrings of picked segments score nothing afterwards so the same boilerplate isn't picked twice
+
+#define DICT_KMER_SIZE 6
+#define DICT_SEGMENT_SIZE 64
+
+#define DICT_HASH_BITS 20
+#define DICT_HASH_SIZE (1 << DICT_HASH_BITS)
+
+typedef struct dict_segment dict_segment;
+
+struct dict_segment
+{
+	size_t pos;
+	uint32 score;
+};
+
+local uint32 dict_hash(byte *p)
+{
+	uint64 v = 0;
+
+	memcpy(&v, p, DICT_KMER_SIZE);
+
+	return (uint32)((v * 0x9E3779B97F4A7C15ull) >> (64 - DICT_HASH_BITS));
+}
+
+local int dict_compare_segments(const void *a, const void *b)
+{
+	uint32 score_a = ((dict_segment *)a)->score;
+	uint32 score_b = ((dict_segment *)b)->score;
+
+	return (score_a > score_b) - (score_a < score_b);
+}
+
+int32 dict_train(byte *samples, size_t *sample_sizes, int32 num_samples, byte *dict, int32 dict_size)
+{
+	size_t total_size = 0;
+
+	for (int32 i = 0; i < num_samples; i++)
+	{
+		total_size += sample_sizes[i];
+	}
+
+	if (dict_size <= 0 || !total_size) return 0;
+
+	if (total_size <= (size_t)dict_size)
+	{
+		memcpy(dict, samples, total_size);
+
+		return (int32)total_size;
+	}
+
+	int32 num_segments = max(1, dict_size / DICT_SEGMENT_SIZE);
+
+	uint32 *freq = calloc(DICT_HASH_SIZE, sizeof(uint32));
+	int32 *seen = malloc(DICT_HASH_SIZE * sizeof(int32));
+	dict_segment *segments = malloc(num_segments * sizeof(dict_segment));
+
+	if (!freq || !seen || !segments)
+	{
+		rge_free(freq);
+		rge_free(seen);
+		rge_free(segments);
+
+		return 0;
+	}
+
+	for (int32 i = 0; i < DICT_HASH_SIZE; i++)
+	{
+		seen[i] = -1;
+	}
+
+	size_t ofs = 0;
+
+	// in how many samples each substring is, with a single sample how often it's in there
+	for (int32 i = 0; i < num_samples; ofs += sample_sizes[i++])
+	{
+		for (size_t pos = 0; pos + DICT_KMER_SIZE <= sample_sizes[i]; pos++)
+		{
+			uint32 h = dict_hash(samples + ofs + pos);
+
+			if (num_samples == 1 || seen[h] != i)
+			{
+				freq[h]++;
+				seen[h] = i;
+			}
+		}
+	}
+
+	// a substring only one sample has doesn't help the others
+	if (num_samples > 1)
+	{
+		for (int32 i = 0; i < DICT_HASH_SIZE; i++)
+		{
+			if (freq[i] < 2) freq[i] = 0;
+		}
+	}
+
+	size_t epoch_size = max(total_size / num_segments, DICT_SEGMENT_SIZE);
+	int32 num_picked = 0;
+
+	for (size_t epoch = 0; epoch + DICT_SEGMENT_SIZE <= total_size && num_picked < num_segments; epoch += epoch_size)
+	{
+		size_t last_pos = min(epoch + epoch_size, total_size - DICT_SEGMENT_SIZE + 1);
+		uint32 score = 0;
+
+		for (size_t pos = epoch; pos <= epoch + DICT_SEGMENT_SIZE - DICT_KMER_SIZE; pos++)
+		{
+			score += freq[dict_hash(samples + pos)];
+		}
+
+		size_t best_pos = epoch;
+		uint32 best_score = score;
+
+		// slide the segment through the epoch, one substring leaves at the front and one comes in at the back
+		for (size_t pos = epoch + 1; pos < last_pos; pos++)
+		{
+			score -= freq[dict_hash(samples + pos - 1)];
+			score += freq[dict_hash(samples + pos + DICT_SEGMENT_SIZE - DICT_KMER_SIZE)];
+
+			if (score > best_score)
+			{
+				best_score = score;
+				best_pos = pos;
+			}
+		}
+
+		if (!best_score) continue;
+
+		segments[num_picked].pos = best_pos;
+		segments[num_picked].score = best_score;
+		num_picked++;
+
+		for (size_t pos = best_pos; pos <= best_pos + DICT_SEGMENT_SIZE - DICT_KMER_SIZE; pos++)
+		{
+			freq[dict_hash(samples + pos)] = 0;
+		}
+	}
+
+	// best segments last, they end up closest to the data and survive if a window is smaller than the dictionary
+	qsort(segments, num_picked, sizeof(dict_segment), dict_compare_segments);
+
+	for (int32 i = 0; i < num_picked; i++)
+	{
+		memcpy(dict + i * DICT_SEGMENT_SIZE, samples + segments[i].pos, DICT_SEGMENT_SIZE);
+	}
+
+	rge_free(freq);
+	rge_free(seen);
+	rge_free(segments);
+
+	return num_picked * DICT_SEGMENT_SIZE;
+}
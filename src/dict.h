@@ -0,0 +1,12 @@
+#pragma once
+
+#include "main.h"
+
+#include "compress.h"
+
+#define DICT_DEFAULT_SIZE 0x8000 // what fits into the deflate window
+#define DICT_MIN_SIZE 0x100
+
+// builds a preset dictionary from the concatenated samples, made of the segments that share the most substrings with the other samples,
+// the most useful ones at the end so they're closest to the data, returns the dictionary size (at most dict_size)
+int32 dict_train(byte *samples, size_t *sample_sizes, int32 num_samples, byte *dict, int32 dict_size);
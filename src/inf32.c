@@ -1,72 +1,1511 @@
-#include <zlib.h>
+#include "thread.h"
 
 #include "compress.h"
 
-static void *zalloc(void *opaque, uint32 items, uint32 size)
+// in-tree raw inflate: 64-bit bit buffer refilled a word at a time, decode tables that give a literal or a length/distance
+// together with its extra bit count in one lookup (long codes go through a subtable) and match copies in 8 to 32 byte chunks,
+// the whole input has to be there, the output is decoded into a window and handed out in pieces of at most INF32_OUT_SIZE,
+// or in one go straight into the caller's buffer with Inf32DecodeFull, or split among threads with Inf32DecodeParallel
+
+#define INF32_MAX_MATCH 258
+#define INF32_WINDOW_SIZE 0x8000
+#define INF32_OUT_SIZE 0x10000 // most handed out per call
+#define INF32_COPY_SLACK 32 // match copies write up to this many bytes past the match
+#define INF32_BUF_SIZE (INF32_WINDOW_SIZE + INF32_OUT_SIZE + INF32_MAX_MATCH + INF32_COPY_SLACK)
+
+#define INF32_MAX_CODE_SIZE 15
+#define INF32_LIT_LEN_BITS 10
+#define INF32_DIST_BITS 8
+#define INF32_CODE_LEN_BITS 7
+
+#define INF32_NUM_LIT_LEN 288
+#define INF32_NUM_DIST 32
+#define INF32_NUM_CODE_LEN 19
+
+// main table plus the worst case of one full subtable per symbol
+#define INF32_LIT_LEN_TABLE_SIZE ((1 << INF32_LIT_LEN_BITS) + INF32_NUM_LIT_LEN * (1 << (INF32_MAX_CODE_SIZE - INF32_LIT_LEN_BITS)))
+#define INF32_DIST_TABLE_SIZE ((1 << INF32_DIST_BITS) + INF32_NUM_DIST * (1 << (INF32_MAX_CODE_SIZE - INF32_DIST_BITS)))
+#define INF32_CODE_LEN_TABLE_SIZE (1 << INF32_CODE_LEN_BITS)
+
+// table entries: codeword length (subtable index bits for INF32_SUB) in bits 0-4, extra bits in 8-11, flags in 12-15,
+// literal, length/distance base, code length symbol or subtable offset in 16-31
+#define INF32_LITERAL 0x1000
+#define INF32_END 0x2000
+#define INF32_SUB 0x4000
+#define INF32_BAD 0x8000
+
+#define INF32_TABLE_LIT_LEN 0
+#define INF32_TABLE_DIST 1
+#define INF32_TABLE_CODE_LEN 2
+
+#define INF32_STATE_HEADER 0
+#define INF32_STATE_STORED 1
+#define INF32_STATE_HUFFMAN 2
+#define INF32_STATE_DONE 3
+#define INF32_STATE_ERROR 4
+
+typedef struct inf32_work_data inf32_work_data;
+
+struct inf32_work_data
+{
+	byte *in_buf;
+	byte *in_ptr;
+	byte *in_end;
+	uint64 bit_buf;
+	int32 bit_len;
+	int32 state;
+	bool32 final_flag;
+	int32 stored_left;
+	uint32 *lit_len; // tables of the current block
+	uint32 *dist;
+	bool32 fixed_built;
+	size_t out_given; // handed out so far, everything before it is history
+	size_t out_valid; // decoded so far
+	byte *dict; // used by the next stream only
+	int32 dict_size;
+	byte *hist; // history in front of the output of a one-shot decode
+	int32 hist_size;
+	char *msg;
+	uint32 lit_len_table[INF32_LIT_LEN_TABLE_SIZE];
+	uint32 dist_table[INF32_DIST_TABLE_SIZE];
+	uint32 fixed_lit_len_table[INF32_LIT_LEN_TABLE_SIZE];
+	uint32 fixed_dist_table[INF32_DIST_TABLE_SIZE];
+	uint32 code_len_table[INF32_CODE_LEN_TABLE_SIZE];
+	byte buf[INF32_BUF_SIZE];
+};
+
+local uint16 len_base[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+local byte len_base_extra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+local uint16 dist_base[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+local byte dist_base_extra[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+local byte code_len_order[] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+local uint64 inf32_load_64(byte *p)
+{
+	uint64 v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v; // little endian only, like the rest
+}
+
+// at least 56 bits after this, past the end of the input zeros come in
+#define INF32_REFILL() do { \
+	if (in_end - in_ptr >= 8) \
+	{ \
+		bit_buf |= inf32_load_64(in_ptr) << bit_len; \
+		in_ptr += (63 - bit_len) >> 3; \
+		bit_len |= 56; \
+	} \
+	else \
+	{ \
+		while (bit_len < 56) \
+		{ \
+			bit_buf |= (uint64)(in_ptr < in_end ? *in_ptr : 0) << bit_len; \
+			in_ptr++; \
+			bit_len += 8; \
+		} \
+	} \
+} while (0)
+
+// the last symbol took bits from the zeros past the end of the input, it's an error and isn't output
+#define INF32_PAST_END() (in_ptr > in_end && (size_t)(in_ptr - in_end) * 8 > (size_t)bit_len)
+
+#define INF32_BITS(n) ((uint32)bit_buf & ((1u << (n)) - 1))
+#define INF32_DROP(n) do { bit_buf >>= (n); bit_len -= (n); } while (0)
+
+#define INF32_LOAD() \
+	byte *in_ptr = wd->in_ptr; \
+	byte *in_end = wd->in_end; \
+	uint64 bit_buf = wd->bit_buf; \
+	int32 bit_len = wd->bit_len
+
+#define INF32_SAVE() do { \
+	wd->in_ptr = in_ptr; \
+	wd->bit_buf = bit_buf; \
+	wd->bit_len = bit_len; \
+} while (0)
+
+local uint32 inf32_entry(int32 type, int32 sym)
+{
+	if (type == INF32_TABLE_CODE_LEN) return sym << 16;
+
+	if (type == INF32_TABLE_DIST)
+	{
+		if (sym >= 30) return INF32_BAD;
+
+		return (dist_base[sym] << 16) | (dist_base_extra[sym] << 8);
+	}
+
+	if (sym < 256) return (sym << 16) | INF32_LITERAL;
+	if (sym == 256) return INF32_END;
+	if (sym >= 286) return INF32_BAD;
+
+	return (len_base[sym - 257] << 16) | (len_base_extra[sym - 257] << 8);
+}
+
+// builds the decode table for code sizes, fails on codes inflate doesn't take: over-subscribed ones,
+// and incomplete ones unless it's a single one bit length/distance code
+local bool32 inf32_build_table(uint32 *table, int32 table_bits, byte *code_sizes, int32 num_symbols, int32 type)
+{
+	int32 num_codes[INF32_MAX_CODE_SIZE + 1] = ZEROMEM;
+	uint32 next_code[INF32_MAX_CODE_SIZE + 1] = ZEROMEM;
+	uint16 codes[INF32_NUM_LIT_LEN];
+	byte sub_bits[1 << INF32_LIT_LEN_BITS] = ZEROMEM;
+	int32 table_size = 1 << table_bits;
+	int32 max_size = 0;
+
+	for (int32 i = 0; i < num_symbols; i++)
+	{
+		num_codes[code_sizes[i]]++;
+
+		if (code_sizes[i] > max_size) max_size = code_sizes[i];
+	}
+
+	for (int32 i = 0; i < table_size; i++)
+	{
+		table[i] = INF32_BAD;
+	}
+
+	// nothing to decode, only fails if a symbol is read
+	if (!max_size) return TRUE;
+
+	int32 left = 1;
+
+	for (int32 i = 1; i <= INF32_MAX_CODE_SIZE; i++)
+	{
+		left = (left << 1) - num_codes[i];
+
+		if (left < 0) return FALSE;
+	}
+
+	if (left > 0 && (type == INF32_TABLE_CODE_LEN || max_size != 1)) return FALSE;
+
+	num_codes[0] = 0;
+
+	for (int32 i = 1, code = 0; i <= INF32_MAX_CODE_SIZE; i++)
+	{
+		code = (code + num_codes[i - 1]) << 1;
+		next_code[i] = code;
+	}
+
+	// codes are sent msb first, the tables are indexed lsb first
+	for (int32 i = 0; i < num_symbols; i++)
+	{
+		int32 len = code_sizes[i];
+		uint32 code = next_code[len]++;
+		uint32 rev = 0;
+
+		if (!len) continue;
+
+		for (int32 j = 0; j < len; j++)
+		{
+			rev = (rev << 1) | ((code >> j) & 1);
+		}
+
+		codes[i] = (uint16)rev;
+
+		if (len > table_bits)
+		{
+			int32 prefix = rev & (table_size - 1);
+
+			sub_bits[prefix] = (byte)max(sub_bits[prefix], len - table_bits);
+		}
+	}
+
+	int32 offset = table_size;
+
+	for (int32 i = 0; i < table_size; i++)
+	{
+		if (!sub_bits[i]) continue;
+
+		table[i] = (offset << 16) | INF32_SUB | sub_bits[i];
+
+		for (int32 j = 0; j < (1 << sub_bits[i]); j++)
+		{
+			table[offset + j] = INF32_BAD;
+		}
+
+		offset += 1 << sub_bits[i];
+	}
+
+	for (int32 i = 0; i < num_symbols; i++)
+	{
+		int32 len = code_sizes[i];
+
+		if (!len) continue;
+
+		uint32 entry = inf32_entry(type, i) | len;
+
+		if (len <= table_bits)
+		{
+			for (int32 j = codes[i]; j < table_size; j += 1 << len)
+			{
+				table[j] = entry;
+			}
+		}
+		else
+		{
+			int32 prefix = codes[i] & (table_size - 1);
+			uint32 *sub = table + (table[prefix] >> 16);
+
+			for (int32 j = codes[i] >> table_bits; j < (1 << sub_bits[prefix]); j += 1 << (len - table_bits))
+			{
+				sub[j] = entry;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+local void inf32_build_fixed(inf32_work_data *wd)
+{
+	byte code_sizes[INF32_NUM_LIT_LEN];
+
+	for (int32 i = 0; i < INF32_NUM_LIT_LEN; i++)
+	{
+		code_sizes[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	}
+
+	inf32_build_table(wd->fixed_lit_len_table, INF32_LIT_LEN_BITS, code_sizes, INF32_NUM_LIT_LEN, INF32_TABLE_LIT_LEN);
+
+	for (int32 i = 0; i < INF32_NUM_DIST; i++)
+	{
+		code_sizes[i] = 5;
+	}
+
+	inf32_build_table(wd->fixed_dist_table, INF32_DIST_BITS, code_sizes, INF32_NUM_DIST, INF32_TABLE_DIST);
+
+	wd->fixed_built = TRUE;
+}
+
+local bool32 inf32_dynamic_header(inf32_work_data *wd)
+{
+	byte code_sizes[INF32_NUM_LIT_LEN + INF32_NUM_DIST] = ZEROMEM;
+	byte code_len_sizes[INF32_NUM_CODE_LEN] = ZEROMEM;
+
+	INF32_LOAD();
+
+	INF32_REFILL();
+
+	int32 num_lit_len = INF32_BITS(5) + 257;
+	INF32_DROP(5);
+	int32 num_dist = INF32_BITS(5) + 1;
+	INF32_DROP(5);
+	int32 num_code_len = INF32_BITS(4) + 4;
+	INF32_DROP(4);
+
+	if (num_lit_len > 286 || num_dist > 30)
+	{
+		wd->msg = "too many length or distance symbols";
+
+		return FALSE;
+	}
+
+	// 19 sizes are one bit more than a refill guarantees
+	for (int32 i = 0; i < num_code_len; i++)
+	{
+		if (!(i & 7)) INF32_REFILL();
+
+		code_len_sizes[code_len_order[i]] = (byte)INF32_BITS(3);
+		INF32_DROP(3);
+	}
+
+	if (!inf32_build_table(wd->code_len_table, INF32_CODE_LEN_BITS, code_len_sizes, INF32_NUM_CODE_LEN, INF32_TABLE_CODE_LEN))
+	{
+		wd->msg = "invalid code lengths set";
+
+		return FALSE;
+	}
+
+	for (int32 i = 0; i < num_lit_len + num_dist;)
+	{
+		INF32_REFILL();
+
+		uint32 entry = wd->code_len_table[INF32_BITS(INF32_CODE_LEN_BITS)];
+
+		if (entry & INF32_BAD)
+		{
+			wd->msg = "invalid code lengths set";
+
+			return FALSE;
+		}
+
+		INF32_DROP(entry & 0x1F);
+
+		int32 sym = entry >> 16;
+		int32 size = 0;
+		int32 run;
+
+		if (sym < 16)
+		{
+			code_sizes[i++] = (byte)sym;
+
+			continue;
+		}
+		else if (sym == 16)
+		{
+			if (!i)
+			{
+				wd->msg = "invalid bit length repeat";
+
+				return FALSE;
+			}
+
+			size = code_sizes[i - 1];
+			run = 3 + INF32_BITS(2);
+			INF32_DROP(2);
+		}
+		else if (sym == 17)
+		{
+			run = 3 + INF32_BITS(3);
+			INF32_DROP(3);
+		}
+		else
+		{
+			run = 11 + INF32_BITS(7);
+			INF32_DROP(7);
+		}
+
+		if (i + run > num_lit_len + num_dist)
+		{
+			wd->msg = "invalid bit length repeat";
+
+			return FALSE;
+		}
+
+		while (run--) code_sizes[i++] = (byte)size;
+	}
+
+	INF32_SAVE();
+
+	if (!code_sizes[256])
+	{
+		wd->msg = "invalid code -- missing end-of-block";
+
+		return FALSE;
+	}
+
+	if (!inf32_build_table(wd->lit_len_table, INF32_LIT_LEN_BITS, code_sizes, num_lit_len, INF32_TABLE_LIT_LEN))
+	{
+		wd->msg = "invalid literal/lengths set";
+
+		return FALSE;
+	}
+
+	if (!inf32_build_table(wd->dist_table, INF32_DIST_BITS, code_sizes + num_lit_len, num_dist, INF32_TABLE_DIST))
+	{
+		wd->msg = "invalid distances set";
+
+		return FALSE;
+	}
+
+	wd->lit_len = wd->lit_len_table;
+	wd->dist = wd->dist_table;
+
+	return TRUE;
+}
+
+local bool32 inf32_block_header(inf32_work_data *wd)
+{
+	INF32_LOAD();
+
+	INF32_REFILL();
+
+	wd->final_flag = INF32_BITS(1);
+	INF32_DROP(1);
+	int32 type = INF32_BITS(2);
+	INF32_DROP(2);
+
+	if (type == 0)
+	{
+		// stored, give back the whole bytes in the bit buffer and read the lengths from the input directly
+		INF32_DROP(bit_len & 7);
+
+		in_ptr -= bit_len >> 3;
+		bit_buf = 0;
+		bit_len = 0;
+
+		if (in_end - in_ptr < 4)
+		{
+			wd->msg = "unexpected end of stream";
+
+			return FALSE;
+		}
+
+		int32 len = in_ptr[0] | (in_ptr[1] << 8);
+		int32 nlen = in_ptr[2] | (in_ptr[3] << 8);
+
+		if (len != (~nlen & 0xFFFF))
+		{
+			wd->msg = "invalid stored block lengths";
+
+			return FALSE;
+		}
+
+		in_ptr += 4;
+
+		wd->stored_left = len;
+		wd->state = INF32_STATE_STORED;
+	}
+	else if (type == 1)
+	{
+		if (!wd->fixed_built) inf32_build_fixed(wd);
+
+		wd->lit_len = wd->fixed_lit_len_table;
+		wd->dist = wd->fixed_dist_table;
+		wd->state = INF32_STATE_HUFFMAN;
+	}
+	else if (type == 2)
+	{
+		INF32_SAVE();
+
+		if (!inf32_dynamic_header(wd)) return FALSE;
+
+		wd->state = INF32_STATE_HUFFMAN;
+
+		return TRUE;
+	}
+	else
+	{
+		wd->msg = "invalid block type";
+
+		return FALSE;
+	}
+
+	INF32_SAVE();
+
+	return TRUE;
+}
+
+local bool32 inf32_stored(inf32_work_data *wd, byte **out, byte *out_target)
+{
+	int32 len = (int32)min(wd->stored_left, out_target - *out);
+
+	if (wd->in_end - wd->in_ptr < len)
+	{
+		wd->msg = "unexpected end of stream";
+
+		return FALSE;
+	}
+
+	memcpy(*out, wd->in_ptr, len);
+
+	*out += len;
+	wd->in_ptr += len;
+	wd->stored_left -= len;
+
+	if (!wd->stored_left) wd->state = wd->final_flag ? INF32_STATE_DONE : INF32_STATE_HEADER;
+
+	return TRUE;
+}
+
+// decodes symbols until the block ends or out reaches out_target, a match can run past it by up to INF32_MAX_MATCH - 1
+// bytes and the copies write INF32_COPY_SLACK more, out_base is where the history starts
+local bool32 inf32_huffman(inf32_work_data *wd, byte *out_base, byte **_out, byte *out_target)
+{
+	uint32 *lit_len = wd->lit_len;
+	uint32 *dist_table = wd->dist;
+	byte *out = *_out;
+	bool32 ok = TRUE;
+
+	INF32_LOAD();
+
+	while (out < out_target)
+	{
+		// 56 bits are enough for a length with its extra bits and a distance with its extra bits
+		INF32_REFILL();
+
+		uint32 entry = lit_len[INF32_BITS(INF32_LIT_LEN_BITS)];
+
+		if (entry & INF32_SUB) entry = lit_len[(entry >> 16) + ((uint32)(bit_buf >> INF32_LIT_LEN_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+		if (entry & INF32_LITERAL)
+		{
+			INF32_DROP(entry & 0x1F);
+
+			if (INF32_PAST_END())
+			{
+				wd->msg = "unexpected end of stream";
+				ok = FALSE;
+
+				break;
+			}
+
+			*out++ = (byte)(entry >> 16);
+
+			// two more literals still fit into what's left of the refill, unless it has zeros from past the end in it
+			if (in_ptr > in_end) continue;
+
+			entry = lit_len[INF32_BITS(INF32_LIT_LEN_BITS)];
+
+			if (entry & INF32_SUB) entry = lit_len[(entry >> 16) + ((uint32)(bit_buf >> INF32_LIT_LEN_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+			if (!(entry & INF32_LITERAL)) continue;
+
+			INF32_DROP(entry & 0x1F);
+
+			*out++ = (byte)(entry >> 16);
+
+			entry = lit_len[INF32_BITS(INF32_LIT_LEN_BITS)];
+
+			if (entry & INF32_SUB) entry = lit_len[(entry >> 16) + ((uint32)(bit_buf >> INF32_LIT_LEN_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+			if (!(entry & INF32_LITERAL)) continue;
+
+			INF32_DROP(entry & 0x1F);
+
+			*out++ = (byte)(entry >> 16);
+
+			continue;
+		}
+
+		if (entry & (INF32_END | INF32_BAD))
+		{
+			if (entry & INF32_BAD)
+			{
+				wd->msg = "invalid literal/length code";
+				ok = FALSE;
+
+				break;
+			}
+
+			INF32_DROP(entry & 0x1F);
+
+			wd->state = wd->final_flag ? INF32_STATE_DONE : INF32_STATE_HEADER;
+
+			break;
+		}
+
+		int32 n = entry & 0x1F;
+		int32 extra = (entry >> 8) & 0xF;
+		int32 len = (entry >> 16) + ((uint32)(bit_buf >> n) & ((1u << extra) - 1));
+
+		INF32_DROP(n + extra);
+
+		entry = dist_table[INF32_BITS(INF32_DIST_BITS)];
+
+		if (entry & INF32_SUB) entry = dist_table[(entry >> 16) + ((uint32)(bit_buf >> INF32_DIST_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+		if (entry & INF32_BAD)
+		{
+			wd->msg = "invalid distance code";
+			ok = FALSE;
+
+			break;
+		}
+
+		n = entry & 0x1F;
+		extra = (entry >> 8) & 0xF;
+
+		uint32 dist = (entry >> 16) + ((uint32)(bit_buf >> n) & ((1u << extra) - 1));
+
+		INF32_DROP(n + extra);
+
+		if (INF32_PAST_END())
+		{
+			wd->msg = "unexpected end of stream";
+			ok = FALSE;
+
+			break;
+		}
+
+		if (dist > (uint32)(out - out_base))
+		{
+			if (dist > (size_t)(out - out_base) + wd->hist_size)
+			{
+				wd->msg = "invalid distance too far back";
+				ok = FALSE;
+
+				break;
+			}
+
+			// reaches into the dictionary of a one-shot decode, only happens in its first window
+			for (byte *end = out + len; out < end; out++)
+			{
+				ptrdiff from = (out - out_base) - (ptrdiff)dist;
+
+				*out = from < 0 ? wd->hist[wd->hist_size + from] : out_base[from];
+			}
+
+			continue;
+		}
+
+		byte *src = out - dist;
+		byte *end = out + len;
+
+		// chunks no larger than the distance never read what the same chunk writes
+		if (dist >= 32)
+		{
+			do
+			{
+				memcpy(out, src, 32);
+				out += 32;
+				src += 32;
+			}
+			while (out < end);
+		}
+		else if (dist >= 16)
+		{
+			do
+			{
+				memcpy(out, src, 16);
+				out += 16;
+				src += 16;
+			}
+			while (out < end);
+		}
+		else if (dist >= 8)
+		{
+			do
+			{
+				memcpy(out, src, 8);
+				out += 8;
+				src += 8;
+			}
+			while (out < end);
+		}
+		else if (dist == 1)
+		{
+			memset(out, *src, len);
+		}
+		else
+		{
+			do
+			{
+				*out++ = *src++;
+			}
+			while (out < end);
+		}
+
+		out = end;
+	}
+
+	INF32_SAVE();
+
+	*_out = out;
+
+	return ok;
+}
+
+// decodes symbols until the block ends, only adding up how much they'd output
+local bool32 inf32_scan_huffman(inf32_work_data *wd, size_t *size)
+{
+	uint32 *lit_len = wd->lit_len;
+	uint32 *dist_table = wd->dist;
+	size_t out_size = *size;
+	bool32 ok = TRUE;
+
+	INF32_LOAD();
+
+	for (ever)
+	{
+		INF32_REFILL();
+
+		// nothing else stops it if the zeros past the end decode as symbols
+		if (INF32_PAST_END())
+		{
+			wd->msg = "unexpected end of stream";
+			ok = FALSE;
+
+			break;
+		}
+
+		uint32 entry = lit_len[INF32_BITS(INF32_LIT_LEN_BITS)];
+
+		if (entry & INF32_SUB) entry = lit_len[(entry >> 16) + ((uint32)(bit_buf >> INF32_LIT_LEN_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+		if (entry & INF32_LITERAL)
+		{
+			INF32_DROP(entry & 0x1F);
+
+			out_size++;
+
+			// same as decoding, two more literals fit into the refill
+			entry = lit_len[INF32_BITS(INF32_LIT_LEN_BITS)];
+
+			if (entry & INF32_SUB) entry = lit_len[(entry >> 16) + ((uint32)(bit_buf >> INF32_LIT_LEN_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+			if (!(entry & INF32_LITERAL)) continue;
+
+			INF32_DROP(entry & 0x1F);
+
+			out_size++;
+
+			entry = lit_len[INF32_BITS(INF32_LIT_LEN_BITS)];
+
+			if (entry & INF32_SUB) entry = lit_len[(entry >> 16) + ((uint32)(bit_buf >> INF32_LIT_LEN_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+			if (!(entry & INF32_LITERAL)) continue;
+
+			INF32_DROP(entry & 0x1F);
+
+			out_size++;
+
+			continue;
+		}
+
+		if (entry & (INF32_END | INF32_BAD))
+		{
+			if (entry & INF32_BAD)
+			{
+				wd->msg = "invalid literal/length code";
+				ok = FALSE;
+
+				break;
+			}
+
+			INF32_DROP(entry & 0x1F);
+
+			wd->state = wd->final_flag ? INF32_STATE_DONE : INF32_STATE_HEADER;
+
+			break;
+		}
+
+		int32 n = entry & 0x1F;
+		int32 extra = (entry >> 8) & 0xF;
+
+		out_size += (entry >> 16) + ((uint32)(bit_buf >> n) & ((1u << extra) - 1));
+
+		INF32_DROP(n + extra);
+
+		entry = dist_table[INF32_BITS(INF32_DIST_BITS)];
+
+		if (entry & INF32_SUB) entry = dist_table[(entry >> 16) + ((uint32)(bit_buf >> INF32_DIST_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+		if (entry & INF32_BAD)
+		{
+			wd->msg = "invalid distance code";
+			ok = FALSE;
+
+			break;
+		}
+
+		INF32_DROP((entry & 0x1F) + ((entry >> 8) & 0xF));
+	}
+
+	INF32_SAVE();
+
+	*size = out_size;
+
+	return ok;
+}
+
+// the zeros past the end of the input are only there to keep the refill simple
+local bool32 inf32_check_end(inf32_work_data *wd)
+{
+	if (wd->in_ptr > wd->in_end && (size_t)(wd->in_ptr - wd->in_end) * 8 > (size_t)wd->bit_len)
+	{
+		wd->msg = "unexpected end of stream";
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// decodes until out reaches out_target or the stream is done, out_base is where the history starts
+local bool32 inf32_run(inf32_work_data *wd, byte *out_base, byte **out, byte *out_target)
+{
+	while (*out < out_target && wd->state != INF32_STATE_DONE)
+	{
+		bool32 ok;
+
+		if (wd->state == INF32_STATE_HEADER) ok = inf32_block_header(wd);
+		else if (wd->state == INF32_STATE_STORED) ok = inf32_stored(wd, out, out_target);
+		else ok = inf32_huffman(wd, out_base, out, out_target);
+
+		if (!ok) return FALSE;
+	}
+
+	return inf32_check_end(wd);
+}
+
+local void inf32_start(inf32_work_data *wd, byte *in_buf, size_t in_buf_size)
+{
+	wd->in_buf = in_buf;
+	wd->in_ptr = in_buf;
+	wd->in_end = in_buf + in_buf_size;
+	wd->bit_buf = 0;
+	wd->bit_len = 0;
+	wd->state = INF32_STATE_HEADER;
+	wd->final_flag = FALSE;
+	wd->out_given = 0;
+	wd->out_valid = 0;
+	wd->hist = NULL;
+	wd->hist_size = 0;
+	wd->msg = NULL;
+}
+
+// whole bytes the bit buffer has taken from the input, the last partial one counts too
+local size_t inf32_consumed(inf32_work_data *wd)
+{
+	return ((wd->in_ptr - wd->in_buf) * 8 - wd->bit_len + 7) >> 3;
+}
+
+local size_t inf32_bit_pos(inf32_work_data *wd)
+{
+	return (wd->in_ptr - wd->in_buf) * 8 - wd->bit_len;
+}
+
+local int32 inf32_error(inf32_work_data *wd)
+{
+	fprintf(stderr, "inflate error: %s\n", wd->msg);
+
+	wd->state = INF32_STATE_ERROR;
+
+	return INFLATE_ERROR;
+}
+
+size_t Inf32BufSize()
+{
+	return sizeof(inf32_work_data);
+}
+
+void Inf32SetDictionary(void *_wd, byte *dict, int32 dict_size)
+{
+	inf32_work_data *wd = (inf32_work_data *)_wd;
+
+	wd->dict = dict;
+	wd->dict_size = dict_size;
+}
+
+void Inf32Deinit(void *_wd)
+{
+}
+
+// in_buf_size is the size of the whole input on every call, buffered is ignored as the whole input always has to be there
+int32 Inf32Decode(byte *in_buf, size_t in_buf_ofs, size_t *in_buf_size, byte *out_buf, size_t out_buf_offset, size_t *out_buf_size, void *_wd, bool32 buffered)
+{
+	inf32_work_data *wd = (inf32_work_data *)_wd;
+
+	if (!in_buf_ofs)
+	{
+		inf32_start(wd, in_buf, *in_buf_size);
+
+		if (wd->dict_size > 0)
+		{
+			int32 dict_size = min(wd->dict_size, INF32_WINDOW_SIZE);
+
+			memcpy(wd->buf, wd->dict + wd->dict_size - dict_size, dict_size);
+
+			wd->out_given = dict_size;
+			wd->out_valid = dict_size;
+		}
+
+		wd->dict = NULL;
+		wd->dict_size = 0;
+	}
+
+	if (wd->state == INF32_STATE_ERROR)
+	{
+		*in_buf_size = 0;
+		*out_buf_size = 0;
+
+		return INFLATE_ERROR;
+	}
+
+	// keep a window of history in front of what's handed out next
+	if (wd->out_given > INF32_WINDOW_SIZE)
+	{
+		size_t shift = wd->out_given - INF32_WINDOW_SIZE;
+
+		memmove(wd->buf, wd->buf + shift, wd->out_valid - shift);
+
+		wd->out_given -= shift;
+		wd->out_valid -= shift;
+	}
+
+	size_t want = min(*out_buf_size, INF32_OUT_SIZE);
+	byte *out = wd->buf + wd->out_valid;
+
+	if (!inf32_run(wd, wd->buf, &out, wd->buf + wd->out_given + want))
+	{
+		*in_buf_size = 0;
+		*out_buf_size = 0;
+
+		return inf32_error(wd);
+	}
+
+	wd->out_valid = out - wd->buf;
+
+	size_t size = min(want, wd->out_valid - wd->out_given);
+
+	memcpy(out_buf + out_buf_offset, wd->buf + wd->out_given, size);
+	memzero(out_buf + out_buf_offset + size, *out_buf_size - size);
+
+	wd->out_given += size;
+
+	*in_buf_size = inf32_consumed(wd) - in_buf_ofs;
+	*out_buf_size = size;
+
+	return (wd->state == INF32_STATE_DONE && wd->out_given == wd->out_valid) ? INFLATE_EOF : INFLATE_OK;
+}
+
+int32 Inf32DecodeFull(byte *in_buf, size_t *in_buf_size, byte *out_buf, size_t out_buf_ofs, size_t *out_buf_size, void *_wd)
+{
+	inf32_work_data *wd = (inf32_work_data *)_wd;
+
+	if (!out_buf_ofs)
+	{
+		inf32_start(wd, in_buf, *in_buf_size);
+
+		// nothing to copy, matches read the end of the dictionary directly
+		wd->hist = wd->dict;
+		wd->hist_size = min(wd->dict_size, INF32_WINDOW_SIZE);
+
+		if (wd->hist_size > 0) wd->hist += wd->dict_size - wd->hist_size;
+
+		wd->dict = NULL;
+		wd->dict_size = 0;
+	}
+
+	if (wd->state == INF32_STATE_ERROR)
+	{
+		*in_buf_size = 0;
+		*out_buf_size = out_buf_ofs;
+
+		return INFLATE_ERROR;
+	}
+
+	byte *out = out_buf + out_buf_ofs;
+
+	// one past the end so a stream that fills out_buf exactly still gets to its end of block
+	bool32 ok = inf32_run(wd, out_buf, &out, out_buf + *out_buf_size + 1);
+
+	*in_buf_size = min(inf32_consumed(wd), *in_buf_size);
+	*out_buf_size = out - out_buf;
+
+	if (!ok) return inf32_error(wd);
+
+	return wd->state == INF32_STATE_DONE ? INFLATE_EOF : INFLATE_OK;
+}
+
+int32 Inf32ScanSize(byte *in_buf, size_t in_buf_size, size_t *out_size, void *_wd)
+{
+	inf32_work_data *wd = (inf32_work_data *)_wd;
+
+	inf32_start(wd, in_buf, in_buf_size);
+
+	*out_size = 0;
+
+	while (wd->state != INF32_STATE_DONE)
+	{
+		bool32 ok = TRUE;
+
+		if (wd->state == INF32_STATE_HEADER)
+		{
+			ok = inf32_block_header(wd);
+		}
+		else if (wd->state == INF32_STATE_STORED)
+		{
+			if (wd->in_end - wd->in_ptr < wd->stored_left)
+			{
+				wd->msg = "unexpected end of stream";
+				ok = FALSE;
+			}
+			else
+			{
+				*out_size += wd->stored_left;
+				wd->in_ptr += wd->stored_left;
+				wd->state = wd->final_flag ? INF32_STATE_DONE : INF32_STATE_HEADER;
+			}
+		}
+		else
+		{
+			ok = inf32_scan_huffman(wd, out_size);
+		}
+
+		if (!ok) return inf32_error(wd);
+	}
+
+	if (!inf32_check_end(wd)) return inf32_error(wd);
+
+	return INFLATE_EOF;
+}
+
+// parallel decode: the input is split into parts, each thread guesses where the first dynamic block in its part starts (the header has to
+// build complete codes) and decodes from there to the first block boundary past its part, back references into the unknown 32 KiB before
+// the guess become placeholders, the parts are then put together in order and a guess only counts if the part before ended exactly where
+// it started, otherwise that part is decoded again from where the one before really ended
+
+#define INF32_PARALLEL_MIN_PART 0x40000 // of input per thread, below that finding a block start isn't worth it
+#define INF32_PLACEHOLDER 256 // output symbols from here on are INF32_PLACEHOLDER + position in the window before the part
+
+typedef struct inf32_part inf32_part;
+
+struct inf32_part
 {
-	return calloc(size, items);
+	byte *in_buf;
+	size_t in_buf_size;
+	size_t start; // input range of the part
+	size_t end;
+	size_t start_bit; // block the decode started at, guessed for all but the first part
+	size_t stop_bit; // the decode stops at the first block boundary at or past this
+	size_t end_bit; // where it stopped
+	bool32 guess_flag;
+	bool32 thread_flag;
+	bool32 ok;
+	bool32 final_flag; // the decode got to the end of the stream
+	uint16 *out; // literals and placeholders
+	size_t out_size;
+	size_t out_alloc;
+	inf32_work_data *wd;
+	rge_thread thread;
 };
 
-static void zfree(void *opaque, void *address)
+local void inf32_seek(inf32_work_data *wd, size_t bit_pos)
 {
-	free(address);
+	wd->in_ptr = wd->in_buf + (bit_pos >> 3);
+	wd->bit_buf = 0;
+	wd->bit_len = 0;
+	wd->state = INF32_STATE_HEADER;
+	wd->final_flag = FALSE;
+	wd->msg = NULL;
+
+	if (bit_pos & 7)
+	{
+		INF32_LOAD();
+
+		INF32_REFILL();
+		INF32_DROP(bit_pos & 7);
+
+		INF32_SAVE();
+	}
 }
 
-static z_stream inflate_stream = ZEROMEM;
-static int32 inflate_code;
+local bool32 inf32_part_grow(inf32_part *part, size_t size)
+{
+	if (part->out_size + size <= part->out_alloc) return TRUE;
+
+	size_t new_alloc = max(part->out_alloc * 2, part->out_size + size);
+	uint16 *new_out = realloc(part->out, new_alloc * sizeof(uint16));
 
-size_t Inf32BufSize()
+	if (!new_out) return FALSE;
+
+	part->out = new_out;
+	part->out_alloc = new_alloc;
+
+	return TRUE;
+}
+
+// inf32_huffman with 16 bit output, matches that reach before the part write placeholders
+local bool32 inf32_part_huffman(inf32_work_data *wd, inf32_part *part)
+{
+	uint32 *lit_len = wd->lit_len;
+	uint32 *dist_table = wd->dist;
+	bool32 ok = TRUE;
+
+	INF32_LOAD();
+
+	for (ever)
+	{
+		if (!inf32_part_grow(part, INF32_MAX_MATCH))
+		{
+			wd->msg = "out of memory";
+			ok = FALSE;
+
+			break;
+		}
+
+		INF32_REFILL();
+
+		uint16 *out = part->out + part->out_size;
+		uint32 entry = lit_len[INF32_BITS(INF32_LIT_LEN_BITS)];
+
+		if (entry & INF32_SUB) entry = lit_len[(entry >> 16) + ((uint32)(bit_buf >> INF32_LIT_LEN_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+		if (entry & INF32_LITERAL)
+		{
+			INF32_DROP(entry & 0x1F);
+
+			// a wrong guess can go on for a long time on the zeros past the end
+			if (INF32_PAST_END())
+			{
+				wd->msg = "unexpected end of stream";
+				ok = FALSE;
+
+				break;
+			}
+
+			*out = (uint16)(entry >> 16);
+			part->out_size++;
+
+			continue;
+		}
+
+		if (entry & (INF32_END | INF32_BAD))
+		{
+			if (entry & INF32_BAD)
+			{
+				wd->msg = "invalid literal/length code";
+				ok = FALSE;
+
+				break;
+			}
+
+			INF32_DROP(entry & 0x1F);
+
+			wd->state = wd->final_flag ? INF32_STATE_DONE : INF32_STATE_HEADER;
+
+			break;
+		}
+
+		int32 n = entry & 0x1F;
+		int32 extra = (entry >> 8) & 0xF;
+		int32 len = (entry >> 16) + ((uint32)(bit_buf >> n) & ((1u << extra) - 1));
+
+		INF32_DROP(n + extra);
+
+		entry = dist_table[INF32_BITS(INF32_DIST_BITS)];
+
+		if (entry & INF32_SUB) entry = dist_table[(entry >> 16) + ((uint32)(bit_buf >> INF32_DIST_BITS) & ((1u << (entry & 0x1F)) - 1))];
+
+		if (entry & INF32_BAD)
+		{
+			wd->msg = "invalid distance code";
+			ok = FALSE;
+
+			break;
+		}
+
+		n = entry & 0x1F;
+		extra = (entry >> 8) & 0xF;
+
+		size_t dist = (entry >> 16) + ((uint32)(bit_buf >> n) & ((1u << extra) - 1));
+
+		INF32_DROP(n + extra);
+
+		if (INF32_PAST_END())
+		{
+			wd->msg = "unexpected end of stream";
+			ok = FALSE;
+
+			break;
+		}
+
+		if (dist > part->out_size)
+		{
+			if (dist > part->out_size + INF32_WINDOW_SIZE)
+			{
+				wd->msg = "invalid distance too far back";
+				ok = FALSE;
+
+				break;
+			}
+
+			for (uint16 *end = out + len; out < end; out++)
+			{
+				ptrdiff from = (out - part->out) - (ptrdiff)dist;
+
+				*out = from < 0 ? (uint16)(INF32_PLACEHOLDER + INF32_WINDOW_SIZE + from) : part->out[from];
+			}
+		}
+		else if (dist >= (size_t)len)
+		{
+			memcpy(out, out - dist, len * sizeof(uint16));
+		}
+		else
+		{
+			for (uint16 *end = out + len; out < end; out++)
+			{
+				*out = out[-(ptrdiff)dist];
+			}
+		}
+
+		part->out_size += len;
+	}
+
+	INF32_SAVE();
+
+	return ok;
+}
+
+// decodes blocks from the current position until a block starts at or past part->stop_bit or the stream is done
+local bool32 inf32_part_run(inf32_work_data *wd, inf32_part *part)
+{
+	for (ever)
+	{
+		if (wd->state == INF32_STATE_DONE)
+		{
+			part->final_flag = TRUE;
+
+			break;
+		}
+
+		if (wd->state == INF32_STATE_HEADER)
+		{
+			if (inf32_bit_pos(wd) >= part->stop_bit) break;
+
+			if (!inf32_block_header(wd)) return FALSE;
+		}
+		else if (wd->state == INF32_STATE_STORED)
+		{
+			if (wd->in_end - wd->in_ptr < wd->stored_left || !inf32_part_grow(part, wd->stored_left))
+			{
+				wd->msg = "unexpected end of stream";
+
+				return FALSE;
+			}
+
+			for (int32 i = 0; i < wd->stored_left; i++)
+			{
+				part->out[part->out_size++] = *wd->in_ptr++;
+			}
+
+			wd->stored_left = 0;
+			wd->state = wd->final_flag ? INF32_STATE_DONE : INF32_STATE_HEADER;
+		}
+		else if (!inf32_part_huffman(wd, part))
+		{
+			return FALSE;
+		}
+	}
+
+	if (!inf32_check_end(wd)) return FALSE;
+
+	part->end_bit = inf32_bit_pos(wd);
+
+	return TRUE;
+}
+
+local void inf32_part_decode(inf32_part *part, size_t start_bit)
 {
-	return 0;
+	inf32_start(part->wd, part->in_buf, part->in_buf_size);
+	inf32_seek(part->wd, start_bit);
+
+	part->start_bit = start_bit;
+	part->out_size = 0;
+	part->final_flag = FALSE;
+	part->ok = inf32_part_run(part->wd, part);
 }
 
-int32 Inf32Decode(byte *in_buf, size_t in_buf_ofs, size_t *in_buf_size, byte *out_buf, size_t out_buf_offset, size_t *out_buf_size, void *_wd, bool32 b)
+local void inf32_part_thread(void *arg)
 {
-	if (!in_buf_ofs)
+	inf32_part *part = (inf32_part *)arg;
+	inf32_work_data *wd = part->wd;
+
+	if (!part->guess_flag)
+	{
+		inf32_part_decode(part, part->start * 8);
+
+		return;
+	}
+
+	inf32_start(wd, part->in_buf, part->in_buf_size);
+
+	for (size_t bit_pos = part->start * 8; bit_pos < part->end * 8; bit_pos++)
+	{
+		// not final, dynamic, at most 286 length and 30 distance codes, before trying the whole header
+		uint32 v = 0;
+
+		memcpy(&v, part->in_buf + (bit_pos >> 3), min(sizeof(v), part->in_buf_size - (bit_pos >> 3)));
+
+		v >>= bit_pos & 7;
+
+		if ((v & 7) != 4 || ((v >> 3) & 0x1F) > 29 || ((v >> 8) & 0x1F) > 29) continue;
+
+		inf32_seek(wd, bit_pos);
+
+		if (!inf32_block_header(wd)) continue;
+
+		inf32_part_decode(part, bit_pos);
+
+		if (part->ok) return;
+	}
+
+	part->ok = FALSE;
+}
+
+// turns the placeholders of a part into bytes, out is where the part goes, the window before it is the output so far
+// and the dictionary in front of that
+local bool32 inf32_part_resolve(inf32_part *part, byte *out_base, size_t out_ofs, byte *dict, int32 dict_size)
+{
+	byte *out = out_base + out_ofs;
+
+	for (size_t i = 0; i < part->out_size; i++)
 	{
-		memzero(&inflate_stream, sizeof(inflate_stream));
+		uint32 sym = part->out[i];
+
+		if (sym < INF32_PLACEHOLDER)
+		{
+			out[i] = (byte)sym;
+
+			continue;
+		}
+
+		ptrdiff from = (ptrdiff)out_ofs - INF32_WINDOW_SIZE + (sym - INF32_PLACEHOLDER);
 
-		inflate_stream.zalloc = zalloc;
-		inflate_stream.zfree = zfree;
+		if (from < -(ptrdiff)dict_size) return FALSE;
+
+		out[i] = from < 0 ? dict[dict_size + from] : out_base[from];
+	}
 
-		inflate_stream.next_in = in_buf;
-		inflate_stream.avail_in = *in_buf_size;
+	return TRUE;
+}
 
-		inflate_code = inflateInit2(&inflate_stream, -15);
+// appends a decoded part to the output
+local bool32 inf32_part_append(inf32_part *part, byte **out_buf, size_t *out_size, size_t *out_alloc, byte *dict, int32 dict_size)
+{
+	if (*out_size + part->out_size > *out_alloc)
+	{
+		size_t new_alloc = max(*out_alloc * 2, *out_size + part->out_size);
+		byte *new_out = realloc(*out_buf, new_alloc);
 
-		if (inflate_code != Z_OK)
+		if (!new_out)
 		{
-			printf("inflate error %d: %s\n", inflate_code, inflate_stream.msg);
+			part->wd->msg = "out of memory";
 
-			return INFLATE_ERROR;
+			return FALSE;
 		}
+
+		*out_buf = new_out;
+		*out_alloc = new_alloc;
 	}
 
-	if (inflate_code == Z_OK)
+	if (!inf32_part_resolve(part, *out_buf, *out_size, dict, dict_size))
 	{
-		memzero(out_buf, *out_buf_size);
+		part->wd->msg = "invalid distance too far back";
 
-		inflate_stream.next_out = out_buf;
-		inflate_stream.avail_out = *out_buf_size;
+		return FALSE;
+	}
+
+	*out_size += part->out_size;
+
+	return TRUE;
+}
+
+int32 Inf32DecodeParallel(byte *in_buf, size_t *in_buf_size, byte **out_buf, size_t *out_buf_size, byte *dict, int32 dict_size, int32 num_threads)
+{
+	size_t in_size = *in_buf_size;
+	int32 num_parts = (int32)max(1, min((size_t)max(1, num_threads), in_size / INF32_PARALLEL_MIN_PART));
+	size_t part_size = in_size / num_parts;
+	inf32_part *parts = calloc(num_parts, sizeof(inf32_part));
+	inf32_part gap = ZEROMEM;
+	size_t out_alloc = 0;
+	size_t out_size = 0;
+	size_t bit_pos = 0;
+	bool32 final_flag = FALSE;
+	char *msg = "out of memory";
+
+	*out_buf = NULL;
+
+	if (dict_size > INF32_WINDOW_SIZE)
+	{
+		dict += dict_size - INF32_WINDOW_SIZE;
+		dict_size = INF32_WINDOW_SIZE;
+	}
 
-		inflate_code = inflate(&inflate_stream, Z_SYNC_FLUSH);
+	dict_size = max(0, dict_size);
 
-		// this is always 1 off after in_buf_ofs is nonzero ... no idea how it works in the game
-		*in_buf_size = (*in_buf_size - inflate_stream.avail_in) - in_buf_ofs;
+	if (!parts) goto done;
 
-		*out_buf_size -= inflate_stream.avail_out;
+	for (int32 i = 0; i < num_parts; i++)
+	{
+		parts[i].in_buf = in_buf;
+		parts[i].in_buf_size = in_size;
+		parts[i].start = i * part_size;
+		parts[i].end = i == num_parts - 1 ? in_size : (i + 1) * part_size;
+		parts[i].stop_bit = parts[i].end * 8;
+		parts[i].guess_flag = i > 0;
+		parts[i].wd = calloc(1, sizeof(inf32_work_data));
 
-		if (inflate_code == Z_OK) return INFLATE_OK;
+		if (!parts[i].wd) goto done;
 	}
 
-	if (inflate_code == Z_STREAM_END)
+	for (int32 i = 1; i < num_parts; i++)
 	{
-		inflateEnd(&inflate_stream);
+		parts[i].thread_flag = rge_thread_create(&parts[i].thread, inf32_part_thread, &parts[i]);
+	}
 
-		return INFLATE_EOF;
+	inf32_part_thread(&parts[0]);
+
+	for (int32 i = 1; i < num_parts; i++)
+	{
+		if (parts[i].thread_flag) rge_thread_join(&parts[i].thread);
 	}
 
-	printf("inflate error %d: %s\n", inflate_code, inflate_stream.msg);
+	gap = parts[0];
+	gap.out = NULL;
+	gap.out_alloc = 0;
 
-	return INFLATE_ERROR;
+	for (int32 i = 0; i < num_parts && !final_flag; i++)
+	{
+		inf32_part *part = &parts[i];
+
+		// the guess is past where the part before really ended, most likely a stored or static block it couldn't see, decode up to it
+		if (part->ok && part->start_bit > bit_pos)
+		{
+			gap.stop_bit = part->start_bit;
+			inf32_part_decode(&gap, bit_pos);
+
+			if (gap.ok && !gap.final_flag && gap.end_bit == part->start_bit)
+			{
+				if (!inf32_part_append(&gap, out_buf, &out_size, &out_alloc, dict, dict_size))
+				{
+					msg = gap.wd->msg;
+
+					goto done;
+				}
+
+				bit_pos = gap.end_bit;
+			}
+		}
+
+		// no guess, or a wrong one, decode the part again from where the one before really ended
+		if (!part->ok || part->start_bit != bit_pos)
+		{
+			inf32_part_decode(part, bit_pos);
+
+			if (!part->ok)
+			{
+				msg = part->wd->msg;
+
+				// what it decoded up to the error is output as well, the same as Inf32DecodeFull has it
+				if (inf32_part_append(part, out_buf, &out_size, &out_alloc, dict, dict_size)) bit_pos = inf32_bit_pos(part->wd);
+
+				goto done;
+			}
+		}
+
+		if (!inf32_part_append(part, out_buf, &out_size, &out_alloc, dict, dict_size))
+		{
+			msg = part->wd->msg;
+
+			goto done;
+		}
+
+		bit_pos = part->end_bit;
+		final_flag = part->final_flag;
+
+		rge_free(part->out);
+	}
+
+	if (!final_flag) msg = "unexpected end of stream";
+
+done:
+	if (parts)
+	{
+		for (int32 i = 0; i < num_parts; i++)
+		{
+			rge_free(parts[i].out);
+			rge_free(parts[i].wd);
+		}
+	}
+
+	rge_free(gap.out);
+	rge_free(parts);
+
+	*in_buf_size = min((bit_pos + 7) >> 3, in_size);
+	*out_buf_size = out_size;
+
+	if (!final_flag)
+	{
+		fprintf(stderr, "inflate error: %s\n", msg);
+
+		return INFLATE_ERROR;
+	}
+
+	return INFLATE_EOF;
 }
@@ -0,0 +1,162 @@
+#include <zlib.h>
+
+#include "compress.h"
+
+// zlib's inflate behind the Inf32Decode interface, the reference the in-tree decoder is checked against
+
+typedef struct zlib_inflate_work_data zlib_inflate_work_data;
+
+struct zlib_inflate_work_data
+{
+	z_stream stream;
+	int32 code;
+	byte *dict; // used by the next stream only
+	int32 dict_size;
+};
+
+local void *zalloc(void *opaque, uint32 items, uint32 size)
+{
+	return calloc(size, items);
+};
+
+local void zfree(void *opaque, void *address)
+{
+	free(address);
+}
+
+size_t zlib_inflate_buf_size()
+{
+	return sizeof(zlib_inflate_work_data);
+}
+
+void zlib_inflate_set_dictionary(void *_wd, byte *dict, int32 dict_size)
+{
+	zlib_inflate_work_data *wd = (zlib_inflate_work_data *)_wd;
+
+	wd->dict = dict;
+	wd->dict_size = dict_size;
+}
+
+// zlib refuses to end a stream that was never started or is already ended, so this is safe after EOF and errors too
+void zlib_inflate_deinit(void *_wd)
+{
+	zlib_inflate_work_data *wd = (zlib_inflate_work_data *)_wd;
+
+	inflateEnd(&wd->stream);
+}
+
+local bool32 zlib_inflate_start(zlib_inflate_work_data *wd, byte *in_buf, size_t in_buf_size)
+{
+	memzero(&wd->stream, sizeof(wd->stream));
+
+	wd->stream.zalloc = zalloc;
+	wd->stream.zfree = zfree;
+
+	wd->stream.next_in = in_buf;
+	wd->stream.avail_in = in_buf_size;
+
+	wd->code = inflateInit2(&wd->stream, -15);
+
+	if (wd->code == Z_OK && wd->dict_size > 0) wd->code = inflateSetDictionary(&wd->stream, wd->dict, wd->dict_size);
+
+	wd->dict = NULL;
+	wd->dict_size = 0;
+
+	if (wd->code != Z_OK)
+	{
+		fprintf(stderr, "inflate error %d: %s\n", wd->code, wd->stream.msg);
+
+		inflateEnd(&wd->stream);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+int32 zlib_inflate_decode(byte *in_buf, size_t in_buf_ofs, size_t *in_buf_size, byte *out_buf, size_t out_buf_offset, size_t *out_buf_size, void *_wd, bool32 buffered)
+{
+	zlib_inflate_work_data *wd = (zlib_inflate_work_data *)_wd;
+
+	if (!in_buf_ofs && !zlib_inflate_start(wd, in_buf, *in_buf_size)) return INFLATE_ERROR;
+
+	if (wd->code == Z_OK)
+	{
+		memzero(out_buf + out_buf_offset, *out_buf_size);
+
+		wd->stream.next_out = out_buf + out_buf_offset;
+		wd->stream.avail_out = *out_buf_size;
+
+		wd->code = inflate(&wd->stream, Z_SYNC_FLUSH);
+
+		// this is always 1 off after in_buf_ofs is nonzero ... no idea how it works in the game
+		*in_buf_size = (*in_buf_size - wd->stream.avail_in) - in_buf_ofs;
+
+		*out_buf_size -= wd->stream.avail_out;
+
+		if (wd->code == Z_OK) return INFLATE_OK;
+	}
+
+	if (wd->code == Z_STREAM_END)
+	{
+		inflateEnd(&wd->stream);
+
+		return INFLATE_EOF;
+	}
+
+	fprintf(stderr, "inflate error %d: %s\n", wd->code, wd->stream.msg);
+
+	inflateEnd(&wd->stream);
+
+	return INFLATE_ERROR;
+}
+
+int32 zlib_inflate_decode_full(byte *in_buf, size_t *in_buf_size, byte *out_buf, size_t out_buf_ofs, size_t *out_buf_size, void *_wd)
+{
+	zlib_inflate_work_data *wd = (zlib_inflate_work_data *)_wd;
+	size_t in_size = *in_buf_size;
+
+	if (!out_buf_ofs && !zlib_inflate_start(wd, in_buf, in_size))
+	{
+		*in_buf_size = 0;
+		*out_buf_size = 0;
+
+		return INFLATE_ERROR;
+	}
+
+	if (wd->code == Z_OK)
+	{
+		// same as the in-tree one, one byte past the end to see if that was all
+		byte *out_end = out_buf + *out_buf_size + 1;
+
+		wd->stream.next_out = out_buf + out_buf_ofs;
+
+		// avail_out is only 32 bits, more room than that is handed over a piece at a time
+		do
+		{
+			wd->stream.avail_out = (uInt)min((size_t)(out_end - wd->stream.next_out), 0x40000000);
+			wd->code = inflate(&wd->stream, Z_FINISH);
+		}
+		while (wd->code == Z_BUF_ERROR && !wd->stream.avail_out && wd->stream.next_out < out_end);
+
+		if (wd->code == Z_BUF_ERROR && !wd->stream.avail_out) wd->code = Z_OK;
+	}
+
+	*in_buf_size = in_size - wd->stream.avail_in;
+	*out_buf_size = wd->stream.next_out - out_buf;
+
+	if (wd->code == Z_OK) return INFLATE_OK;
+
+	if (wd->code == Z_STREAM_END)
+	{
+		inflateEnd(&wd->stream);
+
+		return INFLATE_EOF;
+	}
+
+	fprintf(stderr, "inflate error %d: %s\n", wd->code, wd->stream.msg);
+
+	inflateEnd(&wd->stream);
+
+	return INFLATE_ERROR;
+}
@@ -0,0 +1,101 @@
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#endif
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "io.h"
+
+local io_backend io_backends[IO_NUM_BACKENDS] =
+{
+	{ "posix", posix_io_available, posix_io_open, posix_io_read, posix_io_write, posix_io_close, posix_io_free_thread },
+	{ "uring", uring_io_available, uring_io_open, uring_io_read, uring_io_write, uring_io_close, uring_io_free_thread },
+};
+
+io_backend *io_get_backend(int32 backend)
+{
+	if (backend < 0 || backend >= IO_NUM_BACKENDS) return NULL;
+
+	if (!io_backends[backend].available()) backend = IO_BACKEND_POSIX;
+
+	return &io_backends[backend];
+}
+
+int32 io_find_backend(char *name)
+{
+	for (int32 i = 0; i < IO_NUM_BACKENDS; i++)
+	{
+		if (!strcmp(io_backends[i].name, name)) return i;
+	}
+
+	return IO_BACKEND_INVALID;
+}
+
+void io_free_thread()
+{
+	for (int32 i = 0; i < IO_NUM_BACKENDS; i++)
+	{
+		io_backends[i].free_thread();
+	}
+}
+
+// one fstat instead of seeking to the end and back
+void io_stat(handle handle, size_t *size, bool32 *regular)
+{
+	struct _stat st;
+
+	*regular = !_fstat(handle, &st) && (st.st_mode & _S_IFMT) == _S_IFREG;
+	*size = *regular ? st.st_size : 0;
+}
+
+int32 io_pread(handle handle, void *data, int32 size, int64 offset)
+{
+#ifdef _WIN32
+	OVERLAPPED overlapped = ZEROMEM;
+	DWORD num_read;
+
+	overlapped.Offset = (DWORD)offset;
+	overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+	// reading past the end is an error instead of 0
+	if (!ReadFile((HANDLE)_get_osfhandle(handle), data, size, &num_read, &overlapped)) return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+
+	return (int32)num_read;
+#else
+	return (int32)pread(handle, data, size, offset);
+#endif
+}
+
+bool32 posix_io_available()
+{
+	return TRUE;
+}
+
+handle posix_io_open(char *filename, int32 flag, int32 pmode, size_t *size, bool32 *regular)
+{
+	handle handle = _open(filename, flag, pmode);
+
+	if (handle != INVALID_HANDLE) io_stat(handle, size, regular);
+
+	return handle;
+}
+
+int32 posix_io_read(handle handle, void *data, int32 size)
+{
+	return _read(handle, data, size);
+}
+
+int32 posix_io_write(handle handle, void *data, int32 size)
+{
+	return _write(handle, data, size);
+}
+
+int32 posix_io_close(handle handle, bool32 wait)
+{
+	return _close(handle);
+}
+
+void posix_io_free_thread()
+{
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "main.h"
+
+#define IO_BACKEND_INVALID -1
+#define IO_BACKEND_POSIX 0
+#define IO_BACKEND_URING 1
+#define IO_NUM_BACKENDS 2
+
+// plain _open/_read/_write/_close, works everywhere
+bool32 posix_io_available();
+handle posix_io_open(char *filename, int32 flag, int32 pmode, size_t *size, bool32 *regular);
+int32 posix_io_read(handle handle, void *data, int32 size);
+int32 posix_io_write(handle handle, void *data, int32 size);
+int32 posix_io_close(handle handle, bool32 wait);
+void posix_io_free_thread();
+
+// io_uring with one ring per thread, opens with the size in one submission and closes files that were only read along with the next call,
+// only built with RGE_IO_URING on Linux and unavailable where the kernel doesn't have it
+bool32 uring_io_available();
+handle uring_io_open(char *filename, int32 flag, int32 pmode, size_t *size, bool32 *regular);
+int32 uring_io_read(handle handle, void *data, int32 size);
+int32 uring_io_write(handle handle, void *data, int32 size);
+int32 uring_io_close(handle handle, bool32 wait);
+void uring_io_free_thread();
+
+typedef struct io_backend io_backend;
+
+struct io_backend
+{
+	char *name;
+	bool32 (*available)(); // sets up what the calling thread needs, FALSE if the build or the kernel can't do it
+	handle (*open)(char *filename, int32 flag, int32 pmode, size_t *size, bool32 *regular); // size is only set for regular files
+	int32 (*read)(handle handle, void *data, int32 size); // same as _read/_write, can stop short
+	int32 (*write)(handle handle, void *data, int32 size);
+	int32 (*close)(handle handle, bool32 wait); // without wait the backend may close in the background and returns 0
+	void (*free_thread)();
+};
+
+io_backend *io_get_backend(int32 backend); // falls back to posix if the backend isn't available on the calling thread
+int32 io_find_backend(char *name);
+void io_free_thread(); // before a thread that did any I/O through a backend exits
+void io_stat(handle handle, size_t *size, bool32 *regular); // for handles that didn't come from a backend's open
+int32 io_pread(handle handle, void *data, int32 size, int64 offset); // at offset without moving the position, on Windows it does move it, can stop short
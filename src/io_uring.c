@@ -0,0 +1,331 @@
+#if defined(RGE_IO_URING) && defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "io.h"
+
+#if defined(RGE_IO_URING) && defined(__linux__)
+// raw syscalls instead of liburing, so there's nothing extra to build or link
+
+#define URING_ENTRIES 64
+
+#define URING_UNTRIED 0
+#define URING_READY 1
+#define URING_UNAVAILABLE 2
+
+typedef struct uring_result uring_result;
+
+struct uring_result
+{
+	int32 res;
+	bool32 done;
+};
+
+typedef struct uring uring;
+
+struct uring
+{
+	int32 state;
+	int32 fd;
+	byte *rings; // sq and cq share one mapping with IORING_FEAT_SINGLE_MMAP
+	size_t rings_size;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	uint32 *sq_tail;
+	uint32 *sq_mask;
+	uint32 *sq_array;
+	uint32 *cq_head;
+	uint32 *cq_tail;
+	uint32 *cq_mask;
+	struct io_uring_cqe *cqes;
+	uint32 num_unsubmitted; // queued, but not handed to the kernel yet, like background closes
+	uint32 num_in_flight; // submitted, but not reaped yet
+};
+
+local thread_local uring ring = ZEROMEM;
+
+local bool32 uring_setup()
+{
+	struct io_uring_params params;
+
+	memzero(&params, sizeof(params));
+
+	ring.fd = (int32)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+
+	if (ring.fd < 0) return FALSE;
+
+	// 5.6 and up, openat, statx, close and reads and writes at the current position are all there as well then
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_RW_CUR_POS))
+	{
+		close(ring.fd);
+
+		return FALSE;
+	}
+
+	ring.rings_size = max(params.sq_off.array + params.sq_entries * sizeof(uint32), params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+	ring.rings = mmap(NULL, ring.rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+
+	ring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring.sqes = mmap(NULL, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+
+	if (ring.rings == MAP_FAILED || ring.sqes == MAP_FAILED)
+	{
+		if (ring.rings != MAP_FAILED) munmap(ring.rings, ring.rings_size);
+		if (ring.sqes != MAP_FAILED) munmap(ring.sqes, ring.sqes_size);
+
+		close(ring.fd);
+
+		return FALSE;
+	}
+
+	ring.sq_tail = (uint32 *)(ring.rings + params.sq_off.tail);
+	ring.sq_mask = (uint32 *)(ring.rings + params.sq_off.ring_mask);
+	ring.sq_array = (uint32 *)(ring.rings + params.sq_off.array);
+	ring.cq_head = (uint32 *)(ring.rings + params.cq_off.head);
+	ring.cq_tail = (uint32 *)(ring.rings + params.cq_off.tail);
+	ring.cq_mask = (uint32 *)(ring.rings + params.cq_off.ring_mask);
+	ring.cqes = (struct io_uring_cqe *)(ring.rings + params.cq_off.cqes);
+
+	ring.num_unsubmitted = 0;
+	ring.num_in_flight = 0;
+
+	return TRUE;
+}
+
+local void uring_reap()
+{
+	uint32 head = *ring.cq_head;
+
+	while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE))
+	{
+		struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+		uring_result *result = (uring_result *)(uintptr)cqe->user_data;
+
+		if (result)
+		{
+			result->res = cqe->res;
+			result->done = TRUE;
+		}
+
+		head++;
+		ring.num_in_flight--;
+	}
+
+	__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+// submits everything queued and waits for up to min_complete completions
+local bool32 uring_enter(uint32 min_complete)
+{
+	for (ever)
+	{
+		int32 num_submitted = (int32)syscall(__NR_io_uring_enter, ring.fd, ring.num_unsubmitted, min_complete, IORING_ENTER_GETEVENTS, NULL, 0);
+
+		if (num_submitted >= 0)
+		{
+			ring.num_unsubmitted -= num_submitted;
+			ring.num_in_flight += num_submitted;
+
+			uring_reap();
+
+			return TRUE;
+		}
+
+		if (errno == EINTR) continue;
+
+		// completions have to be reaped first
+		if (errno == EBUSY || errno == EAGAIN)
+		{
+			uring_reap();
+
+			continue;
+		}
+
+		fprintf(stderr, "io_uring_enter error %d\n", errno);
+
+		return FALSE;
+	}
+}
+
+// linked sqes have to go in with the same submission, so room for all of them is made first
+local void uring_make_room(uint32 num_sqes)
+{
+	if (ring.num_unsubmitted + num_sqes > URING_ENTRIES) uring_enter(0);
+}
+
+local struct io_uring_sqe *uring_get_sqe(uint8 opcode, int32 fd, uring_result *result)
+{
+	uring_make_room(1);
+
+	uint32 tail = *ring.sq_tail;
+	uint32 index = tail & *ring.sq_mask;
+	struct io_uring_sqe *sqe = &ring.sqes[index];
+
+	memzero(sqe, sizeof(struct io_uring_sqe));
+
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->user_data = (uint64)(uintptr)result;
+
+	if (result) result->done = FALSE;
+
+	ring.sq_array[index] = index;
+
+	__atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	ring.num_unsubmitted++;
+
+	return sqe;
+}
+
+local int32 uring_wait(uring_result *result)
+{
+	while (!result->done)
+	{
+		// the results live on the stack of the caller, so the ring can't be left with them in it
+		if (!uring_enter(1)) abort();
+	}
+
+	return result->res;
+}
+
+local int32 uring_errno(int32 res)
+{
+	if (res >= 0) return res;
+
+	errno = -res;
+
+	return -1;
+}
+
+bool32 uring_io_available()
+{
+	if (ring.state == URING_UNTRIED) ring.state = uring_setup() ? URING_READY : URING_UNAVAILABLE;
+
+	return ring.state == URING_READY;
+}
+
+handle uring_io_open(char *filename, int32 flag, int32 pmode, size_t *size, bool32 *regular)
+{
+	struct statx st;
+	uring_result open_result;
+	uring_result stat_result;
+
+	uring_make_room(2);
+
+	struct io_uring_sqe *sqe = uring_get_sqe(IORING_OP_OPENAT, AT_FDCWD, &open_result);
+
+	sqe->addr = (uint64)(uintptr)filename;
+	sqe->open_flags = flag;
+	sqe->len = pmode;
+	sqe->flags = IOSQE_IO_LINK; // the stat waits for the open, so it sees the file created or truncated
+
+	sqe = uring_get_sqe(IORING_OP_STATX, AT_FDCWD, &stat_result);
+
+	sqe->addr = (uint64)(uintptr)filename;
+	sqe->len = STATX_TYPE | STATX_SIZE;
+	sqe->off = (uint64)(uintptr)&st;
+
+	handle handle = uring_errno(uring_wait(&open_result));
+
+	uring_wait(&stat_result);
+
+	*regular = handle != INVALID_HANDLE && !stat_result.res && S_ISREG(st.stx_mode);
+	*size = *regular ? st.stx_size : 0;
+
+	return handle;
+}
+
+int32 uring_io_read(handle handle, void *data, int32 size)
+{
+	uring_result result;
+	struct io_uring_sqe *sqe = uring_get_sqe(IORING_OP_READ, handle, &result);
+
+	sqe->addr = (uint64)(uintptr)data;
+	sqe->len = size;
+	sqe->off = (uint64)-1; // current position, same as _read
+
+	return uring_errno(uring_wait(&result));
+}
+
+int32 uring_io_write(handle handle, void *data, int32 size)
+{
+	uring_result result;
+	struct io_uring_sqe *sqe = uring_get_sqe(IORING_OP_WRITE, handle, &result);
+
+	sqe->addr = (uint64)(uintptr)data;
+	sqe->len = size;
+	sqe->off = (uint64)-1;
+
+	return uring_errno(uring_wait(&result));
+}
+
+int32 uring_io_close(handle handle, bool32 wait)
+{
+	if (!wait)
+	{
+		// goes in with whatever is submitted next
+		uring_get_sqe(IORING_OP_CLOSE, handle, NULL);
+
+		return 0;
+	}
+
+	uring_result result;
+
+	uring_get_sqe(IORING_OP_CLOSE, handle, &result);
+
+	return uring_errno(uring_wait(&result));
+}
+
+void uring_io_free_thread()
+{
+	if (ring.state == URING_READY)
+	{
+		while (ring.num_unsubmitted || ring.num_in_flight)
+		{
+			if (!uring_enter(ring.num_in_flight + ring.num_unsubmitted)) break;
+		}
+
+		munmap(ring.sqes, ring.sqes_size);
+		munmap(ring.rings, ring.rings_size);
+
+		close(ring.fd);
+	}
+
+	ring.state = URING_UNTRIED;
+}
+#else
+bool32 uring_io_available()
+{
+	return FALSE;
+}
+
+handle uring_io_open(char *filename, int32 flag, int32 pmode, size_t *size, bool32 *regular)
+{
+	return INVALID_HANDLE;
+}
+
+int32 uring_io_read(handle handle, void *data, int32 size)
+{
+	return -1;
+}
+
+int32 uring_io_write(handle handle, void *data, int32 size)
+{
+	return -1;
+}
+
+int32 uring_io_close(handle handle, bool32 wait)
+{
+	return -1;
+}
+
+void uring_io_free_thread()
+{
+}
+#endif
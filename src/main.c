@@ -8,22 +8,423 @@
 
 #include "main.h"
 #include "rge_fio.h"
+#include "compress.h"
+#include "detect.h"
+#include "dict.h"
+#include "batch.h"
+#include "queue.h"
+#include "thread.h"
+#include "trace.h"
+#include "cpu.h"
 
 #define USAGE \
-"usage: rge_fio r/w <in> <out> [num uncompressed bytes at start] [offset from which to read/to write to]\n\n"
+"usage: rge_fio [options] r/w <in> <out> [num uncompressed bytes at start] [offset from which to read/to write to]\n" \
+"       rge_fio [options] d <in> [num uncompressed bytes at start] [offset from which to read]\n" \
+"       rge_fio [options] t <out dict> <in> [in ...]\n" \
+"       rge_fio [options] b <manifest>\n" \
+"       rge_fio [options] b r/w <in dir> <pattern> <out dir> [num uncompressed bytes at start] [offset from which to read/to write to]\n\n" \
+"r inflates, w deflates, d detects the game deflate settings that reproduce the compressed input exactly,\n" \
+"t trains a preset dictionary from uncompressed sample files,\n" \
+"b runs r/w on many files at once, listed in a manifest (one r/w <in> <out> [num] [offset] per line) or matching a pattern,\n" \
+"- as <in> or <out> of r/w is stdin or stdout, streamed through in pieces\n\n" \
+"options:\n" \
+"  --deflate=game         deflate exactly like the game does (default)\n" \
+"  --deflate=fast         deflate with zlib, a lot faster but not bit-exact with the game\n" \
+"  --deflate=best         deflate with an optimal parse, smallest output but slow and not bit-exact with the game\n" \
+"  --inflate=zlib         inflate with zlib instead of the in-tree decoder\n" \
+"  --prescan              let r get the decompressed size first so the output is allocated once\n" \
+"  --max-compares=<n>     game deflate match search depth, 1 to 1500 (default 75)\n" \
+"  --strategy=<s>         game deflate block types, all, dynamic or static (default all)\n" \
+"  --greedy, --lazy       game deflate match parsing (default greedy)\n" \
+"  --threads=<n>          threads used by d, b and r --parallel (default all cpus)\n" \
+"  --parallel             let r decode the input on several threads, each guessing where a block starts in its part of it\n" \
+"  --io=posix             plain file I/O calls (default)\n" \
+"  --io=uring             file I/O of r, w and b through io_uring, if built with --io-uring and the kernel has it, else the same as posix\n" \
+"  --cpu=<level>          newest instructions the deflate kernels use, generic, sse2, avx2 or avx512 (default the best the cpu has)\n" \
+"  --pipelined            let r/w read, inflate or deflate and write on threads of their own with pieces queued in between\n" \
+"  --window=<n>           bytes r, w and b inflate or deflate per call and write at once, 4096 to 16777216 (default 65536)\n" \
+"  --length=<n>           compressed bytes r reads from the offset on instead of all of the file after it, it says how many the stream used\n" \
+"  --stats                let w print what the game deflate did as json, if built with --deflate-stats\n" \
+"  --trace[=<file>]       print how long reading, writing, inflating and each part of deflating took, and write a chrome trace to file\n" \
+"  --all                  let d report every matching setting instead of the most likely one\n" \
+"  --dict=<file>          preset dictionary for r and w, files written with one need it for reading and the game can't read them\n" \
+"  --dict-size=<n>        size of the dictionary t trains (default 32768)\n\n"
+
+#define MAX_ARGS 6
+#define MAX_BATCH_ARGS 8
+
+local char *strategy_names[] = { "static", "dynamic", "all" }; // indexed by DEFLATE_*_BLOCKS
+
+local char *trace_filename = NULL;
+local FILE *trace_info = NULL;
+
+// at exit, so failed runs are reported as well
+local void trace_report()
+{
+	trace_print_summary(trace_info);
+
+	if (trace_filename && !trace_write_json(trace_filename)) fprintf(trace_info, "error: couldn't write trace %s\n", trace_filename);
+
+	trace_stop();
+}
+
+local byte *read_file(char *filename, size_t *size)
+{
+	FILE *in = rge_fopen(filename, "rb");
+
+	if (!in) return NULL;
+
+	fseek(in, 0, SEEK_END);
+	long end = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	byte *data = NULL;
+
+	if (end >= 0)
+	{
+		*size = end;
+		data = malloc(max(1, *size));
+
+		if (data && fread(data, 1, *size, in) != *size)
+		{
+			rge_free(data);
+			data = NULL;
+		}
+	}
+
+	rge_fclose(in);
+
+	return data;
+}
+
+typedef struct pipe_stage pipe_stage;
+
+// the file end of a --pipelined r/w, a thread that moves pieces between the file and the queue
+struct pipe_stage
+{
+	rge_queue queue;
+	rge_thread thread;
+	FILE *file;
+	bool32 error; // reading or writing the file failed, only looked at after stage_stop
+};
+
+local void stage_read_thread(void *arg)
+{
+	pipe_stage *stage = arg;
+
+	for (ever)
+	{
+		byte *data = rge_queue_acquire(&stage->queue);
+		int32 size = (int32)fread(data, 1, stage->queue.buffer_size, stage->file);
+
+		if (!size && ferror(stage->file)) stage->error = TRUE;
+
+		rge_queue_push(&stage->queue, size);
+
+		if (!size) break;
+	}
+}
+
+local void stage_write_thread(void *arg)
+{
+	pipe_stage *stage = arg;
+
+	for (ever)
+	{
+		int32 size;
+		byte *data = rge_queue_pop(&stage->queue, &size);
+
+		// after an error the rest is still taken off the queue, so the other end doesn't wait forever
+		if (size && !stage->error && fwrite(data, 1, size, stage->file) != (size_t)size) stage->error = TRUE;
+
+		rge_queue_release(&stage->queue);
+
+		if (!size) break;
+	}
+}
+
+local bool32 stage_start(pipe_stage *stage, FILE *file, void (*func)(void *), int32 chunk_size)
+{
+	stage->file = file;
+	stage->error = FALSE;
+
+	if (!rge_queue_init(&stage->queue, RGE_QUEUE_DEFAULT_BUFFERS, chunk_size)) return FALSE;
+
+	if (rge_thread_create(&stage->thread, func, stage)) return TRUE;
+
+	rge_queue_free(&stage->queue);
+
+	return FALSE;
+}
+
+local void stage_stop(pipe_stage *stage)
+{
+	rge_thread_join(&stage->thread);
+	rge_queue_free(&stage->queue);
+}
+
+local void print_histogram(FILE *out, char *name, uint64 *values, int32 num_values, char *end)
+{
+	fprintf(out, "  \"%s\": [", name);
+
+	for (int32 i = 0; i < num_values; i++)
+	{
+		fprintf(out, i ? ", %llu" : "%llu", (unsigned long long)values[i]);
+	}
+
+	fprintf(out, "]%s\n", end);
+}
+
+local void print_deflate_stats(FILE *out, deflate_stats *stats)
+{
+	char *block_names[] = { "raw", "static", "dynamic" }; // indexed by DEFLATE_STATS_*_BLOCK
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"find_match_calls\": %llu,\n", (unsigned long long)stats->find_match_calls);
+	fprintf(out, "  \"chain_probes\": %llu,\n", (unsigned long long)stats->chain_probes);
+	fprintf(out, "  \"compares_exhausted\": %llu,\n", (unsigned long long)stats->compares_exhausted);
+	print_histogram(out, "probe_histogram", stats->probe_histogram, DEFLATE_STATS_PROBE_BUCKETS, ",");
+	fprintf(out, "  \"literals\": %llu,\n", (unsigned long long)stats->literals);
+	fprintf(out, "  \"matches\": %llu,\n", (unsigned long long)stats->matches);
+	fprintf(out, "  \"match_bytes\": %llu,\n", (unsigned long long)stats->match_bytes);
+	fprintf(out, "  \"far_min_matches\": %llu,\n", (unsigned long long)stats->far_min_matches);
+	print_histogram(out, "length_histogram", stats->length_histogram, DEFLATE_STATS_MAX_LENGTH + 1, ",");
+	print_histogram(out, "distance_histogram", stats->distance_histogram, DEFLATE_STATS_DIST_CODES, ",");
+	fprintf(out, "  \"blocks\": {");
+
+	for (int32 i = 0; i < DEFLATE_STATS_BLOCK_TYPES; i++)
+	{
+		fprintf(out, "%s \"%s\": { \"count\": %llu, \"bits\": %llu }", i ? "," : "", block_names[i], (unsigned long long)stats->blocks[i], (unsigned long long)stats->block_bits[i]);
+	}
+
+	fprintf(out, " },\n");
+	fprintf(out, "  \"total_bits\": %llu\n", (unsigned long long)stats->total_bits);
+	fprintf(out, "}\n");
+}
+
+local FILE *std_file(FILE *std)
+{
+#ifdef _WIN32
+	_setmode(_fileno(std), _O_BINARY);
+#endif
+
+	return std;
+}
 
 int32 main(int32 argc, char **argv)
 {
-	if (argc < 4)
+	int32 deflate_flag = RGE_O_DEFLATE_GAME;
+	int32 inflate_flag = RGE_O_INFLATE_FAST;
+	deflate_params params = { DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_ALL_BLOCKS, TRUE };
+	int32 num_threads = rge_num_cpus();
+	bool32 find_all = FALSE;
+	bool32 parallel = FALSE;
+	bool32 pipelined = FALSE;
+	int32 io_flag = 0;
+	int32 window_size = RGE_WINDOW_SIZE_DEFAULT;
+	size_t range_length = 0;
+	bool32 print_stats = FALSE;
+	bool32 trace = FALSE;
+	byte *dict = NULL;
+	size_t dict_size = 0;
+	int32 train_size = DICT_DEFAULT_SIZE;
+
+	char **args = calloc(argc, sizeof(char *));
+	int32 num_args = 0;
+
+	for (int32 i = 0; i < argc; i++)
+	{
+		if (i && !strncmp(argv[i], "--", 2))
+		{
+			if (!strcmp(argv[i], "--deflate=game"))
+			{
+				deflate_flag = RGE_O_DEFLATE_GAME;
+			}
+			else if (!strcmp(argv[i], "--deflate=fast"))
+			{
+				deflate_flag = RGE_O_DEFLATE_FAST;
+			}
+			else if (!strcmp(argv[i], "--deflate=best"))
+			{
+				deflate_flag = RGE_O_DEFLATE_BEST;
+			}
+			else if (!strcmp(argv[i], "--inflate=fast"))
+			{
+				inflate_flag = (inflate_flag & ~RGE_O_INFLATE_MASK) | RGE_O_INFLATE_FAST;
+			}
+			else if (!strcmp(argv[i], "--inflate=zlib"))
+			{
+				inflate_flag = (inflate_flag & ~RGE_O_INFLATE_MASK) | RGE_O_INFLATE_ZLIB;
+			}
+			else if (!strcmp(argv[i], "--io=posix"))
+			{
+				io_flag = 0;
+			}
+			else if (!strcmp(argv[i], "--io=uring"))
+			{
+				io_flag = RGE_O_IO_URING;
+			}
+			else if (!strncmp(argv[i], "--cpu=", 6))
+			{
+				int32 level = cpu_find_level(argv[i] + 6);
+
+				if (level == CPU_LEVEL_INVALID)
+				{
+					printf("error: unknown cpu level %s\n", argv[i] + 6);
+
+					return 1;
+				}
+
+				cpu_set_level(level);
+			}
+			else if (!strcmp(argv[i], "--prescan"))
+			{
+				inflate_flag |= RGE_O_INFLATE_PRESCAN;
+			}
+			else if (!strncmp(argv[i], "--max-compares=", 15))
+			{
+				char *end;
+				long max_compares = strtol(argv[i] + 15, &end, 10);
+
+				if (end == argv[i] + 15 || *end || max_compares < DEFLATE_MIN_COMPARE || max_compares > DEFLATE_MAX_COMPARE)
+				{
+					printf("error: --max-compares has to be %d to %d\n\n", DEFLATE_MIN_COMPARE, DEFLATE_MAX_COMPARE);
+					printf(USAGE);
+
+					return 1;
+				}
+
+				params.max_compares = (int32)max_compares;
+			}
+			else if (!strcmp(argv[i], "--strategy=all"))
+			{
+				params.strategy = DEFLATE_ALL_BLOCKS;
+			}
+			else if (!strcmp(argv[i], "--strategy=dynamic"))
+			{
+				params.strategy = DEFLATE_DYNAMIC_BLOCKS;
+			}
+			else if (!strcmp(argv[i], "--strategy=static"))
+			{
+				params.strategy = DEFLATE_STATIC_BLOCKS;
+			}
+			else if (!strcmp(argv[i], "--greedy"))
+			{
+				params.greedy_flag = TRUE;
+			}
+			else if (!strcmp(argv[i], "--lazy"))
+			{
+				params.greedy_flag = FALSE;
+			}
+			else if (!strncmp(argv[i], "--threads=", 10))
+			{
+				num_threads = max(1, atoi(argv[i] + 10));
+			}
+			else if (!strcmp(argv[i], "--all"))
+			{
+				find_all = TRUE;
+			}
+			else if (!strcmp(argv[i], "--parallel"))
+			{
+				parallel = TRUE;
+			}
+			else if (!strcmp(argv[i], "--pipelined"))
+			{
+				pipelined = TRUE;
+			}
+			else if (!strncmp(argv[i], "--length=", 9))
+			{
+				range_length = strtoull(argv[i] + 9, NULL, 10);
+			}
+			else if (!strncmp(argv[i], "--window=", 9))
+			{
+				window_size = min(max(atoi(argv[i] + 9), RGE_WINDOW_SIZE_MIN), RGE_WINDOW_SIZE_MAX);
+			}
+			else if (!strcmp(argv[i], "--stats"))
+			{
+				print_stats = TRUE;
+			}
+			else if (!strcmp(argv[i], "--trace"))
+			{
+				trace = TRUE;
+			}
+			else if (!strncmp(argv[i], "--trace=", 8))
+			{
+				trace = TRUE;
+				trace_filename = argv[i] + 8;
+			}
+			else if (!strncmp(argv[i], "--dict=", 7))
+			{
+				dict = read_file(argv[i] + 7, &dict_size);
+
+				if (!dict)
+				{
+					printf("error: couldn't read dictionary %s\n", argv[i] + 7);
+
+					return 1;
+				}
+			}
+			else if (!strncmp(argv[i], "--dict-size=", 12))
+			{
+				train_size = max(DICT_MIN_SIZE, atoi(argv[i] + 12));
+			}
+			else
+			{
+				printf("error: unknown option %s\n\n", argv[i]);
+				printf(USAGE);
+
+				return 1;
+			}
+		}
+		else
+		{
+			args[num_args++] = argv[i];
+		}
+	}
+
+	// the parallel decode is the in-tree decoder's and grows its output as it goes, so neither of these would do anything
+	if (parallel && (inflate_flag & (RGE_O_INFLATE_MASK | RGE_O_INFLATE_PRESCAN)) != RGE_O_INFLATE_FAST)
+	{
+		printf("error: --parallel can't be used with --inflate=zlib or --prescan\n");
+
+		return 1;
+	}
+
+	// only t takes any number of files
+	if (num_args > MAX_BATCH_ARGS && *args[1] == 'b') num_args = MAX_BATCH_ARGS;
+	else if (num_args > MAX_ARGS && *args[1] != 't' && *args[1] != 'b') num_args = MAX_ARGS;
+
+	argc = num_args;
+	argv = args;
+
+	if (argc < 3 || (argc < 4 && *argv[1] != 'd' && *argv[1] != 'b'))
 	{
 		printf(USAGE);
 
 		return 1;
 	}
 
+	// with stdin or stdout the data goes through in pieces and the messages go to stderr
+	bool32 stream_in = argc >= 4 && !strcmp(argv[2], RGE_STDIO_FILENAME);
+	bool32 stream_out = argc >= 4 && !strcmp(argv[3], RGE_STDIO_FILENAME);
+	FILE *info = stream_out ? stderr : stdout;
+
+	if (trace)
+	{
+		trace_info = info;
+
+		trace_start(trace_filename != NULL);
+		atexit(trace_report);
+	}
+
 	if (*argv[1] == 'r')
 	{
-		handle h = rge_open_read_(argv[2]);
+		// a file at an offset is read from there with pread, stdin is skipped through
+		bool32 range = argc == 6 && !stream_in;
+		handle h;
+
+		if (range) h = rge_open_read_range(argv[2], strtoull(argv[5], NULL, 10), range_length, _O_BINARY | inflate_flag);
+		else h = rge_open_read(argv[2], _O_BINARY | inflate_flag | io_flag);
 
 		if (h == INVALID_HANDLE)
 		{
@@ -32,7 +433,13 @@ int32 main(int32 argc, char **argv)
 			return 1;
 		}
 
-		FILE *out = rge_fopen(argv[3], "wb");
+		if (dict) rge_set_dictionary(h, dict, (int32)dict_size);
+
+		if (parallel) rge_set_inflate_threads(h, num_threads);
+
+		rge_set_window_size(h, window_size);
+
+		FILE *out = stream_out ? std_file(stdout) : rge_fopen(argv[3], "wb");
 
 		if (!out)
 		{
@@ -41,7 +448,7 @@ int32 main(int32 argc, char **argv)
 			return 1;
 		}
 
-		if (argc == 6)
+		if (argc == 6 && !range)
 		{
 			int32 num_skip_bytes = atoi(argv[5]);
 
@@ -49,6 +456,7 @@ int32 main(int32 argc, char **argv)
 		}
 
 		int32 num_uncompressed_bytes;
+		bool32 write_ok = TRUE;
 
 		if (argc == 5)
 		{
@@ -57,27 +465,73 @@ int32 main(int32 argc, char **argv)
 
 			rge_read_uncompressed(h, uncompressed, num_uncompressed_bytes);
 
-			fwrite(uncompressed, num_uncompressed_bytes, 1, out);
+			if (fwrite(uncompressed, 1, num_uncompressed_bytes, out) != (size_t)num_uncompressed_bytes) write_ok = FALSE;
 
-			printf("wrote %d uncompressed bytes\n", num_uncompressed_bytes);
+			fprintf(info, "wrote %d uncompressed bytes\n", num_uncompressed_bytes);
 
 			rge_free(uncompressed);
 		}
 
 		int32 num_decompressed_bytes = 0;
 		void *decompressed = NULL;
+		pipe_stage writer;
+
+		if (pipelined && stage_start(&writer, out, stage_write_thread, window_size))
+		{
+			for (ever)
+			{
+				int32 num_read = rge_read_chunk(h, rge_queue_acquire(&writer.queue), window_size);
+
+				rge_queue_push(&writer.queue, num_read);
 
-		rge_read_full(h, &decompressed, &num_decompressed_bytes);
+				if (!num_read) break;
 
-		fwrite(decompressed, num_decompressed_bytes, 1, out);
+				num_decompressed_bytes += num_read;
+			}
 
-		printf("wrote %d decompressed bytes\n", num_decompressed_bytes);
+			stage_stop(&writer);
+
+			if (writer.error) write_ok = FALSE;
+		}
+		else if (stream_in || stream_out || pipelined)
+		{
+			decompressed = malloc(window_size);
+
+			for (int32 num_read; (num_read = rge_read_chunk(h, decompressed, window_size)) > 0; num_decompressed_bytes += num_read)
+			{
+				if (fwrite(decompressed, 1, num_read, out) != (size_t)num_read) write_ok = FALSE;
+			}
+		}
+		else
+		{
+			rge_read_full(h, &decompressed, &num_decompressed_bytes);
+
+			if (fwrite(decompressed, 1, num_decompressed_bytes, out) != (size_t)num_decompressed_bytes) write_ok = FALSE;
+		}
 
 		rge_free(decompressed);
 
-		rge_fclose(out);
+		if (stream_out ? fflush(out) : fclose(out)) write_ok = FALSE;
 
 		rge_close(h);
+
+		if (rge_read_error)
+		{
+			fprintf(info, "error: couldn't inflate %s\n", argv[2]);
+
+			return 1;
+		}
+
+		if (!write_ok)
+		{
+			fprintf(info, "error: couldn't write %s\n", argv[3]);
+
+			return 1;
+		}
+
+		fprintf(info, "wrote %d decompressed bytes\n", num_decompressed_bytes);
+
+		if (range) fprintf(info, "used %lld compressed bytes\n", (long long)rge_get_compressed_size());
 	}
 	else if (*argv[1] == 'w')
 	{
@@ -85,7 +539,7 @@ int32 main(int32 argc, char **argv)
 
 		if (argc == 6)
 		{
-			h = rge_open_write(argv[3], _O_WRONLY | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+			h = rge_open_write(argv[3], _O_WRONLY | _O_CREAT | _O_BINARY | deflate_flag | io_flag | (pipelined ? RGE_O_PIPELINED : 0), _S_IREAD | _S_IWRITE);
 
 			int32 num_skip_bytes = atoi(argv[5]);
 
@@ -93,7 +547,7 @@ int32 main(int32 argc, char **argv)
 		}
 		else
 		{
-			h = rge_open_write_(argv[3]);
+			h = rge_open_write(argv[3], _O_WRONLY | _O_APPEND | _O_CREAT | _O_TRUNC | _O_BINARY | deflate_flag | io_flag | (pipelined ? RGE_O_PIPELINED : 0), _S_IREAD | _S_IWRITE);
 		}
 
 		if (h == INVALID_HANDLE)
@@ -103,7 +557,13 @@ int32 main(int32 argc, char **argv)
 			return 1;
 		}
 
-		FILE *in = rge_fopen(argv[2], "rb");
+		rge_set_deflate_params(h, params.max_compares, params.strategy, params.greedy_flag);
+
+		if (dict) rge_set_dictionary(h, dict, (int32)dict_size);
+
+		rge_set_window_size(h, window_size);
+
+		FILE *in = stream_in ? std_file(stdin) : rge_fopen(argv[2], "rb");
 
 		if (!in)
 		{
@@ -119,31 +579,297 @@ int32 main(int32 argc, char **argv)
 			num_uncompressed_bytes = atoi(argv[4]);
 			void *uncompressed = malloc(num_uncompressed_bytes);
 
-			fread(uncompressed, num_uncompressed_bytes, 1, in);
+			if (fread(uncompressed, 1, num_uncompressed_bytes, in) != (size_t)num_uncompressed_bytes)
+			{
+				fprintf(info, "error: couldn't read %d uncompressed bytes from %s\n", num_uncompressed_bytes, argv[2]);
+
+				return 1;
+			}
 
 			rge_write_uncompressed(h, uncompressed, num_uncompressed_bytes);
 
-			printf("wrote %d uncompressed bytes\n", num_uncompressed_bytes);
+			fprintf(info, "wrote %d uncompressed bytes\n", num_uncompressed_bytes);
+		}
+
+		pipe_stage reader;
+		bool32 whole_file = FALSE;
+
+		if (pipelined && stage_start(&reader, in, stage_read_thread, window_size))
+		{
+			size_t size = 0;
+
+			for (ever)
+			{
+				int32 num_read;
+				byte *data = rge_queue_pop(&reader.queue, &num_read);
+
+				// the empty end goes in too, so empty input still gets a stream
+				rge_write(h, data, num_read);
+
+				rge_queue_release(&reader.queue);
+
+				if (!num_read) break;
+
+				size += num_read;
+			}
+
+			stage_stop(&reader);
+
+			if (reader.error)
+			{
+				fprintf(info, "error: couldn't read %s\n", argv[2]);
+
+				return 1;
+			}
+
+			fprintf(info, "deflated %zu bytes\n", size);
+		}
+		else if (stream_in || stream_out || pipelined)
+		{
+			void *data = malloc(window_size);
+			size_t size = 0;
+
+			size_t num_read;
+
+			// written at least once, so empty input still gets a stream
+			do
+			{
+				num_read = fread(data, 1, window_size, in);
+
+				rge_write(h, data, (int32)num_read);
+
+				size += num_read;
+			}
+			while (num_read == (size_t)window_size);
+
+			if (ferror(in))
+			{
+				fprintf(info, "error: couldn't read %s\n", argv[2]);
+
+				return 1;
+			}
+
+			// a pipe can't tell how much was written
+			fprintf(info, "deflated %zu bytes\n", size);
+
+			rge_free(data);
+		}
+		else
+		{
+			size_t pos = ftell(in);
+			fseek(in, 0, SEEK_END);
+			size_t size = ftell(in) - pos;
+			fseek(in, pos, SEEK_SET);
+
+			void *data = malloc(size);
+
+			if (fread(data, 1, size, in) != size)
+			{
+				printf("error: couldn't read %s\n", argv[2]);
+
+				return 1;
+			}
+
+			rge_write(h, data, size);
+
+			rge_free(data);
+
+			whole_file = TRUE;
+		}
+
+		if (!stream_in) rge_fclose(in);
+
+		if (rge_close(h) || rge_write_error)
+		{
+			fprintf(info, "error: couldn't write %s\n", argv[3]);
+
+			return 1;
 		}
 
-		size_t pos = ftell(in);
+		// only known once the last block is out
+		if (whole_file) printf("wrote %lld compressed bytes\n", (long long)rge_get_compressed_size() - num_uncompressed_bytes);
+
+		if (print_stats)
+		{
+			deflate_stats stats;
+
+			if (rge_get_deflate_stats(&stats)) print_deflate_stats(info, &stats);
+			else fprintf(info, "no stats, they need game deflate and a build with --deflate-stats\n");
+		}
+	}
+	else if (*argv[1] == 'd')
+	{
+		FILE *in = rge_fopen(argv[2], "rb");
+
+		if (!in)
+		{
+			printf("error: couldn't fopen %s for reading\n", argv[2]);
+
+			return 1;
+		}
+
+		long skip = 0;
+
+		if (argc >= 4) skip += atoi(argv[3]);
+		if (argc >= 5) skip += atoi(argv[4]);
+
 		fseek(in, 0, SEEK_END);
-		size_t size = ftell(in) - pos;
-		fseek(in, pos, SEEK_SET);
+		long end = ftell(in);
 
-		void *data = malloc(size);
+		byte *data = NULL;
+		size_t size = 0;
 
-		fread(data, size, 1, in);
+		if (end >= 0 && skip >= 0 && skip <= end && !fseek(in, skip, SEEK_SET))
+		{
+			size = end - skip;
+			data = malloc(max(1, size));
+
+			if (data && fread(data, 1, size, in) != size)
+			{
+				rge_free(data);
+				data = NULL;
+			}
+		}
 
-		rge_write(h, data, size);
+		rge_fclose(in);
 
-		printf("wrote %d compressed bytes\n", _tell(h) - num_uncompressed_bytes);
+		if (!data)
+		{
+			printf("error: couldn't read %s\n", argv[2]);
+
+			return 1;
+		}
+
+		deflate_params *matches = malloc(sizeof(deflate_params) * DETECT_MAX_MATCHES);
+		size_t stream_size = 0;
+
+		int32 num_matches = deflate_detect(data, size, num_threads, find_all, matches, DETECT_MAX_MATCHES, &stream_size);
 
 		rge_free(data);
 
-		rge_fclose(in);
+		if (num_matches == DETECT_ERROR)
+		{
+			fprintf(info, "error: couldn't inflate %s\n", argv[2]);
 
-		rge_close(h);
+			rge_free(matches);
+
+			return 1;
+		}
+
+		printf("compressed stream is %zu bytes\n", stream_size);
+
+		if (!num_matches)
+		{
+			printf("no game deflate setting reproduces %s\n", argv[2]);
+
+			rge_free(matches);
+
+			return 1;
+		}
+
+		for (int32 i = 0; i < num_matches; i++)
+		{
+			int32 j = i;
+
+			// print runs of max_compares with otherwise equal settings as a range
+			while (j + 1 < num_matches
+				&& matches[j + 1].strategy == matches[i].strategy
+				&& matches[j + 1].greedy_flag == matches[i].greedy_flag
+				&& matches[j + 1].max_compares == matches[j].max_compares + 1) j++;
+
+			if (j > i)
+			{
+				printf("match: --max-compares=%d-%d", matches[i].max_compares, matches[j].max_compares);
+			}
+			else
+			{
+				printf("match: --max-compares=%d", matches[i].max_compares);
+			}
+
+			printf(" --strategy=%s %s\n", strategy_names[matches[i].strategy], matches[i].greedy_flag ? "--greedy" : "--lazy");
+
+			i = j;
+		}
+
+		rge_free(matches);
+	}
+	else if (*argv[1] == 't')
+	{
+		int32 num_samples = argc - 3;
+		size_t *sample_sizes = malloc(num_samples * sizeof(size_t));
+		byte *samples = NULL;
+		size_t total_size = 0;
+
+		for (int32 i = 0; i < num_samples; i++)
+		{
+			byte *data = read_file(argv[i + 3], &sample_sizes[i]);
+
+			if (!data)
+			{
+				printf("error: couldn't read %s\n", argv[i + 3]);
+
+				return 1;
+			}
+
+			samples = realloc(samples, total_size + sample_sizes[i]);
+			memcpy(samples + total_size, data, sample_sizes[i]);
+			total_size += sample_sizes[i];
+
+			rge_free(data);
+		}
+
+		byte *trained = malloc(train_size);
+		int32 trained_size = dict_train(samples, sample_sizes, num_samples, trained, train_size);
+
+		rge_free(samples);
+		rge_free(sample_sizes);
+
+		FILE *out = rge_fopen(argv[2], "wb");
+
+		if (!out)
+		{
+			printf("error: couldn't fopen %s for writing\n", argv[2]);
+
+			return 1;
+		}
+
+		fwrite(trained, trained_size, 1, out);
+
+		printf("wrote %d byte dictionary from %d files\n", trained_size, num_samples);
+
+		rge_fclose(out);
+
+		rge_free(trained);
+	}
+	else if (*argv[1] == 'b')
+	{
+		batch_job *jobs;
+		int32 num_jobs;
+
+		if (argc == 3)
+		{
+			num_jobs = batch_read_manifest(argv[2], &jobs);
+		}
+		else if (argc >= 6 && (*argv[2] == 'r' || *argv[2] == 'w'))
+		{
+			num_jobs = batch_find_files(*argv[2], argv[3], argv[4], argv[5], argc >= 7 ? atoi(argv[6]) : 0, argc >= 8 ? atoi(argv[7]) : -1, &jobs);
+		}
+		else
+		{
+			printf(USAGE);
+
+			return 1;
+		}
+
+		if (num_jobs < 0) return 1;
+
+		batch_params batch = { deflate_flag | io_flag, inflate_flag | io_flag, params, dict, (int32)dict_size, window_size };
+
+		int32 num_failed = batch_run(jobs, num_jobs, &batch, num_threads);
+
+		batch_free_jobs(jobs, num_jobs);
+
+		if (num_failed) return 1;
 	}
 	else
 	{
@@ -152,5 +878,8 @@ int32 main(int32 argc, char **argv)
 		return 1;
 	}
 
+	rge_free(dict);
+	rge_free(args);
+
 	return 0;
 }
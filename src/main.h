@@ -30,6 +30,13 @@
 #define _write write
 #define _lseek lseek
 #define _tell(fd) lseek(fd, 0, SEEK_CUR)
+#define _dup dup
+#define _fileno fileno
+#define _fstat fstat
+#define _stat stat
+#define _S_IFMT S_IFMT
+#define _S_IFREG S_IFREG
+#define _S_IFDIR S_IFDIR
 #endif
 
 typedef int8_t int8;
@@ -64,6 +71,12 @@ typedef int32 res_id;
 
 #define local static
 
+#if defined(_MSC_VER)
+#define thread_local __declspec(thread)
+#elif !defined(thread_local) && (!defined(__STDC_VERSION__) || __STDC_VERSION__ < 202311L)
+#define thread_local _Thread_local
+#endif
+
 #define rge_fopen fopen
 #define rge_fclose(stream) { if (stream) { fclose(stream); } stream = NULL; }
 
@@ -0,0 +1,93 @@
+#include "queue.h"
+
+local void rge_queue_free_buffers(rge_queue *queue)
+{
+	for (int32 i = 0; queue->buffers && i < queue->num_buffers; i++)
+	{
+		rge_free(queue->buffers[i]);
+	}
+
+	rge_free(queue->buffers);
+	rge_free(queue->sizes);
+}
+
+bool32 rge_queue_init(rge_queue *queue, int32 num_buffers, int32 buffer_size)
+{
+	memzero(queue, sizeof(rge_queue));
+
+	queue->num_buffers = num_buffers;
+	queue->buffer_size = buffer_size;
+
+	queue->buffers = calloc(num_buffers, sizeof(byte *));
+	queue->sizes = calloc(num_buffers, sizeof(int32));
+
+	for (int32 i = 0; queue->buffers && i < num_buffers; i++)
+	{
+		queue->buffers[i] = malloc(buffer_size);
+
+		if (!queue->buffers[i]) break;
+	}
+
+	if (!queue->sizes || !queue->buffers || !queue->buffers[num_buffers - 1])
+	{
+		rge_queue_free_buffers(queue);
+
+		return FALSE;
+	}
+
+	if (!rge_sem_init(&queue->free_sem, num_buffers))
+	{
+		rge_queue_free_buffers(queue);
+
+		return FALSE;
+	}
+
+	if (!rge_sem_init(&queue->full_sem, 0))
+	{
+		rge_sem_destroy(&queue->free_sem);
+		rge_queue_free_buffers(queue);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+void rge_queue_free(rge_queue *queue)
+{
+	rge_sem_destroy(&queue->free_sem);
+	rge_sem_destroy(&queue->full_sem);
+
+	rge_queue_free_buffers(queue);
+}
+
+byte *rge_queue_acquire(rge_queue *queue)
+{
+	rge_sem_wait(&queue->free_sem);
+
+	return queue->buffers[queue->head];
+}
+
+void rge_queue_push(rge_queue *queue, int32 size)
+{
+	queue->sizes[queue->head] = size;
+	queue->head = (queue->head + 1) % queue->num_buffers;
+
+	rge_sem_post(&queue->full_sem);
+}
+
+byte *rge_queue_pop(rge_queue *queue, int32 *size)
+{
+	rge_sem_wait(&queue->full_sem);
+
+	*size = queue->sizes[queue->tail];
+
+	return queue->buffers[queue->tail];
+}
+
+void rge_queue_release(rge_queue *queue)
+{
+	queue->tail = (queue->tail + 1) % queue->num_buffers;
+
+	rge_sem_post(&queue->free_sem);
+}
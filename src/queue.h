@@ -0,0 +1,28 @@
+#pragma once
+
+#include "thread.h"
+
+#define RGE_QUEUE_DEFAULT_BUFFERS 8
+
+typedef struct rge_queue rge_queue;
+
+// bounded queue of buffers between one producer and one consumer thread, the producer blocks while all buffers are filled
+struct rge_queue
+{
+	byte **buffers;
+	int32 *sizes;
+	int32 num_buffers;
+	int32 buffer_size;
+	int32 head; // next buffer the producer fills, only touched by it
+	int32 tail; // next buffer the consumer takes, only touched by it
+	rge_sem free_sem;
+	rge_sem full_sem;
+};
+
+bool32 rge_queue_init(rge_queue *queue, int32 num_buffers, int32 buffer_size);
+void rge_queue_free(rge_queue *queue); // only after a successful rge_queue_init
+
+byte *rge_queue_acquire(rge_queue *queue); // producer, waits for an empty buffer
+void rge_queue_push(rge_queue *queue, int32 size); // producer, hands the buffer from rge_queue_acquire to the consumer, size 0 marks the end
+byte *rge_queue_pop(rge_queue *queue, int32 *size); // consumer, waits for a filled buffer
+void rge_queue_release(rge_queue *queue); // consumer, gives the buffer from rge_queue_pop back to the producer
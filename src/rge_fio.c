@@ -8,12 +8,16 @@
 
 #include "rge_fio.h"
 #include "compress.h"
+#include "queue.h"
+#include "io.h"
+#include "trace.h"
 
 #define MODE_INVALID -1
 #define MODE_READ 0
 #define MODE_WRITE 1
 
-bool32 rge_write_error = FALSE;
+thread_local bool32 rge_read_error = FALSE;
+thread_local bool32 rge_write_error = FALSE;
 
 #define FLAG_INVALID -1
 #define FLAG_INFLATE 0
@@ -21,49 +25,387 @@ bool32 rge_write_error = FALSE;
 #define FLAG_FIRST_INFLATE 2
 #define FLAG_FIRST_DEFLATE 3
 
-static byte flags = FLAG_INVALID; // current state of inflate/deflate
-static size_t file_size = 0; // complete compressed file size
-static byte *file_buffers = NULL; // complete compressed file
-static size_t compression_point = 0; // offset in compressed file
-static size_t point = 0; // offset in decompressed buffer
-static byte *compression_buffers = NULL; // work data of inflate or deflate algo
-static byte *current = NULL; // pointer to current position in decompress buffer
-static byte buffers[0x10000] = ZEROMEM; // decompression/compression buffer
-static handle current_handle = INVALID_HANDLE; // handle to current file
-static char *current_filename = NULL;
+typedef struct rge_writer rge_writer;
 
-handle rge_fake_open_read(handle file_handle, int32 fake_size)
+struct rge_writer
 {
-	if (file_handle != INVALID_HANDLE)
+	rge_queue queue;
+	rge_thread thread;
+	handle handle;
+	volatile bool32 error; // set by the thread, rge_output stops queueing once it sees it
+};
+
+// everything about the file that's open, one per thread, and more through rge_file_new/rge_file_switch
+struct rge_file
+{
+	byte flags; // current state of inflate/deflate
+	size_t file_size; // complete compressed file size
+	bool32 stream; // the file is a pipe without a size, it's read until it ends
+	io_backend *io; // file I/O of the current file
+	byte *file_buffers; // complete compressed file
+	size_t compression_point; // offset in compressed file
+	size_t point; // offset in decompressed buffer
+	byte *compression_buffers; // work data of inflate or deflate algo
+	deflate_backend *backend; // deflate algo used for writing
+	inflate_backend *inflater; // inflate algo used for reading
+	bool32 prescan; // get the decompressed size before rge_read_full
+	int32 inflate_threads; // threads rge_read_full decodes with
+	deflate_params params; // settings of the deflate algo
+	byte *dictionary; // preset dictionary of the current file, owned by the caller
+	int32 dictionary_size;
+	byte *current; // pointer to current position in decompress buffer
+	size_t buffered_size; // decompressed bytes in buffers, less than its size only at the end of the stream
+	int32 inflate_code; // last result of the inflate algo
+	byte default_buffers[RGE_WINDOW_SIZE_DEFAULT]; // window of files that don't set a size of their own
+	byte *buffers; // decompression/compression buffer, the window
+	size_t buffers_size;
+	handle current_handle; // handle to current file
+	char *current_filename;
+	size_t file_pos; // position in the file as far as the caller is concerned, output still queued included
+	bool32 output_error; // a write of the current file failed
+	rge_writer *writer; // writes the output behind the deflate algo on a thread of its own
+	bool32 write_through; // no writer for the current file, RGE_O_WRITE_THROUGH
+	bool32 memory_flag; // rge_open_read_memory/rge_open_write_memory, no file behind the handle
+	byte *memory; // read straight from, owned by the caller, or written to and handed to the caller at rge_close
+	size_t memory_size; // of what's read, or allocated for what's written
+	size_t memory_pos; // read or written so far
+	void **memory_data; // where rge_close puts what was written
+	size_t *memory_data_size;
+	bool32 range_flag; // rge_open_read_range, read with pread from range_offset on
+	int64 range_offset;
+};
+
+// thread local, so several threads can each work on a file of their own
+static thread_local rge_file thread_file = { .flags = FLAG_INVALID, .inflate_threads = 1, .current_handle = INVALID_HANDLE };
+static thread_local rge_file *switched_file = NULL; // rge_file_switch'd to instead of thread_file
+static thread_local deflate_stats last_stats = ZEROMEM; // of the last file written, for rge_get_deflate_stats
+static thread_local bool32 last_stats_flag = FALSE;
+static thread_local size_t last_compressed_size = 0; // of the last file closed, for rge_get_compressed_size
+
+static rge_file *rge_get_file()
+{
+	return switched_file ? switched_file : &thread_file;
+}
+
+#define SPARE_FILE 0
+#define SPARE_WORK 1
+#define SPARE_WINDOW 2
+
+static thread_local byte *spare_buffers[3] = ZEROMEM; // file_buffers, compression_buffers and buffers of the last file, reused for the next one
+static thread_local size_t spare_sizes[3] = ZEROMEM;
+
+static byte *rge_alloc_buffers(int32 spare, size_t size)
+{
+	if (!spare_buffers[spare] || spare_sizes[spare] < size)
 	{
-		flags = FLAG_FIRST_INFLATE;
-		point = 0;
-		memzero(buffers, sizeof(buffers));
-		current = buffers;
-		file_buffers = NULL;
-		compression_buffers = NULL;
-		current_handle = file_handle;
-		file_size = fake_size;
-		current_filename = EMPTYSTR;
+		rge_free(spare_buffers[spare]);
+
+		spare_buffers[spare] = malloc(max(size, 1));
+		spare_sizes[spare] = size;
 	}
-	else
+
+	byte *buffers = spare_buffers[spare];
+
+	spare_buffers[spare] = NULL;
+
+	return buffers;
+}
+
+static void rge_keep_buffers(int32 spare, byte *buffers)
+{
+	if (buffers && !spare_buffers[spare]) spare_buffers[spare] = buffers;
+	else if (buffers != spare_buffers[spare]) free(buffers);
+}
+
+// _write stops short when the disk is full
+static bool32 rge_write_all(io_backend *file_io, handle handle, byte *data, int32 size)
+{
+	while (size > 0)
 	{
-		printf("invalid handle passed to rge_fake_open_read\n");
+		TRACE_BEGIN(TRACE_WRITE);
+
+		int32 num_written = file_io->write(handle, data, size);
+
+		TRACE_END(TRACE_WRITE);
+
+		if (num_written <= 0) return FALSE;
+
+		data += num_written;
+		size -= num_written;
 	}
 
-	return file_handle;
+	return TRUE;
 }
 
-handle rge_fake_close(handle handle)
+static void rge_writer_thread(void *arg)
+{
+	rge_writer *writer = (rge_writer *)arg;
+
+	for (ever)
+	{
+		int32 size;
+		byte *data = rge_queue_pop(&writer->queue, &size);
+
+		// after an error the rest is only drained, so rge_output never waits forever, plain calls as this thread is the one waiting anyway
+		if (size && !writer->error && !rge_write_all(io_get_backend(IO_BACKEND_POSIX), writer->handle, data, size)) writer->error = TRUE;
+
+		rge_queue_release(&writer->queue);
+
+		if (!size) break;
+	}
+}
+
+static bool32 rge_start_writer(handle handle)
+{
+	rge_file *file = rge_get_file();
+
+	file->writer = calloc(1, sizeof(rge_writer));
+
+	if (file->writer && rge_queue_init(&file->writer->queue, RGE_QUEUE_DEFAULT_BUFFERS, (int32)file->buffers_size))
+	{
+		file->writer->handle = handle;
+
+		if (rge_thread_create(&file->writer->thread, rge_writer_thread, file->writer)) return TRUE;
+
+		rge_queue_free(&file->writer->queue);
+	}
+
+	rge_free(file->writer);
+
+	return FALSE;
+}
+
+static void rge_stop_writer()
+{
+	rge_file *file = rge_get_file();
+
+	rge_queue_acquire(&file->writer->queue);
+	rge_queue_push(&file->writer->queue, 0);
+
+	rge_thread_join(&file->writer->thread);
+
+	if (file->writer->error) file->output_error = TRUE;
+
+	rge_queue_free(&file->writer->queue);
+	rge_free(file->writer);
+}
+
+// grown like rge_read_full grows its output
+static bool32 rge_write_memory(rge_file *file, byte *data, int32 size)
+{
+	if (file->memory_pos + size > file->memory_size)
+	{
+		size_t new_size = max(max(file->memory_size * 2, file->memory_pos + size), file->buffers_size);
+		byte *new_memory = realloc(file->memory, new_size);
+
+		if (!new_memory) return FALSE;
+
+		file->memory = new_memory;
+		file->memory_size = new_size;
+	}
+
+	memcpy(file->memory + file->memory_pos, data, size);
+	file->memory_pos += size;
+
+	return TRUE;
+}
+
+// straight to the file or memory, or through the writer
+static void rge_output(byte *data, int32 size)
+{
+	rge_file *file = rge_get_file();
+
+	file->file_pos += size;
+
+	if (file->memory_flag)
+	{
+		if (!file->output_error && !rge_write_memory(file, data, size)) file->output_error = TRUE;
+
+		return;
+	}
+
+	if (!file->writer)
+	{
+		if (!file->output_error && !rge_write_all(file->io, file->current_handle, data, size)) file->output_error = TRUE;
+
+		return;
+	}
+
+	if (file->writer->error) file->output_error = TRUE;
+
+	while (size > 0 && !file->output_error)
+	{
+		int32 num_queued = min(size, file->writer->queue.buffer_size);
+
+		memcpy(rge_queue_acquire(&file->writer->queue), data, num_queued);
+		rge_queue_push(&file->writer->queue, num_queued);
+
+		data += num_queued;
+		size -= num_queued;
+	}
+}
+
+// the default one is part of the thread, anything else is kept for the next file
+static void rge_free_window()
+{
+	rge_file *file = rge_get_file();
+
+	if (file->buffers != file->default_buffers) rge_keep_buffers(SPARE_WINDOW, file->buffers);
+
+	file->buffers = file->default_buffers;
+	file->buffers_size = sizeof(file->default_buffers);
+}
+
+void rge_free_thread_buffers()
+{
+	rge_free(spare_buffers[SPARE_FILE]);
+	rge_free(spare_buffers[SPARE_WORK]);
+	rge_free(spare_buffers[SPARE_WINDOW]);
+
+	io_free_thread();
+}
+
+rge_file *rge_file_new()
+{
+	rge_file *new_file = calloc(1, sizeof(rge_file));
+
+	if (new_file)
+	{
+		new_file->flags = FLAG_INVALID;
+		new_file->inflate_threads = 1;
+		new_file->current_handle = INVALID_HANDLE;
+	}
+
+	return new_file;
+}
+
+void rge_file_free(rge_file *old_file)
+{
+	if (old_file == switched_file) switched_file = NULL;
+
+	free(old_file);
+}
+
+rge_file *rge_file_switch(rge_file *new_file)
+{
+	rge_file *old_file = switched_file;
+
+	switched_file = new_file;
+
+	return old_file;
+}
+
+// duplicated so rge_close can close it like any other file
+static handle rge_open_dup(handle file_handle)
+{
+#ifdef _WIN32
+	_setmode(file_handle, _O_BINARY);
+#endif
+
+	return _dup(file_handle);
+}
+
+// _read stops short on pipes
+static size_t rge_read_all(handle handle, byte *data, size_t size)
+{
+	rge_file *file = rge_get_file();
+
+	if (file->memory_flag)
+	{
+		size = min(size, file->memory_size - file->memory_pos);
+
+		memcpy(data, file->memory + file->memory_pos, size);
+		file->memory_pos += size;
+
+		return size;
+	}
+
+	size_t total = 0;
+
+	while (total < size)
+	{
+		TRACE_BEGIN(TRACE_READ);
+
+		int32 num_read;
+
+		if (file->range_flag) num_read = io_pread(handle, data + total, (int32)min(size - total, 0x40000000), file->range_offset);
+		else num_read = file->io->read(handle, data + total, (uint32)min(size - total, 0x40000000));
+
+		TRACE_END(TRACE_READ);
+
+		if (num_read <= 0) break;
+
+		total += num_read;
+
+		if (file->range_flag) file->range_offset += num_read;
+	}
+
+	return total;
+}
+
+// "-" is a duplicate of std_handle, everything else goes through the io backend, which gets the size along with opening
+static handle rge_open_file(io_backend *file_io, char *filename, int32 flag, int32 pmode, handle std_handle, size_t *size, bool32 *regular)
+{
+	if (strcmp(filename, RGE_STDIO_FILENAME)) return file_io->open(filename, flag, pmode, size, regular);
+
+	handle handle = rge_open_dup(std_handle);
+
+	if (handle != INVALID_HANDLE) io_stat(handle, size, regular);
+
+	return handle;
+}
+
+// what every way of opening a file to read sets up
+static void rge_init_read(rge_file *file, handle handle, int32 flag, io_backend *read_io, size_t size, bool32 regular, char *filename)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	file->flags = FLAG_FIRST_INFLATE;
+	file->inflater = inflate_get_backend((flag & RGE_O_INFLATE_MASK) >> RGE_O_INFLATE_SHIFT);
+	file->prescan = (flag & RGE_O_INFLATE_PRESCAN) != 0;
+	file->inflate_threads = 1;
+	file->point = 0;
+	file->buffers = file->default_buffers;
+	file->buffers_size = sizeof(file->default_buffers);
+	memzero(file->buffers, file->buffers_size);
+	file->current = file->buffers;
+	file->file_buffers = NULL;
+	file->compression_buffers = NULL;
+	file->compression_point = 0;
+	file->dictionary = NULL;
+	file->dictionary_size = 0;
+	file->current_handle = handle;
+	file->stream = !regular;
+	file->io = read_io;
+	file->memory_flag = FALSE;
+	file->range_flag = FALSE;
+	file->file_size = size;
+	file->file_pos = 0;
+	file->output_error = FALSE;
+	file->current_filename = filename;
+}
+
+static handle rge_open_read_file(char *filename, handle std_handle, int32 flag)
+{
+	io_backend *read_io = io_get_backend(flag & RGE_O_IO_URING ? IO_BACKEND_URING : IO_BACKEND_POSIX);
+	size_t size = 0;
+	bool32 regular = FALSE;
+
+	if (trace_enabled) trace_begin(TRACE_FILE, filename);
+
+	TRACE_BEGIN(TRACE_OPEN);
+
+	handle handle = rge_open_file(read_io, filename, flag & ~(RGE_O_INFLATE_MASK | RGE_O_INFLATE_PRESCAN | RGE_O_IO_URING), 0, std_handle, &size, &regular);
+
+	TRACE_END(TRACE_OPEN);
+
+	if (handle != INVALID_HANDLE)
+	{
+		rge_init_read(rge_get_file(), handle, flag, read_io, size, regular, filename);
+	}
+	else
 	{
-		rge_free(compression_buffers);
-		rge_free(file_buffers);
+		fprintf(stderr, "couldn't open %s\n", filename);
 
-		current_handle = INVALID_HANDLE;
-		flags = FLAG_INVALID;
-		current_filename = NULL;
+		TRACE_END(TRACE_FILE);
 	}
 
 	return handle;
@@ -71,25 +413,152 @@ handle rge_fake_close(handle handle)
 
 handle rge_open_read(char *filename, int32 flag)
 {
-	handle handle = _open(filename, flag);
+	return rge_open_read_file(filename, _fileno(stdin), flag);
+}
+
+handle rge_open_read_handle(handle file_handle, int32 flag)
+{
+	return rge_open_read_file(RGE_STDIO_FILENAME, file_handle, flag & ~RGE_O_IO_URING);
+}
+
+// only regular files can be read at an offset, the rest of the file after it is all there is to read without a length
+static handle rge_open_read_range_file(char *filename, handle std_handle, size_t offset, size_t length, int32 flag)
+{
+	handle handle = rge_open_read_file(filename, std_handle, flag & ~RGE_O_IO_URING);
+
+	if (handle == INVALID_HANDLE) return handle;
+
+	rge_file *file = rge_get_file();
+
+	if (file->stream || offset > file->file_size)
+	{
+		fprintf(stderr, "couldn't read %s from offset %lld on\n", filename, (long long)offset);
+
+		rge_close(handle);
+
+		return INVALID_HANDLE;
+	}
+
+	file->range_flag = TRUE;
+	file->range_offset = offset;
+	file->file_size -= offset;
+
+	if (length) file->file_size = min(file->file_size, length);
+
+	return handle;
+}
+
+handle rge_open_read_range(char *filename, size_t offset, size_t length, int32 flag)
+{
+	return rge_open_read_range_file(filename, _fileno(stdin), offset, length, flag);
+}
+
+handle rge_open_read_range_handle(handle file_handle, size_t offset, size_t length, int32 flag)
+{
+	return rge_open_read_range_file(RGE_STDIO_FILENAME, file_handle, offset, length, flag);
+}
+
+handle rge_open_read_memory(void *data, size_t size, int32 flag)
+{
+	rge_file *file = rge_get_file();
+
+	if (!data && size)
+	{
+		fprintf(stderr, "invalid data passed to rge_open_read_memory\n");
+
+		return INVALID_HANDLE;
+	}
+
+	if (trace_enabled) trace_begin(TRACE_FILE, EMPTYSTR);
+
+	rge_init_read(file, RGE_MEMORY_HANDLE, flag, io_get_backend(IO_BACKEND_POSIX), size, TRUE, EMPTYSTR);
+
+	file->memory_flag = TRUE;
+	file->memory = (byte *)data;
+	file->memory_size = size;
+	file->memory_pos = 0;
+
+	return RGE_MEMORY_HANDLE;
+}
+
+handle rge_fake_open_read(handle file_handle, int32 fake_size)
+{
+	if (file_handle != INVALID_HANDLE)
+	{
+		rge_init_read(rge_get_file(), file_handle, RGE_O_INFLATE_FAST, io_get_backend(IO_BACKEND_POSIX), fake_size, TRUE, EMPTYSTR);
+	}
+	else
+	{
+		fprintf(stderr, "invalid handle passed to rge_fake_open_read\n");
+	}
+
+	return file_handle;
+}
+
+// what every way of opening a file to write sets up
+static void rge_init_write(rge_file *file, handle handle, deflate_backend *write_backend, int32 flag, io_backend *write_io, size_t size, bool32 regular, char *filename)
+{
+	file->flags = FLAG_FIRST_DEFLATE;
+	file->backend = write_backend;
+	file->params.max_compares = DEFLATE_MAX_COMPARES_DEFAULT;
+	file->params.strategy = DEFLATE_ALL_BLOCKS;
+	file->params.greedy_flag = TRUE;
+	file->point = 0;
+	file->buffers = file->default_buffers;
+	file->buffers_size = sizeof(file->default_buffers);
+	memzero(file->buffers, file->buffers_size);
+	file->current = file->buffers;
+	file->file_buffers = NULL;
+	file->compression_buffers = NULL;
+	file->dictionary = NULL;
+	file->dictionary_size = 0;
+	file->current_handle = handle;
+	file->stream = !regular;
+	file->io = write_io;
+	file->memory_flag = FALSE;
+	file->range_flag = FALSE;
+	file->file_size = size;
+	file->file_pos = 0;
+	file->output_error = FALSE;
+	file->write_through = (flag & RGE_O_WRITE_THROUGH) != 0;
+	file->current_filename = filename;
+}
+
+static handle rge_open_write_file(char *filename, handle std_handle, int32 flag, int32 pmode)
+{
+	deflate_backend *write_backend = deflate_get_backend((flag & RGE_O_DEFLATE_MASK) >> RGE_O_DEFLATE_SHIFT);
+
+	if (!write_backend)
+	{
+		fprintf(stderr, "invalid deflate backend passed to rge_open_write\n");
+
+		return INVALID_HANDLE;
+	}
+
+	io_backend *write_io = io_get_backend(flag & RGE_O_IO_URING ? IO_BACKEND_URING : IO_BACKEND_POSIX);
+	size_t size = 0;
+	bool32 regular = FALSE;
+
+	if (trace_enabled) trace_begin(TRACE_FILE, filename);
+
+	TRACE_BEGIN(TRACE_OPEN);
+
+	handle handle = rge_open_file(write_io, filename, flag & ~(RGE_O_DEFLATE_MASK | RGE_O_PIPELINED | RGE_O_WRITE_THROUGH | RGE_O_IO_URING), pmode, std_handle, &size, &regular);
+
+	TRACE_END(TRACE_OPEN);
 
 	if (handle != INVALID_HANDLE)
 	{
-		flags = FLAG_FIRST_INFLATE;
-		point = 0;
-		memzero(buffers, sizeof(buffers));
-		current = buffers;
-		file_buffers = NULL;
-		compression_buffers = NULL;
-		current_handle = handle;
-		_lseek(handle, 0, SEEK_END);
-		file_size = _tell(handle);
-		_lseek(handle, 0, SEEK_SET);
-		current_filename = filename;
+		rge_init_write(rge_get_file(), handle, write_backend, flag, write_io, size, regular, filename);
+
+		// otherwise the writer is only started once the first buffer is full, files that fit in one don't need it, without it it's just written directly
+		if (flag & RGE_O_PIPELINED) rge_start_writer(handle);
 	}
 	else
 	{
-		printf("couldn't open %s\n", filename);
+		fprintf(stderr, "couldn't open %s\n", filename);
+
+		TRACE_END(TRACE_FILE);
 	}
 
 	return handle;
@@ -97,25 +566,68 @@ handle rge_open_read(char *filename, int32 flag)
 
 handle rge_open_write(char *filename, int32 flag, int32 pmode)
 {
-	handle handle = _open(filename, flag, pmode);
+	return rge_open_write_file(filename, _fileno(stdout), flag, pmode);
+}
+
+handle rge_open_write_handle(handle file_handle, int32 flag)
+{
+	return rge_open_write_file(RGE_STDIO_FILENAME, file_handle, flag & ~RGE_O_IO_URING, 0);
+}
 
-	if (handle != INVALID_HANDLE)
+handle rge_open_write_memory(void **data, size_t *size, int32 flag)
+{
+	deflate_backend *write_backend = deflate_get_backend((flag & RGE_O_DEFLATE_MASK) >> RGE_O_DEFLATE_SHIFT);
+
+	if (!write_backend || !data || !size)
 	{
-		flags = FLAG_FIRST_DEFLATE;
-		point = 0;
-		memzero(buffers, sizeof(buffers));
-		current = buffers;
-		file_buffers = NULL;
-		compression_buffers = NULL;
-		current_handle = handle;
-		_lseek(handle, 0, SEEK_END);
-		file_size = _tell(handle);
-		_lseek(handle, 0, SEEK_SET);
-		current_filename = filename;
+		fprintf(stderr, "invalid deflate backend or data passed to rge_open_write_memory\n");
+
+		return INVALID_HANDLE;
 	}
-	else
+
+	rge_file *file = rge_get_file();
+
+	if (trace_enabled) trace_begin(TRACE_FILE, EMPTYSTR);
+
+	rge_init_write(file, RGE_MEMORY_HANDLE, write_backend, flag, io_get_backend(IO_BACKEND_POSIX), 0, TRUE, EMPTYSTR);
+
+	// nothing to wait for, so no writer either
+	file->write_through = TRUE;
+	file->memory_flag = TRUE;
+	file->memory = NULL;
+	file->memory_size = 0;
+	file->memory_pos = 0;
+	file->memory_data = data;
+	file->memory_data_size = size;
+
+	*data = NULL;
+	*size = 0;
+
+	return RGE_MEMORY_HANDLE;
+}
+
+// the caller's memory isn't there to be kept for the next file
+static void rge_release_buffers(rge_file *file)
+{
+	rge_keep_buffers(SPARE_WORK, file->compression_buffers);
+	if (!file->memory_flag) rge_keep_buffers(SPARE_FILE, file->file_buffers);
+	rge_free_window();
+
+	file->compression_buffers = NULL;
+	file->file_buffers = NULL;
+}
+
+handle rge_fake_close(handle handle)
+{
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
 	{
-		printf("couldn't open %s\n", filename);
+		rge_release_buffers(file);
+
+		file->current_handle = INVALID_HANDLE;
+		file->flags = FLAG_INVALID;
+		file->current_filename = NULL;
 	}
 
 	return handle;
@@ -123,90 +635,431 @@ handle rge_open_write(char *filename, int32 flag, int32 pmode)
 
 int32 rge_close(handle handle)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
 	{
-		if (flags == FLAG_DEFLATE)
+		bool32 read_flag = file->flags == FLAG_FIRST_INFLATE || file->flags == FLAG_INFLATE;
+
+		// no writer just for the last buffer
+		file->write_through = TRUE;
+		last_stats_flag = FALSE;
+
+		if (file->flags == FLAG_DEFLATE)
 		{
-			if (deflate_data(compression_buffers, NULL, 0, TRUE) == DEFLATE_ERROR) rge_write_error = TRUE;
+			if (file->backend->data(file->compression_buffers, NULL, 0, TRUE) == DEFLATE_ERROR) rge_write_error = TRUE;
+
+			last_stats_flag = file->backend->get_stats(file->compression_buffers, &last_stats);
 
-			deflate_deinit(compression_buffers);
+			file->backend->deinit(file->compression_buffers);
+		}
+		else if (file->flags == FLAG_INFLATE && file->compression_buffers)
+		{
+			file->inflater->deinit(file->compression_buffers);
+		}
+
+		// everything that's queued is written before the file is closed
+		if (file->writer) rge_stop_writer();
+
+		if (file->output_error) rge_write_error = TRUE;
+
+		if (read_flag) last_compressed_size = file->flags == FLAG_INFLATE ? file->compression_point : 0;
+		else last_compressed_size = file->file_pos;
+
+		// the caller frees it
+		if (file->memory_flag && !read_flag)
+		{
+			*file->memory_data = file->memory;
+			*file->memory_data_size = file->memory_pos;
 		}
 
-		current_handle = INVALID_HANDLE;
-		flags = FLAG_INVALID;
-		current_filename = NULL;
+		file->current_handle = INVALID_HANDLE;
+		file->flags = FLAG_INVALID;
+		file->current_filename = NULL;
 
-		rge_free(compression_buffers);
-		rge_free(file_buffers);
+		rge_release_buffers(file);
 
-		return _close(handle);
+		// errors closing a file that was only read don't matter, so the backend may do it in the background
+		TRACE_BEGIN(TRACE_CLOSE);
+
+		int32 result = file->memory_flag ? 0 : file->io->close(handle, !read_flag);
+
+		TRACE_END(TRACE_FILE);
+
+		return file->output_error ? -1 : result;
 	}
 
 	return -1;
 }
 
+void rge_set_deflate_params(handle handle, int32 max_compares, int32 strategy, bool32 greedy_flag)
+{
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle && file->flags == FLAG_FIRST_DEFLATE)
+	{
+		file->params.max_compares = max_compares;
+		file->params.strategy = strategy;
+		file->params.greedy_flag = greedy_flag;
+	}
+}
+
+void rge_set_dictionary(handle handle, void *dict, int32 dict_size)
+{
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle && (file->flags == FLAG_FIRST_INFLATE || file->flags == FLAG_FIRST_DEFLATE))
+	{
+		file->dictionary = (byte *)dict;
+		file->dictionary_size = dict_size;
+	}
+}
+
+void rge_set_window_size(handle handle, int32 window_size)
+{
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle && (file->flags == FLAG_FIRST_INFLATE || file->flags == FLAG_FIRST_DEFLATE))
+	{
+		window_size = min(max(window_size, RGE_WINDOW_SIZE_MIN), RGE_WINDOW_SIZE_MAX);
+
+		if ((size_t)window_size == file->buffers_size) return;
+
+		rge_free_window();
+
+		if (window_size != sizeof(file->default_buffers))
+		{
+			file->buffers = rge_alloc_buffers(SPARE_WINDOW, window_size);
+			file->buffers_size = window_size;
+
+			memzero(file->buffers, file->buffers_size);
+		}
+
+		file->current = file->buffers;
+
+		// an RGE_O_PIPELINED writer queues pieces of the window size, anything already queued is written out first
+		if (file->writer)
+		{
+			rge_stop_writer();
+			rge_start_writer(handle);
+		}
+	}
+}
+
+void rge_set_inflate_threads(handle handle, int32 num_threads)
+{
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle && file->flags == FLAG_FIRST_INFLATE)
+	{
+		file->inflate_threads = max(1, num_threads);
+	}
+}
+
 void rge_fast_forward(handle handle, int32 size)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
 	{
-		if (file_size) file_size -= size;
+		if (file->file_size) file->file_size -= size;
 
-		_lseek(handle, size, SEEK_CUR);
+		file->file_pos += size;
+
+		if (file->memory_flag)
+		{
+			file->memory_pos = min(file->memory_pos + size, file->memory_size);
+		}
+		else if (file->range_flag)
+		{
+			file->range_offset += size;
+		}
+		else if (!file->stream)
+		{
+			_lseek(handle, size, SEEK_CUR);
+		}
+		else if (file->flags == FLAG_FIRST_INFLATE)
+		{
+			// nothing decoded yet, so buffers is free to skip through
+			for (int32 skip; size > 0; size -= skip)
+			{
+				skip = (int32)rge_read_all(handle, file->buffers, min((size_t)size, file->buffers_size));
+
+				if (!skip) break;
+			}
+		}
 	}
 }
 
+bool32 rge_get_deflate_stats(deflate_stats *stats)
+{
+	if (last_stats_flag) *stats = last_stats;
+
+	return last_stats_flag;
+}
+
+size_t rge_get_compressed_size()
+{
+	return last_compressed_size;
+}
+
+int32 rge_tell(handle handle)
+{
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle) return (int32)file->file_pos;
+
+	return -1;
+}
+
 void rge_read_uncompressed(handle handle, void *data, int32 size)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
 	{
-		_read(handle, data, size);
-		file_size -= size;
+		rge_read_all(handle, data, size);
+
+		file->file_pos += size;
+
+		if (!file->stream) file->file_size -= size;
 	}
 }
 
 void rge_write_uncompressed(handle handle, void *data, int32 size)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
+	{
+		rge_output((byte *)data, size);
+	}
+}
+
+// reads the rest of the compressed file and sets up the inflate algo, when there isn't enough memory for that the file reads as empty
+static bool32 rge_start_inflate(handle handle)
+{
+	rge_file *file = rge_get_file();
+
+	file->flags = FLAG_INFLATE;
+
+	if (file->memory_flag)
+	{
+		// decoded straight from the caller's memory
+		file->file_buffers = file->memory + file->memory_pos;
+		file->file_size = file->memory_size - file->memory_pos;
+	}
+	else if (!file->stream)
+	{
+		file->file_buffers = rge_alloc_buffers(SPARE_FILE, file->file_size);
+
+		if (file->file_buffers) rge_read_all(handle, file->file_buffers, file->file_size);
+	}
+	else
+	{
+		// the inflate algos want all of the input at once
+		size_t file_alloc = file->buffers_size;
+
+		file->file_buffers = rge_alloc_buffers(SPARE_FILE, file_alloc);
+
+		while (file->file_buffers)
+		{
+			file->file_size += rge_read_all(handle, file->file_buffers + file->file_size, file_alloc - file->file_size);
+
+			if (file->file_size < file_alloc) break;
+
+			file_alloc *= 2;
+
+			byte *new_file_buffers = realloc(file->file_buffers, file_alloc);
+
+			if (!new_file_buffers) rge_free(file->file_buffers);
+
+			file->file_buffers = new_file_buffers;
+		}
+	}
+
+	file->file_pos += file->file_size;
+
+	file->compression_buffers = file->file_buffers ? rge_alloc_buffers(SPARE_WORK, file->inflater->buf_size()) : NULL;
+	file->compression_point = 0;
+
+	// the read functions do nothing without compression_buffers
+	if (!file->compression_buffers)
 	{
-		if (_write(handle, data, size) == -1) rge_write_error = TRUE;
+		fprintf(stderr, "couldn't read the compressed file, out of memory\n");
+
+		rge_read_error = TRUE;
+
+		if (!file->memory_flag) rge_keep_buffers(SPARE_FILE, file->file_buffers);
+
+		file->file_buffers = NULL;
+
+		return FALSE;
 	}
+
+	memzero(file->compression_buffers, file->inflater->buf_size());
+
+	file->inflater->set_dictionary(file->compression_buffers, file->dictionary, file->dictionary_size);
+
+	return TRUE;
 }
 
 void rge_read_full(handle handle, void **data, int32 *size)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	size_t full_size = 0;
+
+	rge_read_full_size(handle, data, &full_size);
+
+	// the game's interface has no room for more
+	if (full_size > INT32_MAX)
+	{
+		rge_read_error = TRUE;
+		full_size = INT32_MAX;
+	}
+
+	*size = (int32)full_size;
+}
+
+void rge_read_full_size(handle handle, void **data, size_t *size)
+{
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
 	{
 		size_t temp_size;
-		size_t temp_max = sizeof(buffers);
+		size_t temp_max = file->buffers_size;
+
+		*data = NULL;
+		*size = 0;
+
+		if (file->flags == FLAG_INFLATE && !file->compression_buffers) return;
 
-		if (flags == FLAG_FIRST_INFLATE)
+		if (file->flags == FLAG_FIRST_INFLATE)
 		{
-			flags = FLAG_INFLATE;
+			if (!rge_start_inflate(handle)) return;
+
+			// the parallel decode is the in-tree decoder's, rge_set_inflate_threads is ignored with the others or a prescan
+			if (file->inflate_threads > 1 && file->inflater == inflate_get_backend(INFLATE_BACKEND_FAST) && !file->prescan)
+			{
+				byte *data_ptr;
+				size_t data_size;
+
+				temp_size = file->file_size;
+
+				TRACE_BEGIN(TRACE_INFLATE);
+
+				if (Inf32DecodeParallel(file->file_buffers, &temp_size, &data_ptr, &data_size, file->dictionary, file->dictionary_size, file->inflate_threads) == INFLATE_ERROR) rge_read_error = TRUE;
+
+				TRACE_END(TRACE_INFLATE);
+
+				file->compression_point = temp_size;
+
+				*data = data_ptr;
+				*size = data_size;
+
+				return;
+			}
 
-			file_buffers = malloc(file_size);
-			_read(handle, file_buffers, file_size);
+			// nothing read yet, so the whole stream is decoded straight into data, only growing it if the guess was too small
+			size_t data_alloc = max(file->file_size * 4, file->buffers_size);
 
-			compression_buffers = calloc(Inf32BufSize(), 1);
-			compression_point = 0;
+			if (file->prescan)
+			{
+				void *scan_buffers = calloc(Inf32BufSize(), 1);
+				size_t scan_size;
+
+				if (Inf32ScanSize(file->file_buffers, file->file_size, &scan_size, scan_buffers) == INFLATE_EOF) data_alloc = scan_size;
+
+				rge_free(scan_buffers);
+			}
+
+			int32 code;
+			size_t data_size = 0;
+			byte *data_ptr = malloc(data_alloc + INFLATE_FULL_SLACK);
+
+			if (!data_ptr)
+			{
+				rge_read_error = TRUE;
+
+				return;
+			}
+
+			for (ever)
+			{
+				temp_size = file->file_size;
+				temp_max = data_alloc;
+
+				TRACE_BEGIN(TRACE_INFLATE);
+
+				code = file->inflater->decode_full(file->file_buffers, &temp_size, data_ptr, data_size, &temp_max, file->compression_buffers);
+
+				TRACE_END(TRACE_INFLATE);
+
+				file->compression_point = temp_size;
+				data_size = temp_max;
+
+				if (code != INFLATE_OK) break;
+
+				data_alloc = max(data_alloc * 2, file->buffers_size);
+
+				byte *new_data_ptr = realloc(data_ptr, data_alloc + INFLATE_FULL_SLACK);
+
+				// what's decoded so far is still handed out
+				if (!new_data_ptr)
+				{
+					code = INFLATE_ERROR;
+
+					break;
+				}
+
+				data_ptr = new_data_ptr;
+			}
+
+			if (code == INFLATE_ERROR) rge_read_error = TRUE;
+
+			*data = data_ptr;
+			*size = data_size;
+
+			return;
 		}
 
 		int32 code;
-		int32 data_size = 0;
-		size_t data_alloc = sizeof(buffers) * 16;
+		size_t data_size = 0;
+		size_t data_alloc = file->buffers_size * 16;
 		byte *data_ptr = malloc(data_alloc);
 
+		if (!data_ptr)
+		{
+			rge_read_error = TRUE;
+
+			return;
+		}
+
 		do
 		{
-			temp_size = file_size;
-			temp_max = sizeof(buffers);
-			code = Inf32Decode(file_buffers, compression_point, &temp_size, buffers, 0, &temp_max, compression_buffers, TRUE);
-			compression_point += temp_size;
+			temp_size = file->file_size;
+			temp_max = file->buffers_size;
+
+			TRACE_BEGIN(TRACE_INFLATE);
+
+			code = file->inflater->decode(file->file_buffers, file->compression_point, &temp_size, file->buffers, 0, &temp_max, file->compression_buffers, TRUE);
+
+			TRACE_END(TRACE_INFLATE);
+
+			file->compression_point += temp_size;
 
 			if (data_size + temp_max > data_alloc)
 			{
 				size_t new_alloc = data_alloc * 2;
 				byte *new_data_ptr = malloc(new_alloc);
 
+				if (!new_data_ptr)
+				{
+					code = INFLATE_ERROR;
+
+					break;
+				}
+
 				memcpy(new_data_ptr, data_ptr, data_alloc);
 				rge_free(data_ptr);
 
@@ -214,11 +1067,13 @@ void rge_read_full(handle handle, void **data, int32 *size)
 				data_ptr = new_data_ptr;
 			}
 
-			memcpy(data_ptr + data_size, buffers, temp_max);
+			memcpy(data_ptr + data_size, file->buffers, temp_max);
 
 			data_size += temp_max;
 		}
-		while (code != INFLATE_EOF);
+		while (code == INFLATE_OK);
+
+		if (code == INFLATE_ERROR) rge_read_error = TRUE;
 
 		*data = data_ptr;
 		*size = data_size;
@@ -227,74 +1082,163 @@ void rge_read_full(handle handle, void **data, int32 *size)
 
 void rge_read(handle handle, void *data, int32 size)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
 	{
 		byte *temp = (byte *)data;
 
 		size_t temp_size;
-		size_t temp_max = sizeof(buffers);
+		size_t temp_max = file->buffers_size;
+
+		bool32 first_flag = file->flags == FLAG_FIRST_INFLATE;
 
-		if (flags == FLAG_FIRST_INFLATE)
+		// the input couldn't be read, so it reads as zeros, the same as past the end of the stream
+		if ((file->flags == FLAG_INFLATE && !file->compression_buffers) || (first_flag && !rge_start_inflate(handle)))
 		{
-			flags = FLAG_INFLATE;
+			memzero(data, size);
+
+			return;
+		}
+
+		if (first_flag)
+		{
+			temp_size = file->file_size;
+
+			TRACE_BEGIN(TRACE_INFLATE);
 
-			file_buffers = malloc(file_size);
-			_read(handle, file_buffers, file_size);
+			file->inflater->decode(file->file_buffers, file->compression_point, &temp_size, file->buffers, 0, &temp_max, file->compression_buffers, TRUE);
 
-			compression_buffers = calloc(Inf32BufSize(), 1);
-			compression_point = 0;
+			TRACE_END(TRACE_INFLATE);
 
-			temp_size = file_size;
-			Inf32Decode(file_buffers, compression_point, &temp_size, buffers, 0, &temp_max, compression_buffers, TRUE);
-			compression_point += temp_size;
+			file->compression_point += temp_size;
 		}
 
-		if (size + point >= sizeof(buffers))
+		if (size + file->point >= file->buffers_size)
 		{
 			do
 			{
-				memcpy(temp, current, sizeof(buffers) - point);
-				size -= sizeof(buffers) - point;
-				temp += sizeof(buffers) - point;
-				point = 0;
-				current = buffers;
-
-				temp_size = file_size;
-				temp_max = sizeof(buffers);
-				Inf32Decode(file_buffers, compression_point, &temp_size, buffers, 0, &temp_max, compression_buffers, TRUE);
-				compression_point += temp_size;
+				memcpy(temp, file->current, file->buffers_size - file->point);
+				size -= file->buffers_size - file->point;
+				temp += file->buffers_size - file->point;
+				file->point = 0;
+				file->current = file->buffers;
+
+				temp_size = file->file_size;
+				temp_max = file->buffers_size;
+
+				TRACE_BEGIN(TRACE_INFLATE);
+
+				file->inflater->decode(file->file_buffers, file->compression_point, &temp_size, file->buffers, 0, &temp_max, file->compression_buffers, TRUE);
+
+				TRACE_END(TRACE_INFLATE);
+
+				file->compression_point += temp_size;
 			}
-			while (size >= sizeof(buffers));
+			while (size >= file->buffers_size);
 		}
 
 		if (size > 0)
 		{
-			memcpy(temp, current, size);
-			point += size;
-			current += size;
+			memcpy(temp, file->current, size);
+			file->point += size;
+			file->current += size;
 		}
 	}
 }
 
-static int32 rge_buffer_full(byte *out_buf_ofs, int32 out_buf_size)
+int32 rge_read_chunk(handle handle, void *data, int32 size)
 {
-	rge_write_uncompressed(current_handle, out_buf_ofs, out_buf_size);
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle && (file->flags == FLAG_FIRST_INFLATE || file->flags == FLAG_INFLATE))
+	{
+		byte *temp = (byte *)data;
+		int32 num_read = 0;
+
+		size_t temp_size;
+		size_t temp_max;
+
+		if (file->flags == FLAG_INFLATE && !file->compression_buffers) return 0;
+
+		if (file->flags == FLAG_FIRST_INFLATE)
+		{
+			if (!rge_start_inflate(handle)) return 0;
+
+			file->point = file->buffered_size = 0;
+			file->inflate_code = INFLATE_OK;
+		}
+
+		while (num_read < size)
+		{
+			if (file->point == file->buffered_size)
+			{
+				if (file->inflate_code != INFLATE_OK) break;
+
+				temp_size = file->file_size;
+				temp_max = file->buffers_size;
+
+				TRACE_BEGIN(TRACE_INFLATE);
+
+				file->inflate_code = file->inflater->decode(file->file_buffers, file->compression_point, &temp_size, file->buffers, 0, &temp_max, file->compression_buffers, TRUE);
+
+				TRACE_END(TRACE_INFLATE);
+
+				file->compression_point += temp_size;
+
+				if (file->inflate_code == INFLATE_ERROR) rge_read_error = TRUE;
+
+				file->point = 0;
+				file->current = file->buffers;
+				file->buffered_size = temp_max;
+
+				continue;
+			}
+
+			int32 num_copy = (int32)min((size_t)(size - num_read), file->buffered_size - file->point);
+
+			memcpy(temp + num_read, file->current, num_copy);
+			num_read += num_copy;
+			file->point += num_copy;
+			file->current += num_copy;
+		}
+
+		return num_read;
+	}
 
 	return 0;
 }
 
+static int32 rge_buffer_full(byte *out_buf_ofs, int32 out_buf_size)
+{
+	rge_file *file = rge_get_file();
+
+	// a full buffer means there's more to come, from here on the deflate algo doesn't wait for the disk
+	if (!file->writer && !file->write_through && !file->output_error) rge_start_writer(file->current_handle);
+
+	rge_output(out_buf_ofs, out_buf_size);
+
+	// stops the deflate algo
+	return file->output_error;
+}
+
 void rge_write(handle handle, void *data, int32 size)
 {
-	if (handle != INVALID_HANDLE && handle == current_handle)
+	rge_file *file = rge_get_file();
+
+	if (handle != INVALID_HANDLE && handle == file->current_handle)
 	{
-		if (flags == FLAG_FIRST_DEFLATE)
+		if (file->flags == FLAG_FIRST_DEFLATE)
 		{
-			flags = FLAG_DEFLATE;
+			file->flags = FLAG_DEFLATE;
+
+			file->compression_buffers = rge_alloc_buffers(SPARE_WORK, file->backend->buf_size());
+			memzero(file->compression_buffers, file->backend->buf_size());
+			file->backend->init(file->compression_buffers, file->params.max_compares, file->params.strategy, file->params.greedy_flag, file->buffers, (int32)file->buffers_size, &rge_buffer_full);
 
-			compression_buffers = calloc(deflate_buf_size(), 1);
-			deflate_init(compression_buffers, DEFLATE_MAX_COMPARES_DEFAULT, DEFLATE_ALL_BLOCKS, TRUE, buffers, sizeof(buffers), &rge_buffer_full);
+			if (file->dictionary && file->backend->set_dictionary(file->compression_buffers, file->dictionary, file->dictionary_size) == DEFLATE_ERROR) rge_write_error = TRUE;
 		}
 
-		if (deflate_data(compression_buffers, (byte *)data, size, FALSE) == DEFLATE_ERROR) rge_write_error = TRUE;
+		if (file->backend->data(file->compression_buffers, (byte *)data, size, FALSE) == DEFLATE_ERROR) rge_write_error = TRUE;
 	}
 }
@@ -2,25 +2,87 @@
 
 #include "main.h"
 
-extern bool32 rge_write_error;
+extern thread_local bool32 rge_read_error; // per thread like the rest of the state
+extern thread_local bool32 rge_write_error;
 
-handle rge_fake_open_read(handle file_handle, int32 fake_size);
+handle rge_fake_open_read(handle file_handle, int32 fake_size); // fake_size bytes from where file_handle is, rge_fake_close leaves it open
+
+// or into the rge_open_read flags to inflate with zlib instead of the in-tree decoder
+#define RGE_O_INFLATE_FAST 0x00000000
+#define RGE_O_INFLATE_ZLIB 0x08000000
+#define RGE_O_INFLATE_MASK 0x08000000
+#define RGE_O_INFLATE_SHIFT 27
+#define RGE_O_INFLATE_PRESCAN 0x04000000 // rge_read_full walks the stream for its decompressed size first and allocates the output once
+
+#define RGE_O_IO_URING 0x01000000 // or into the rge_open_read/rge_open_write flags to do the file I/O through io_uring where the build and the kernel have it
+
+// bytes inflated or deflated per call and written at once, rge_set_window_size
+#define RGE_WINDOW_SIZE_MIN 0x1000
+#define RGE_WINDOW_SIZE_DEFAULT 0x10000
+#define RGE_WINDOW_SIZE_MAX 0x1000000
+
+#define RGE_STDIO_FILENAME "-" // stdin for rge_open_read, stdout for rge_open_write, a pipe is read until it ends
 
 #define rge_open_read_(filename) rge_open_read(filename, _O_BINARY) // easy open_read
 handle rge_open_read(char *filename, int32 flag);
+handle rge_open_read_handle(handle file_handle, int32 flag); // from where file_handle is, through a duplicate of it, the caller still closes file_handle
+
+// the stream at offset in a file, reading no more than length bytes of it, or all of the file after it with 0, with pread so the position of the file
+// doesn't move, rge_get_compressed_size after rge_close says how much of it the stream took up, so the next one in the same file starts after that
+handle rge_open_read_range(char *filename, size_t offset, size_t length, int32 flag);
+handle rge_open_read_range_handle(handle file_handle, size_t offset, size_t length, int32 flag); // the same through a duplicate of a file that's already open
+
+#define RGE_MEMORY_HANDLE 0x7FFFFFFF // what rge_open_read_memory and rge_open_write_memory return, not an actual file
+
+handle rge_open_read_memory(void *data, size_t size, int32 flag); // a compressed file that's already in memory, decoded straight from data, which has to stay valid until rge_close
+
+// pick the deflate backend by or'ing one of these into the rge_open_write flags
+#define RGE_O_DEFLATE_GAME 0x00000000 // game deflate, output is bit-exact with the game (default)
+#define RGE_O_DEFLATE_FAST 0x10000000 // zlib deflate, a lot faster but output differs from the game
+#define RGE_O_DEFLATE_BEST 0x20000000 // optimal parse deflate, smallest output but a lot slower and differs from the game
+#define RGE_O_DEFLATE_MASK 0x70000000
+#define RGE_O_DEFLATE_SHIFT 28
+
+// writing is always done behind the deflate algo on a thread of its own once the first window is full, rge_close waits for it and returns -1 if any write failed
+#define RGE_O_PIPELINED 0x02000000 // or into the rge_open_write flags to start that thread right away, so the uncompressed bytes go through it as well
+#define RGE_O_WRITE_THROUGH 0x00800000 // or into the rge_open_write flags to never start it, every write waits for the disk
 
 #define rge_open_write_(filename) rge_open_write(filename, _O_WRONLY | _O_APPEND | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE) // easy open_write
 handle rge_open_write(char *filename, int32 flag, int32 pmode);
+handle rge_open_write_handle(handle file_handle, int32 flag); // to where file_handle is, through a duplicate of it, the caller still closes file_handle
+handle rge_open_write_memory(void **data, size_t *size, int32 flag); // into memory that grows as needed, rge_close sets data and size to it and the caller frees it, also when it returns -1 because it ran out
 
 handle rge_fake_close(handle handle);
-int32 rge_close(handle handle);
+int32 rge_close(handle handle); // keeps the buffers of the file for the next one opened on the same thread
+void rge_free_thread_buffers(); // frees what rge_close kept, before a thread that opened files exits
+
+typedef struct rge_file rge_file;
+
+// every rge_* call works on the one file open on the calling thread, unless it switched to one of these, each holds a file of its own
+// so one thread can have several open at once and a file can move between threads, as long as only one thread uses it at a time
+rge_file *rge_file_new();
+void rge_file_free(rge_file *old_file); // after its file is closed
+rge_file *rge_file_switch(rge_file *new_file); // returns the one switched to before, NULL is back to the thread's own
+
+void rge_set_deflate_params(handle handle, int32 max_compares, int32 strategy, bool32 greedy_flag); // before the first rge_write, defaults are what the game uses
+void rge_set_dictionary(handle handle, void *dict, int32 dict_size); // before the first rge_read/rge_write, reading needs the dictionary the file was written with, the game can't read these
+void rge_set_window_size(handle handle, int32 window_size); // before the first rge_read/rge_write, how much is inflated or deflated per call and written at once, bigger is fewer calls and syscalls for more memory
+void rge_set_inflate_threads(handle handle, int32 num_threads); // before rge_read_full, more than 1 decodes the stream in parallel, only with the in-tree decoder and without RGE_O_INFLATE_PRESCAN
+
+typedef struct deflate_stats deflate_stats; // compress.h
+
+bool32 rge_get_deflate_stats(deflate_stats *stats); // of the last file rge_close'd on this thread, FALSE unless it was written with game deflate and that was built with RGE_DEFLATE_STATS
+size_t rge_get_compressed_size(); // of the last file rge_close'd on this thread, bytes written, or the bytes of the stream the inflate algo used up when reading
 
 void rge_fast_forward(handle handle, int32 size);
+int32 rge_tell(handle handle); // bytes read or written through the handle including the ones fast forwarded past, same as _tell but without asking the os, and it counts output that's still queued
 
 void rge_read_uncompressed(handle handle, void *data, int32 size);
 void rge_write_uncompressed(handle handle, void *data, int32 size);
 
-void rge_read_full(handle handle, void **data, int32 *size);
+void rge_read_full(handle handle, void **data, int32 *size); // more than INT32_MAX bytes is a read error, the first INT32_MAX of them are in data
+void rge_read_full_size(handle handle, void **data, size_t *size); // the same without that limit
 
 void rge_read(handle handle, void *data, int32 size);
+int32 rge_read_chunk(handle handle, void *data, int32 size); // instead of rge_read when the decompressed size isn't known, up to size bytes, returns 0 at the end of the stream
 void rge_write(handle handle, void *data, int32 size);
@@ -0,0 +1,408 @@
+#include "rge_fio_lib.h"
+#include "rge_fio.h"
+#include "compress.h"
+
+// the flags are passed on to rge_open_* as they are
+typedef char rge_fio_check_flags[RGE_FIO_DEFLATE_FAST == RGE_O_DEFLATE_FAST && RGE_FIO_DEFLATE_BEST == RGE_O_DEFLATE_BEST && RGE_FIO_INFLATE_ZLIB == RGE_O_INFLATE_ZLIB
+	&& RGE_FIO_INFLATE_PRESCAN == RGE_O_INFLATE_PRESCAN && RGE_FIO_IO_URING == RGE_O_IO_URING && RGE_FIO_PIPELINED == RGE_O_PIPELINED
+	&& RGE_FIO_WRITE_THROUGH == RGE_O_WRITE_THROUGH && RGE_FIO_STRATEGY_ALL == DEFLATE_ALL_BLOCKS && RGE_FIO_MAX_COMPARES_DEFAULT == DEFLATE_MAX_COMPARES_DEFAULT ? 1 : -1];
+
+#define RGE_FIO_READ_FLAGS (RGE_O_INFLATE_MASK | RGE_O_INFLATE_PRESCAN | RGE_O_IO_URING)
+#define RGE_FIO_WRITE_FLAGS (RGE_O_DEFLATE_MASK | RGE_O_IO_URING | RGE_O_PIPELINED | RGE_O_WRITE_THROUGH)
+
+// a file of its own, so streams don't get in each other's way or in the way of the thread's own file
+struct rge_fio_stream
+{
+	rge_file *file;
+	handle handle;
+	bool32 write_flag;
+	bool32 started; // read or written, too late to change the settings
+	int32 error; // the first one, every call after it returns it as well
+	uint64 uncompressed_size;
+};
+
+uint32_t rge_fio_version(void)
+{
+	return RGE_FIO_VERSION;
+}
+
+const char *rge_fio_error_string(int32_t error)
+{
+	switch (error)
+	{
+	case RGE_FIO_OK: return "ok";
+	case RGE_FIO_ERROR_PARAM: return "invalid parameter";
+	case RGE_FIO_ERROR_OPEN: return "couldn't open file";
+	case RGE_FIO_ERROR_MEMORY: return "out of memory";
+	case RGE_FIO_ERROR_DATA: return "invalid compressed data";
+	case RGE_FIO_ERROR_WRITE: return "couldn't write file";
+	}
+
+	return "unknown error";
+}
+
+static void rge_fio_free_stream(rge_fio_stream *stream)
+{
+	rge_file_free(stream->file);
+	free(stream);
+}
+
+// the new stream's file is the one the rge_* calls work on until rge_fio_end_open
+static rge_fio_stream *rge_fio_begin_open(bool32 write_flag, rge_file **old_file)
+{
+	rge_fio_stream *stream = calloc(1, sizeof(rge_fio_stream));
+
+	if (!stream) return NULL;
+
+	stream->file = rge_file_new();
+
+	if (!stream->file)
+	{
+		free(stream);
+
+		return NULL;
+	}
+
+	stream->write_flag = write_flag;
+
+	*old_file = rge_file_switch(stream->file);
+
+	return stream;
+}
+
+static int32 rge_fio_end_open(rge_fio_stream **stream, rge_fio_stream *new_stream, handle handle, rge_file *old_file)
+{
+	rge_file_switch(old_file);
+
+	if (handle == INVALID_HANDLE)
+	{
+		rge_fio_free_stream(new_stream);
+
+		*stream = NULL;
+
+		return RGE_FIO_ERROR_OPEN;
+	}
+
+	new_stream->handle = handle;
+
+	*stream = new_stream;
+
+	return RGE_FIO_OK;
+}
+
+int32_t rge_fio_open_read(rge_fio_stream **stream, const char *path, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || !path) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(FALSE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	return rge_fio_end_open(stream, new_stream, rge_open_read((char *)path, _O_BINARY | (flags & RGE_FIO_READ_FLAGS)), old_file);
+}
+
+int32_t rge_fio_open_read_fd(rge_fio_stream **stream, int fd, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || fd < 0) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(FALSE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	return rge_fio_end_open(stream, new_stream, rge_open_read_handle(fd, flags & RGE_FIO_READ_FLAGS), old_file);
+}
+
+int32_t rge_fio_open_read_range(rge_fio_stream **stream, const char *path, uint64_t offset, uint64_t length, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || !path || offset > SIZE_MAX || length > SIZE_MAX) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(FALSE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	return rge_fio_end_open(stream, new_stream, rge_open_read_range((char *)path, (size_t)offset, (size_t)length, _O_BINARY | (flags & RGE_FIO_READ_FLAGS)), old_file);
+}
+
+int32_t rge_fio_open_read_fd_range(rge_fio_stream **stream, int fd, uint64_t offset, uint64_t length, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || fd < 0 || offset > SIZE_MAX || length > SIZE_MAX) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(FALSE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	return rge_fio_end_open(stream, new_stream, rge_open_read_range_handle(fd, (size_t)offset, (size_t)length, flags & RGE_FIO_READ_FLAGS), old_file);
+}
+
+int32_t rge_fio_open_read_memory(rge_fio_stream **stream, const void *data, size_t size, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || (!data && size)) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(FALSE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	return rge_fio_end_open(stream, new_stream, rge_open_read_memory((void *)data, size, flags & RGE_FIO_READ_FLAGS), old_file);
+}
+
+int32_t rge_fio_open_write(rge_fio_stream **stream, const char *path, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || !path) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(TRUE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	handle handle = rge_open_write((char *)path, _O_WRONLY | _O_APPEND | _O_CREAT | _O_TRUNC | _O_BINARY | (flags & RGE_FIO_WRITE_FLAGS), _S_IREAD | _S_IWRITE);
+
+	return rge_fio_end_open(stream, new_stream, handle, old_file);
+}
+
+int32_t rge_fio_open_write_fd(rge_fio_stream **stream, int fd, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || fd < 0) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(TRUE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	return rge_fio_end_open(stream, new_stream, rge_open_write_handle(fd, flags & RGE_FIO_WRITE_FLAGS), old_file);
+}
+
+int32_t rge_fio_open_write_memory(rge_fio_stream **stream, void **data, size_t *size, int32_t flags)
+{
+	rge_file *old_file;
+
+	if (!stream || !data || !size) return RGE_FIO_ERROR_PARAM;
+
+	rge_fio_stream *new_stream = rge_fio_begin_open(TRUE, &old_file);
+
+	if (!new_stream) return RGE_FIO_ERROR_MEMORY;
+
+	return rge_fio_end_open(stream, new_stream, rge_open_write_memory(data, size, flags & RGE_FIO_WRITE_FLAGS), old_file);
+}
+
+int32_t rge_fio_set_deflate_params(rge_fio_stream *stream, int32_t max_compares, int32_t strategy, int32_t greedy)
+{
+	if (!stream || !stream->write_flag || stream->started) return RGE_FIO_ERROR_PARAM;
+	if (max_compares < DEFLATE_MIN_COMPARE || max_compares > DEFLATE_MAX_COMPARE) return RGE_FIO_ERROR_PARAM;
+	if (strategy < DEFLATE_STATIC_BLOCKS || strategy > DEFLATE_ALL_BLOCKS) return RGE_FIO_ERROR_PARAM;
+
+	rge_file *old_file = rge_file_switch(stream->file);
+
+	rge_set_deflate_params(stream->handle, max_compares, strategy, greedy != 0);
+
+	rge_file_switch(old_file);
+
+	return RGE_FIO_OK;
+}
+
+int32_t rge_fio_set_dictionary(rge_fio_stream *stream, const void *dict, int32_t dict_size)
+{
+	if (!stream || stream->started || dict_size < 0 || (!dict && dict_size)) return RGE_FIO_ERROR_PARAM;
+
+	rge_file *old_file = rge_file_switch(stream->file);
+
+	rge_set_dictionary(stream->handle, (void *)dict, dict_size);
+
+	rge_file_switch(old_file);
+
+	return RGE_FIO_OK;
+}
+
+int32_t rge_fio_set_window_size(rge_fio_stream *stream, int32_t window_size)
+{
+	if (!stream || stream->started || window_size < RGE_WINDOW_SIZE_MIN || window_size > RGE_WINDOW_SIZE_MAX) return RGE_FIO_ERROR_PARAM;
+
+	rge_file *old_file = rge_file_switch(stream->file);
+
+	rge_set_window_size(stream->handle, window_size);
+
+	rge_file_switch(old_file);
+
+	return RGE_FIO_OK;
+}
+
+int32_t rge_fio_read(rge_fio_stream *stream, void *data, int32_t size)
+{
+	if (!stream || stream->write_flag || size < 0 || (!data && size)) return RGE_FIO_ERROR_PARAM;
+	if (stream->error) return stream->error;
+
+	rge_file *old_file = rge_file_switch(stream->file);
+
+	rge_read_error = FALSE;
+
+	int32 num_read = rge_read_chunk(stream->handle, data, size);
+
+	if (rge_read_error) stream->error = RGE_FIO_ERROR_DATA;
+
+	rge_file_switch(old_file);
+
+	stream->started = TRUE;
+	stream->uncompressed_size += num_read;
+
+	return stream->error ? stream->error : num_read;
+}
+
+int32_t rge_fio_write(rge_fio_stream *stream, const void *data, int32_t size)
+{
+	if (!stream || !stream->write_flag || size < 0 || (!data && size)) return RGE_FIO_ERROR_PARAM;
+	if (stream->error) return stream->error;
+
+	rge_file *old_file = rge_file_switch(stream->file);
+
+	rge_write_error = FALSE;
+
+	rge_write(stream->handle, (void *)data, size);
+
+	if (rge_write_error) stream->error = RGE_FIO_ERROR_WRITE;
+
+	rge_file_switch(old_file);
+
+	stream->started = TRUE;
+	stream->uncompressed_size += size;
+
+	return stream->error;
+}
+
+int32_t rge_fio_close(rge_fio_stream *stream, rge_fio_stats *stats)
+{
+	if (!stream) return RGE_FIO_ERROR_PARAM;
+
+	rge_file *old_file = rge_file_switch(stream->file);
+
+	rge_read_error = FALSE;
+	rge_write_error = FALSE;
+
+	if (rge_close(stream->handle) && stream->write_flag && !stream->error) stream->error = RGE_FIO_ERROR_WRITE;
+	if (rge_write_error && !stream->error) stream->error = RGE_FIO_ERROR_WRITE;
+
+	rge_file_switch(old_file);
+
+	if (stats && stats->size)
+	{
+		rge_fio_stats full_stats = { 0 };
+		deflate_stats counted;
+
+		full_stats.size = stats->size;
+		full_stats.uncompressed_size = stream->uncompressed_size;
+		full_stats.compressed_size = rge_get_compressed_size();
+
+		if (stream->write_flag && rge_get_deflate_stats(&counted))
+		{
+			full_stats.deflate_stats = TRUE;
+			full_stats.literals = counted.literals;
+			full_stats.matches = counted.matches;
+			full_stats.match_bytes = counted.match_bytes;
+			full_stats.find_match_calls = counted.find_match_calls;
+			full_stats.chain_probes = counted.chain_probes;
+			full_stats.raw_blocks = counted.blocks[DEFLATE_STATS_RAW_BLOCK];
+			full_stats.static_blocks = counted.blocks[DEFLATE_STATS_STATIC_BLOCK];
+			full_stats.dynamic_blocks = counted.blocks[DEFLATE_STATS_DYNAMIC_BLOCK];
+		}
+
+		memcpy(stats, &full_stats, min((size_t)stats->size, sizeof(full_stats)));
+	}
+
+	int32 error = stream->error;
+
+	rge_fio_free_stream(stream);
+
+	return error;
+}
+
+int32_t rge_fio_compress(const void *src, size_t src_size, void **dst, size_t *dst_size, int32_t flags)
+{
+	rge_fio_stream *stream;
+
+	if (!dst || !dst_size || (!src && src_size)) return RGE_FIO_ERROR_PARAM;
+
+	int32 error = rge_fio_open_write_memory(&stream, dst, dst_size, flags & RGE_O_DEFLATE_MASK);
+
+	if (error) return error;
+
+	// the deflate algos take an int32 at a time, and even nothing is written so there's an empty stream
+	size_t pos = 0;
+
+	do
+	{
+		error = rge_fio_write(stream, (byte *)src + pos, (int32)min(src_size - pos, 0x40000000));
+
+		pos += 0x40000000;
+	}
+	while (pos < src_size && !error);
+
+	// the only thing that can go wrong writing to memory is running out of it
+	if (rge_fio_close(stream, NULL) || error)
+	{
+		rge_free(*dst);
+
+		*dst_size = 0;
+
+		return RGE_FIO_ERROR_MEMORY;
+	}
+
+	return RGE_FIO_OK;
+}
+
+int32_t rge_fio_decompress(const void *src, size_t src_size, void **dst, size_t *dst_size, int32_t flags)
+{
+	if (!dst || !dst_size || (!src && src_size)) return RGE_FIO_ERROR_PARAM;
+
+	rge_file *file = rge_file_new();
+
+	if (!file) return RGE_FIO_ERROR_MEMORY;
+
+	rge_file *old_file = rge_file_switch(file);
+
+	void *data = NULL;
+	size_t size = 0;
+	handle handle = rge_open_read_memory((void *)src, src_size, flags & RGE_FIO_READ_FLAGS);
+
+	rge_read_error = FALSE;
+
+	rge_read_full_size(handle, &data, &size);
+
+	bool32 read_error = rge_read_error;
+
+	rge_close(handle);
+
+	rge_file_switch(old_file);
+	rge_file_free(file);
+
+	if (read_error)
+	{
+		rge_free(data);
+
+		return RGE_FIO_ERROR_DATA;
+	}
+
+	*dst = data;
+	*dst_size = size;
+
+	return RGE_FIO_OK;
+}
+
+void rge_fio_free(void *data)
+{
+	free(data);
+}
+
+void rge_fio_free_thread(void)
+{
+	rge_free_thread_buffers();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// the C API of the rge_fio_static and rge_fio_shared libraries, it doesn't need main.h or anything else of rge_fio to be included,
+// within a major version it only ever gets more functions and flags, so a program built against an older header keeps working
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RGE_FIO_VERSION_MAJOR 1
+#define RGE_FIO_VERSION_MINOR 2
+#define RGE_FIO_VERSION_PATCH 0
+#define RGE_FIO_VERSION ((RGE_FIO_VERSION_MAJOR << 16) | (RGE_FIO_VERSION_MINOR << 8) | RGE_FIO_VERSION_PATCH)
+
+// RGE_FIO_BUILD while building the libraries, RGE_FIO_SHARED when building or using the shared one
+#if defined(_WIN32) && defined(RGE_FIO_SHARED)
+#ifdef RGE_FIO_BUILD
+#define RGE_FIO_API __declspec(dllexport)
+#else
+#define RGE_FIO_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__) && defined(RGE_FIO_BUILD)
+#define RGE_FIO_API __attribute__((visibility("default")))
+#else
+#define RGE_FIO_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// everything that can fail returns one of these, the calls that return a size return them as a negative size, a line about what went
+// wrong goes to stderr as well, the library never writes to stdout
+#define RGE_FIO_OK 0
+#define RGE_FIO_ERROR_PARAM -1 // NULL where there has to be something, or a call the stream doesn't allow, like reading one opened to write
+#define RGE_FIO_ERROR_OPEN -2
+#define RGE_FIO_ERROR_MEMORY -3
+#define RGE_FIO_ERROR_DATA -4 // the compressed data is broken or cut short
+#define RGE_FIO_ERROR_WRITE -5
+
+// or one of these into the flags of the calls that write, game deflate is bit-exact with the game
+#define RGE_FIO_DEFLATE_GAME 0x00000000
+#define RGE_FIO_DEFLATE_FAST 0x10000000 // zlib, a lot faster
+#define RGE_FIO_DEFLATE_BEST 0x20000000 // optimal parse, smallest and a lot slower
+
+// and one of these into the flags of the calls that read
+#define RGE_FIO_INFLATE_FAST 0x00000000
+#define RGE_FIO_INFLATE_ZLIB 0x08000000
+#define RGE_FIO_INFLATE_PRESCAN 0x04000000 // rge_fio_decompress walks the stream for its size first and allocates the output once
+
+#define RGE_FIO_IO_URING 0x01000000 // file I/O through io_uring where the build and the kernel have it, paths only
+#define RGE_FIO_PIPELINED 0x02000000 // writes go through a thread of their own from the start instead of once the first window is full
+#define RGE_FIO_WRITE_THROUGH 0x00800000 // never start that thread
+
+// rge_fio_set_deflate_params
+#define RGE_FIO_STRATEGY_STATIC 0
+#define RGE_FIO_STRATEGY_DYNAMIC 1
+#define RGE_FIO_STRATEGY_ALL 2 // what the game uses
+
+#define RGE_FIO_MAX_COMPARES_DEFAULT 75 // what the game uses, 1 to 1500
+
+typedef struct rge_fio_stream rge_fio_stream;
+
+typedef struct rge_fio_stats rge_fio_stats;
+
+// the caller sets size to sizeof(rge_fio_stats), newer versions only fill in as much of it as that has room for
+struct rge_fio_stats
+{
+	uint32_t size;
+	int32_t deflate_stats; // the rest after the sizes is counted, only game deflate built with premake --deflate-stats does that
+	uint64_t uncompressed_size; // read or written through the stream
+	uint64_t compressed_size; // written, or used up by inflate, which is less than the file when there's something after the stream
+	uint64_t literals;
+	uint64_t matches;
+	uint64_t match_bytes;
+	uint64_t find_match_calls;
+	uint64_t chain_probes;
+	uint64_t raw_blocks;
+	uint64_t static_blocks;
+	uint64_t dynamic_blocks;
+};
+
+RGE_FIO_API uint32_t rge_fio_version(void); // RGE_FIO_VERSION of the library, its major has to be the same as the header's
+RGE_FIO_API const char *rge_fio_error_string(int32_t error);
+
+// a stream can be used from any thread, but only from one at a time, any number of them can be open at once
+RGE_FIO_API int32_t rge_fio_open_read(rge_fio_stream **stream, const char *path, int32_t flags);
+RGE_FIO_API int32_t rge_fio_open_read_fd(rge_fio_stream **stream, int fd, int32_t flags); // from where fd is, the caller still closes fd
+RGE_FIO_API int32_t rge_fio_open_read_range(rge_fio_stream **stream, const char *path, uint64_t offset, uint64_t length, int32_t flags); // the stream at offset, read no further than length, 0 for the end of the file
+RGE_FIO_API int32_t rge_fio_open_read_fd_range(rge_fio_stream **stream, int fd, uint64_t offset, uint64_t length, int32_t flags); // the same without moving the position of fd, the compressed_size rge_fio_close returns is where the next stream starts
+RGE_FIO_API int32_t rge_fio_open_read_memory(rge_fio_stream **stream, const void *data, size_t size, int32_t flags); // data has to stay valid until rge_fio_close
+RGE_FIO_API int32_t rge_fio_open_write(rge_fio_stream **stream, const char *path, int32_t flags);
+RGE_FIO_API int32_t rge_fio_open_write_fd(rge_fio_stream **stream, int fd, int32_t flags); // to where fd is, the caller still closes fd
+RGE_FIO_API int32_t rge_fio_open_write_memory(rge_fio_stream **stream, void **data, size_t *size, int32_t flags); // rge_fio_close sets data and size, freed with rge_fio_free
+
+// before the first rge_fio_read or rge_fio_write
+RGE_FIO_API int32_t rge_fio_set_deflate_params(rge_fio_stream *stream, int32_t max_compares, int32_t strategy, int32_t greedy);
+RGE_FIO_API int32_t rge_fio_set_dictionary(rge_fio_stream *stream, const void *dict, int32_t dict_size); // has to stay valid until rge_fio_close
+RGE_FIO_API int32_t rge_fio_set_window_size(rge_fio_stream *stream, int32_t window_size); // 4 KiB to 16 MiB, 64 KiB by default
+
+RGE_FIO_API int32_t rge_fio_read(rge_fio_stream *stream, void *data, int32_t size); // bytes read, less than size only at the end of the stream
+RGE_FIO_API int32_t rge_fio_write(rge_fio_stream *stream, const void *data, int32_t size);
+RGE_FIO_API int32_t rge_fio_close(rge_fio_stream *stream, rge_fio_stats *stats); // stats can be NULL, the stream is freed either way
+
+// the whole input at once, *dst is allocated by the library and freed with rge_fio_free
+RGE_FIO_API int32_t rge_fio_compress(const void *src, size_t src_size, void **dst, size_t *dst_size, int32_t flags);
+RGE_FIO_API int32_t rge_fio_decompress(const void *src, size_t src_size, void **dst, size_t *dst_size, int32_t flags);
+RGE_FIO_API void rge_fio_free(void *data);
+
+RGE_FIO_API void rge_fio_free_thread(void); // before a thread that used the library exits, it keeps buffers around for the next stream
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,206 @@
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <time.h>
+#endif
+
+#include "thread.h"
+
+#ifdef _WIN32
+local uint32 __stdcall rge_thread_start(void *arg)
+{
+	rge_thread *thread = (rge_thread *)arg;
+
+	thread->func(thread->arg);
+
+	return 0;
+}
+
+bool32 rge_thread_create(rge_thread *thread, void (*func)(void *), void *arg)
+{
+	thread->func = func;
+	thread->arg = arg;
+	thread->thread = (HANDLE)_beginthreadex(NULL, 0, rge_thread_start, thread, 0, NULL);
+
+	return thread->thread != NULL;
+}
+
+void rge_thread_join(rge_thread *thread)
+{
+	WaitForSingleObject(thread->thread, INFINITE);
+	CloseHandle(thread->thread);
+}
+
+int32 rge_num_cpus()
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	return max(1, (int32)info.dwNumberOfProcessors);
+}
+
+uint64 rge_time_ns()
+{
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+
+	return (uint64)(counter.QuadPart / frequency.QuadPart) * 1000000000 + (uint64)(counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+}
+
+void rge_mutex_init(rge_mutex *mutex)
+{
+	InitializeCriticalSection(mutex);
+}
+
+void rge_mutex_lock(rge_mutex *mutex)
+{
+	EnterCriticalSection(mutex);
+}
+
+void rge_mutex_unlock(rge_mutex *mutex)
+{
+	LeaveCriticalSection(mutex);
+}
+
+void rge_mutex_destroy(rge_mutex *mutex)
+{
+	DeleteCriticalSection(mutex);
+}
+
+bool32 rge_sem_init(rge_sem *sem, int32 count)
+{
+	*sem = CreateSemaphoreA(NULL, count, 0x7FFFFFFF, NULL);
+
+	return *sem != NULL;
+}
+
+void rge_sem_wait(rge_sem *sem)
+{
+	WaitForSingleObject(*sem, INFINITE);
+}
+
+void rge_sem_post(rge_sem *sem)
+{
+	ReleaseSemaphore(*sem, 1, NULL);
+}
+
+void rge_sem_destroy(rge_sem *sem)
+{
+	CloseHandle(*sem);
+}
+
+int32 rge_atomic_inc(volatile int32 *value)
+{
+	return InterlockedIncrement((volatile LONG *)value);
+}
+#else
+local void *rge_thread_start(void *arg)
+{
+	rge_thread *thread = (rge_thread *)arg;
+
+	thread->func(thread->arg);
+
+	return NULL;
+}
+
+bool32 rge_thread_create(rge_thread *thread, void (*func)(void *), void *arg)
+{
+	thread->func = func;
+	thread->arg = arg;
+
+	return !pthread_create(&thread->thread, NULL, rge_thread_start, thread);
+}
+
+void rge_thread_join(rge_thread *thread)
+{
+	pthread_join(thread->thread, NULL);
+}
+
+int32 rge_num_cpus()
+{
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return num_cpus > 0 ? (int32)num_cpus : 1;
+}
+
+uint64 rge_time_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void rge_mutex_init(rge_mutex *mutex)
+{
+	pthread_mutex_init(mutex, NULL);
+}
+
+void rge_mutex_lock(rge_mutex *mutex)
+{
+	pthread_mutex_lock(mutex);
+}
+
+void rge_mutex_unlock(rge_mutex *mutex)
+{
+	pthread_mutex_unlock(mutex);
+}
+
+void rge_mutex_destroy(rge_mutex *mutex)
+{
+	pthread_mutex_destroy(mutex);
+}
+
+bool32 rge_sem_init(rge_sem *sem, int32 count)
+{
+	sem->count = count;
+
+	if (pthread_mutex_init(&sem->mutex, NULL)) return FALSE;
+
+	if (pthread_cond_init(&sem->cond, NULL))
+	{
+		pthread_mutex_destroy(&sem->mutex);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+void rge_sem_wait(rge_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+
+	while (!sem->count) pthread_cond_wait(&sem->cond, &sem->mutex);
+
+	sem->count--;
+
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+void rge_sem_post(rge_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+
+	sem->count++;
+
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+void rge_sem_destroy(rge_sem *sem)
+{
+	pthread_cond_destroy(&sem->cond);
+	pthread_mutex_destroy(&sem->mutex);
+}
+
+int32 rge_atomic_inc(volatile int32 *value)
+{
+	return __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+}
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "main.h"
+
+typedef struct rge_thread rge_thread;
+
+struct rge_thread
+{
+#ifdef _WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+	void (*func)(void *);
+	void *arg;
+};
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION rge_mutex;
+typedef HANDLE rge_sem;
+#else
+typedef pthread_mutex_t rge_mutex;
+typedef struct rge_sem rge_sem;
+
+// unnamed posix semaphores don't exist on macOS
+struct rge_sem
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int32 count;
+};
+#endif
+
+bool32 rge_thread_create(rge_thread *thread, void (*func)(void *), void *arg); // thread must stay valid until rge_thread_join
+void rge_thread_join(rge_thread *thread);
+int32 rge_num_cpus();
+uint64 rge_time_ns(); // monotonic, for timing
+
+void rge_mutex_init(rge_mutex *mutex);
+void rge_mutex_lock(rge_mutex *mutex);
+void rge_mutex_unlock(rge_mutex *mutex);
+void rge_mutex_destroy(rge_mutex *mutex);
+
+// counting semaphores, condition variables need Vista
+bool32 rge_sem_init(rge_sem *sem, int32 count); // rge_sem_destroy only after it succeeded
+void rge_sem_wait(rge_sem *sem);
+void rge_sem_post(rge_sem *sem);
+void rge_sem_destroy(rge_sem *sem);
+
+int32 rge_atomic_inc(volatile int32 *value); // returns the incremented value
@@ -0,0 +1,262 @@
+#include "trace.h"
+
+typedef struct trace_event trace_event;
+
+struct trace_event
+{
+	char *name; // file name for TRACE_FILE, copied as the caller's may be gone by the time the json is written
+	int32 phase;
+	uint64 start;
+	uint64 duration;
+};
+
+typedef struct trace_thread trace_thread;
+
+struct trace_thread
+{
+	int32 id;
+	uint64 self_ns[TRACE_NUM_PHASES];
+	uint64 calls[TRACE_NUM_PHASES];
+	int32 stack[TRACE_MAX_DEPTH];
+	uint64 stack_start[TRACE_MAX_DEPTH];
+	char *stack_name[TRACE_MAX_DEPTH];
+	int32 depth;
+	uint64 last; // when time was last charged to the phase on top
+	trace_event *events;
+	int32 num_events;
+	int32 max_events;
+	int32 num_dropped;
+	trace_thread *next;
+};
+
+local char *phase_names[TRACE_NUM_PHASES] =
+{
+	"file", "open", "close", "read", "write", "inflate", "hash", "delete", "search", "dynamic_block", "code_block", "flush"
+};
+
+bool32 trace_enabled = FALSE;
+
+local bool32 keep_events = FALSE;
+local uint64 start_time = 0;
+local rge_mutex threads_mutex;
+local trace_thread *threads = NULL; // outlive their threads, so the summary sees the ones batch already joined
+local int32 num_threads = 0;
+local thread_local trace_thread *current_thread = NULL;
+
+local trace_thread *trace_get_thread()
+{
+	if (!current_thread)
+	{
+		current_thread = calloc(1, sizeof(trace_thread));
+
+		if (!current_thread) return NULL;
+
+		rge_mutex_lock(&threads_mutex);
+
+		current_thread->id = ++num_threads;
+		current_thread->next = threads;
+		threads = current_thread;
+
+		rge_mutex_unlock(&threads_mutex);
+	}
+
+	return current_thread;
+}
+
+local void trace_add_event(trace_thread *thread, int32 phase, char *name, uint64 start, uint64 end)
+{
+	if (thread->num_events == thread->max_events)
+	{
+		int32 max_events = thread->max_events ? thread->max_events * 2 : 0x1000;
+		trace_event *events = max_events <= TRACE_MAX_EVENTS ? realloc(thread->events, max_events * sizeof(trace_event)) : NULL;
+
+		if (!events)
+		{
+			thread->num_dropped++;
+
+			rge_free(name);
+
+			return;
+		}
+
+		thread->events = events;
+		thread->max_events = max_events;
+	}
+
+	trace_event *event = &thread->events[thread->num_events++];
+
+	event->name = name;
+	event->phase = phase;
+	event->start = start - start_time;
+	event->duration = end - start;
+}
+
+void trace_start(bool32 events)
+{
+	rge_mutex_init(&threads_mutex);
+
+	keep_events = events;
+	start_time = rge_time_ns();
+	trace_enabled = TRUE;
+}
+
+void trace_begin(int32 phase, char *name)
+{
+	trace_thread *thread = trace_get_thread();
+
+	if (!thread) return;
+
+	uint64 now = rge_time_ns();
+
+	if (thread->depth) thread->self_ns[thread->stack[thread->depth - 1]] += now - thread->last;
+
+	thread->last = now;
+
+	// too deep can't happen with the phases there are, but then it's simply counted to the outer one
+	if (thread->depth == TRACE_MAX_DEPTH) return;
+
+	thread->stack[thread->depth] = phase;
+	thread->stack_start[thread->depth] = now;
+	thread->stack_name[thread->depth] = name && keep_events ? strdup(name) : NULL;
+	thread->depth++;
+}
+
+void trace_end(int32 phase)
+{
+	trace_thread *thread = current_thread;
+	bool32 found = FALSE;
+
+	if (!thread) return;
+
+	for (int32 i = 0; i < thread->depth; i++)
+	{
+		if (thread->stack[i] == phase) found = TRUE;
+	}
+
+	if (!found) return;
+
+	uint64 now = rge_time_ns();
+
+	for (found = FALSE; !found; thread->depth--)
+	{
+		int32 top = thread->depth - 1;
+
+		found = thread->stack[top] == phase;
+
+		thread->self_ns[thread->stack[top]] += now - thread->last;
+		thread->calls[thread->stack[top]]++;
+		thread->last = now;
+
+		if (keep_events) trace_add_event(thread, thread->stack[top], thread->stack_name[top], thread->stack_start[top], now);
+	}
+}
+
+void trace_print_summary(FILE *out)
+{
+	uint64 self_ns[TRACE_NUM_PHASES] = ZEROMEM;
+	uint64 calls[TRACE_NUM_PHASES] = ZEROMEM;
+	uint64 total_ns = 0;
+	int32 num_dropped = 0;
+
+	for (trace_thread *thread = threads; thread; thread = thread->next)
+	{
+		for (int32 i = 0; i < TRACE_NUM_PHASES; i++)
+		{
+			self_ns[i] += thread->self_ns[i];
+			calls[i] += thread->calls[i];
+			total_ns += thread->self_ns[i];
+		}
+
+		num_dropped += thread->num_dropped;
+	}
+
+	// time on all threads together, so with several threads it adds up to more than the wall clock
+	fprintf(out, "phase               calls          ms       %%\n");
+
+	for (int32 i = 0; i < TRACE_NUM_PHASES; i++)
+	{
+		fprintf(out, "%-13s %11llu %11.3f %7.2f\n", phase_names[i], (unsigned long long)calls[i], self_ns[i] / 1000000.0, total_ns ? self_ns[i] * 100.0 / total_ns : 0.0);
+	}
+
+	fprintf(out, "%-13s %11s %11.3f %7.2f\n", "total", "", total_ns / 1000000.0, 100.0);
+	fprintf(out, "on %d threads in %.3f ms\n", num_threads, (rge_time_ns() - start_time) / 1000000.0);
+
+	if (num_dropped) fprintf(out, "%d events didn't fit into the trace, the summary has them\n", num_dropped);
+}
+
+local void trace_write_string(FILE *out, char *str)
+{
+	fputc('"', out);
+
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\') fputc('\\', out);
+
+		if ((byte)*str < 0x20) fprintf(out, "\\u%04x", (byte)*str);
+		else fputc(*str, out);
+	}
+
+	fputc('"', out);
+}
+
+bool32 trace_write_json(char *filename)
+{
+	FILE *out = rge_fopen(filename, "wb");
+
+	if (!out) return FALSE;
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"rge_fio\"}}");
+
+	for (trace_thread *thread = threads; thread; thread = thread->next)
+	{
+		fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", thread->id, thread->id);
+
+		for (int32 i = 0; i < thread->num_events; i++)
+		{
+			trace_event *event = &thread->events[i];
+
+			fprintf(out, ",\n{\"name\":");
+			trace_write_string(out, event->name ? event->name : phase_names[event->phase]);
+			fprintf(out, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}", phase_names[event->phase], event->start / 1000.0, event->duration / 1000.0, thread->id);
+		}
+	}
+
+	fprintf(out, "\n]}\n");
+
+	bool32 error = ferror(out) != 0;
+
+	rge_fclose(out);
+
+	return !error;
+}
+
+void trace_stop()
+{
+	trace_enabled = FALSE;
+
+	while (threads)
+	{
+		trace_thread *thread = threads;
+
+		threads = thread->next;
+
+		for (int32 i = 0; i < thread->num_events; i++)
+		{
+			rge_free(thread->events[i].name);
+		}
+
+		for (int32 i = 0; i < thread->depth; i++)
+		{
+			rge_free(thread->stack_name[i]);
+		}
+
+		rge_free(thread->events);
+		rge_free(thread);
+	}
+
+	num_threads = 0;
+	current_thread = NULL;
+
+	rge_mutex_destroy(&threads_mutex);
+}
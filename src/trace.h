@@ -0,0 +1,33 @@
+#pragma once
+
+#include "thread.h"
+
+#define TRACE_FILE 0 // from opening a file to closing it, what's left when the phases below are taken out
+#define TRACE_OPEN 1
+#define TRACE_CLOSE 2
+#define TRACE_READ 3
+#define TRACE_WRITE 4
+#define TRACE_INFLATE 5
+#define TRACE_HASH 6
+#define TRACE_DELETE 7
+#define TRACE_SEARCH 8
+#define TRACE_DYNAMIC_BLOCK 9
+#define TRACE_CODE_BLOCK 10
+#define TRACE_FLUSH 11
+#define TRACE_NUM_PHASES 12
+
+#define TRACE_MAX_DEPTH 16
+#define TRACE_MAX_EVENTS 0x100000 // per thread, the rest only goes into the summary
+
+// only a flag check while tracing is off, so it stays in every build
+#define TRACE_BEGIN(phase) do { if (trace_enabled) trace_begin(phase, NULL); } while(0)
+#define TRACE_END(phase) do { if (trace_enabled) trace_end(phase); } while(0)
+
+extern bool32 trace_enabled;
+
+void trace_start(bool32 keep_events); // before any threads are started, keep_events for trace_write_json
+void trace_begin(int32 phase, char *name); // phases nest, the time of the inner one is taken out of the outer one
+void trace_end(int32 phase); // also ends the phases begun inside it and left open by an error
+void trace_print_summary(FILE *out);
+bool32 trace_write_json(char *filename); // chrome://tracing and Perfetto, a row per thread with the files on it
+void trace_stop(); // after all threads are joined